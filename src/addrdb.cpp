@@ -32,13 +32,15 @@ class DbNotFoundError : public std::exception
 };
 
 template <typename Stream, typename Data>
-bool SerializeDB(Stream& stream, const Data& data)
+bool SerializeDB(Stream& stream, const Data& data, uint256* checksum = nullptr)
 {
     // Write and commit header, data
     try {
         HashedSourceWriter hashwriter{stream};
         hashwriter << Params().MessageStart() << data;
-        stream << hashwriter.GetHash();
+        const uint256 hash{hashwriter.GetHash()};
+        stream << hash;
+        if (checksum) *checksum = hash;
     } catch (const std::exception& e) {
         return error("%s: Serialize or I/O error - %s", __func__, e.what());
     }
@@ -47,7 +49,7 @@ bool SerializeDB(Stream& stream, const Data& data)
 }
 
 template <typename Data>
-bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data& data)
+bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data& data, uint256* checksum = nullptr)
 {
     // Generate random temporary filename
     const uint16_t randv{GetRand<uint16_t>()};
@@ -64,7 +66,7 @@ bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data
     }
 
     // Serialize
-    if (!SerializeDB(fileout, data)) {
+    if (!SerializeDB(fileout, data, checksum)) {
         fileout.fclose();
         remove(pathTmp);
         return false;
@@ -86,7 +88,7 @@ bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data
 }
 
 template <typename Stream, typename Data>
-void DeserializeDB(Stream& stream, Data&& data, bool fCheckSum = true)
+void DeserializeDB(Stream& stream, Data&& data, bool fCheckSum = true, uint256* checksum = nullptr)
 {
     HashVerifier verifier{stream};
     // de-serialize file header (network specific magic number) and ..
@@ -107,18 +109,131 @@ void DeserializeDB(Stream& stream, Data&& data, bool fCheckSum = true)
         if (hashTmp != verifier.GetHash()) {
             throw std::runtime_error{"Checksum mismatch, data corrupted"};
         }
+        if (checksum) *checksum = hashTmp;
     }
 }
 
 template <typename Data>
-void DeserializeFileDB(const fs::path& path, Data&& data)
+void DeserializeFileDB(const fs::path& path, Data&& data, uint256* checksum = nullptr)
 {
     FILE* file = fsbridge::fopen(path, "rb");
     AutoFile filein{file};
     if (filein.IsNull()) {
         throw DbNotFoundError{};
     }
-    DeserializeDB(filein, data);
+    DeserializeDB(filein, data, /*fCheckSum=*/true, checksum);
+}
+
+/**
+ * peers.journal holds the changes made to addrman since peers.dat was
+ * written. It starts with a header identifying the peers.dat it applies to,
+ * followed by any number of records appended by DumpPeerAddresses(). Each
+ * record is written as a length-prefixed AddrMan::SerializeJournal() payload
+ * and its hash, so that a record torn by a crash is detected and ignored
+ * along with everything after it.
+ */
+constexpr uint8_t PEERS_JOURNAL_VERSION{1};
+/** Rewrite peers.dat once the journal reaches this fraction of its size */
+constexpr uintmax_t PEERS_JOURNAL_COMPACT_RATIO{2};
+
+fs::path PeersJournalPath(const ArgsManager& args)
+{
+    return args.GetDataDirNet() / "peers.journal";
+}
+
+bool CreatePeersJournal(const fs::path& path, const uint256& base_checksum)
+{
+    AutoFile file{fsbridge::fopen(path, "wb")};
+    if (file.IsNull()) {
+        return error("%s: Failed to open file %s", __func__, fs::PathToString(path));
+    }
+    try {
+        file << Params().MessageStart() << PEERS_JOURNAL_VERSION << base_checksum;
+    } catch (const std::exception& e) {
+        return error("%s: I/O error - %s", __func__, e.what());
+    }
+    if (!FileCommit(file.Get())) {
+        return error("%s: Failed to flush file %s", __func__, fs::PathToString(path));
+    }
+    return true;
+}
+
+bool AppendPeersJournal(const fs::path& path, const AddrMan& addr)
+{
+    DataStream record{};
+    if (addr.SerializeJournal(record) == 0) return true;
+
+    AutoFile file{fsbridge::fopen(path, "ab")};
+    if (file.IsNull()) {
+        return error("%s: Failed to open file %s", __func__, fs::PathToString(path));
+    }
+    try {
+        WriteCompactSize(file, record.size());
+        file << Span{record} << Hash(record);
+    } catch (const std::exception& e) {
+        return error("%s: I/O error - %s", __func__, e.what());
+    }
+    if (!FileCommit(file.Get())) {
+        return error("%s: Failed to flush file %s", __func__, fs::PathToString(path));
+    }
+    return true;
+}
+
+/**
+ * Apply the records in peers.journal to an addrman that was just loaded from
+ * the peers.dat with the given checksum. A journal that belongs to another
+ * peers.dat, or that ends in a torn record, is removed after use so that
+ * the next DumpPeerAddresses() rewrites peers.dat.
+ *
+ * Records that don't apply, e.g. because peers.dat was rebucketed for a
+ * different asmap, fail addrman's consistency check.
+ *
+ * @returns the number of records applied. Throws if a record doesn't apply.
+ */
+size_t ReplayPeersJournal(const fs::path& path, AddrMan& addr, const uint256& base_checksum)
+{
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    if (file.IsNull()) return 0;
+    const auto file_size{fs::file_size(path)};
+
+    try {
+        MessageStartChars message_start;
+        uint8_t version;
+        uint256 journal_base_checksum;
+        file >> message_start >> version >> journal_base_checksum;
+        if (message_start != Params().MessageStart() || version != PEERS_JOURNAL_VERSION ||
+            journal_base_checksum != base_checksum) {
+            throw std::ios_base::failure{"journal does not belong to the loaded peers.dat"};
+        }
+    } catch (const std::ios_base::failure& e) {
+        LogPrintf("Ignoring %s: %s\n", fs::quoted(fs::PathToString(path)), e.what());
+        file.fclose();
+        fs::remove(path);
+        return 0;
+    }
+
+    size_t num_records{0};
+    while (std::ftell(file.Get()) != static_cast<long>(file_size)) {
+        std::vector<std::byte> record;
+        uint256 hash;
+        try {
+            file >> record >> hash;
+        } catch (const std::ios_base::failure&) {
+            hash.SetNull();
+        }
+        if (hash.IsNull() || Hash(record) != hash) {
+            LogPrintf("Ignoring incomplete record at the end of %s\n", fs::quoted(fs::PathToString(path)));
+            file.fclose();
+            fs::remove(path);
+            break;
+        }
+        // Errors applying a record are passed on, as they leave addrman in
+        // an unknown state.
+        DataStream stream{record};
+        addr.UnserializeJournal(stream);
+        ++num_records;
+    }
+    return num_records;
 }
 } // namespace
 
@@ -174,7 +289,28 @@ bool CBanDB::Read(banmap_t& banSet)
 bool DumpPeerAddresses(const ArgsManager& args, const AddrMan& addr)
 {
     const auto pathAddr = args.GetDataDirNet() / "peers.dat";
-    return SerializeFileDB("peers", pathAddr, addr);
+    const auto path_journal{PeersJournalPath(args)};
+    const bool use_journal{args.GetBoolArg("-peersjournal", DEFAULT_PEERS_JOURNAL)};
+
+    // Append the changes to the journal while it is small compared to
+    // peers.dat. A missing journal means that peers.dat needs to be
+    // rewritten first.
+    if (use_journal && fs::exists(path_journal) && fs::exists(pathAddr) &&
+        fs::file_size(path_journal) < fs::file_size(pathAddr) / PEERS_JOURNAL_COMPACT_RATIO) {
+        if (AppendPeersJournal(path_journal, addr)) return true;
+        LogPrintf("Failed to append to %s, rewriting peers.dat\n", fs::quoted(fs::PathToString(path_journal)));
+    }
+
+    uint256 checksum;
+    if (!SerializeFileDB("peers", pathAddr, addr, &checksum)) {
+        // The journal may no longer match the in-memory changes tracking.
+        fs::remove(path_journal);
+        return false;
+    }
+    if (!use_journal || !CreatePeersJournal(path_journal, checksum)) {
+        fs::remove(path_journal);
+    }
+    return true;
 }
 
 void ReadFromStream(AddrMan& addr, DataStream& ssPeers)
@@ -189,9 +325,20 @@ util::Result<std::unique_ptr<AddrMan>> LoadAddrman(const NetGroupManager& netgro
 
     const auto start{SteadyClock::now()};
     const auto path_addr{args.GetDataDirNet() / "peers.dat"};
+    const auto path_journal{PeersJournalPath(args)};
     try {
-        DeserializeFileDB(path_addr, *addrman);
-        LogPrintf("Loaded %i addresses from peers.dat  %dms\n", addrman->Size(), Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+        uint256 checksum;
+        DeserializeFileDB(path_addr, *addrman, &checksum);
+        size_t num_records{0};
+        try {
+            num_records = ReplayPeersJournal(path_journal, *addrman, checksum);
+        } catch (const std::exception& e) {
+            LogPrintf("Discarding %s: %s\n", fs::quoted(fs::PathToString(path_journal)), e.what());
+            fs::remove(path_journal);
+            addrman = std::make_unique<AddrMan>(netgroupman, /*deterministic=*/false, /*consistency_check_ratio=*/check_addrman);
+            DeserializeFileDB(path_addr, *addrman);
+        }
+        LogPrintf("Loaded %i addresses from peers.dat and %i records from peers.journal  %dms\n", addrman->Size(), num_records, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
     } catch (const DbNotFoundError&) {
         // Addrman can be in an inconsistent state after failure, reset it
         addrman = std::make_unique<AddrMan>(netgroupman, /*deterministic=*/false, /*consistency_check_ratio=*/check_addrman);
@@ -19,9 +19,17 @@ class CAddress;
 class DataStream;
 class NetGroupManager;
 
+/** Default for -peersjournal */
+static constexpr bool DEFAULT_PEERS_JOURNAL{false};
+
 /** Only used by tests. */
 void ReadFromStream(AddrMan& addr, DataStream& ssPeers);
 
+/**
+ * Persist addrman. With -peersjournal, the changes since the last call are
+ * appended to peers.journal, and peers.dat is only rewritten once the
+ * journal has grown large.
+ */
 bool DumpPeerAddresses(const ArgsManager& args, const AddrMan& addr);
 
 /** Access to the banlist database (banlist.json) */
@@ -223,6 +223,10 @@ void AddrManImpl::Serialize(Stream& s_) const
     // Store asmap checksum after bucket entries so that it
     // can be ignored by older clients for backward compatibility.
     s << m_netgroupman.GetAsmapChecksum();
+
+    // Journal records are relative to the state serialized here.
+    m_journal_changed.clear();
+    m_journal_removed.clear();
 }
 
 template <typename Stream>
@@ -285,6 +289,7 @@ void AddrManImpl::Unserialize(Stream& s_)
         info.nRandomPos = vRandom.size();
         vRandom.push_back(n);
         m_network_counts[info.GetNetwork()].n_new++;
+        AddToNetworkIndex(n, info);
     }
     nIdCount = nNew;
 
@@ -300,11 +305,12 @@ void AddrManImpl::Unserialize(Stream& s_)
             info.nRandomPos = vRandom.size();
             info.fInTried = true;
             vRandom.push_back(nIdCount);
-            mapInfo[nIdCount] = info;
+            AddrInfo& tried_info = mapInfo[nIdCount] = info;
             mapAddr[info] = nIdCount;
             vvTried[nKBucket][nKBucketPos] = nIdCount;
-            nIdCount++;
             m_network_counts[info.GetNetwork()].n_tried++;
+            AddToNetworkIndex(nIdCount, tried_info);
+            nIdCount++;
         } else {
             nLost++;
         }
@@ -394,6 +400,145 @@ void AddrManImpl::Unserialize(Stream& s_)
             "Corrupt data. Consistency check failed with code %s",
             check_code));
     }
+
+    m_journal_changed.clear();
+    m_journal_removed.clear();
+}
+
+template <typename Stream>
+size_t AddrManImpl::SerializeJournal(Stream& s_) const
+{
+    LOCK(cs);
+
+    /**
+     * A journal record contains the state of every entry that was changed
+     * since the last Serialize() or SerializeJournal() call:
+     * * the addresses of deleted entries
+     * * for every other changed entry: the entry, whether it is in the tried
+     *   table, and the new buckets it is in (its position within a bucket
+     *   and its tried bucket follow from the address)
+     *
+     * The changed entries are complete: an entry whose bucket position got
+     * taken over by another entry was itself changed. Applying a record thus
+     * only needs to remove all entries mentioned in it, and to re-insert the
+     * ones that still exist.
+     */
+    ParamsStream s{CAddress::V2_DISK, s_};
+
+    WriteCompactSize(s, m_journal_removed.size());
+    for (const CService& addr : m_journal_removed) {
+        s << addr;
+    }
+
+    std::vector<int> changed;
+    changed.reserve(m_journal_changed.size());
+    for (int nId : m_journal_changed) {
+        if (mapInfo.count(nId)) changed.push_back(nId);
+    }
+    WriteCompactSize(s, changed.size());
+    for (int nId : changed) {
+        const AddrInfo& info{mapInfo.at(nId)};
+        s << info << info.fInTried;
+        std::vector<int> new_buckets;
+        if (!info.fInTried) {
+            const int start_bucket{info.GetNewBucket(nKey, m_netgroupman)};
+            for (int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT; ++n) {
+                const int bucket{(start_bucket + n) % ADDRMAN_NEW_BUCKET_COUNT};
+                if (vvNew[bucket][info.GetBucketPosition(nKey, true, bucket)] == nId) {
+                    new_buckets.push_back(bucket);
+                    if ((int)new_buckets.size() == info.nRefCount) break;
+                }
+            }
+        }
+        s << new_buckets;
+    }
+
+    const size_t num_changes{m_journal_removed.size() + changed.size()};
+    m_journal_changed.clear();
+    m_journal_removed.clear();
+    return num_changes;
+}
+
+template <typename Stream>
+void AddrManImpl::UnserializeJournal(Stream& s_)
+{
+    LOCK(cs);
+
+    ParamsStream s{CAddress::V2_DISK, s_};
+
+    // Parse the complete record before modifying anything.
+    std::vector<CService> removed;
+    for (uint64_t n = ReadCompactSize(s); n > 0; --n) {
+        s >> removed.emplace_back();
+    }
+    struct ChangedEntry {
+        AddrInfo info;
+        bool in_tried{false};
+        std::vector<int> new_buckets;
+    };
+    std::vector<ChangedEntry> changed;
+    for (uint64_t n = ReadCompactSize(s); n > 0; --n) {
+        ChangedEntry& entry{changed.emplace_back()};
+        s >> entry.info >> entry.in_tried >> entry.new_buckets;
+        if (!entry.info.IsValid() || entry.in_tried == !entry.new_buckets.empty() ||
+            entry.new_buckets.size() > ADDRMAN_NEW_BUCKETS_PER_ADDRESS) {
+            throw std::ios_base::failure("Corrupt addrman journal record: invalid entry");
+        }
+    }
+
+    for (const CService& addr : removed) {
+        Remove(addr);
+    }
+    for (const ChangedEntry& entry : changed) {
+        Remove(entry.info);
+    }
+
+    for (const ChangedEntry& entry : changed) {
+        if (Find(entry.info)) {
+            throw std::ios_base::failure("Corrupt addrman journal record: duplicate entry");
+        }
+        int nId;
+        AddrInfo& info{*Create(entry.info, entry.info.source, &nId)};
+        info.m_last_success = entry.info.m_last_success;
+        info.nAttempts = entry.info.nAttempts;
+        if (entry.in_tried) {
+            const int bucket{info.GetTriedBucket(nKey, m_netgroupman)};
+            const int pos{info.GetBucketPosition(nKey, false, bucket)};
+            if (vvTried[bucket][pos] != -1) {
+                throw std::ios_base::failure("Corrupt addrman journal record: tried position in use");
+            }
+            RemoveFromNetworkIndex(info);
+            nNew--;
+            m_network_counts[info.GetNetwork()].n_new--;
+            info.fInTried = true;
+            vvTried[bucket][pos] = nId;
+            nTried++;
+            m_network_counts[info.GetNetwork()].n_tried++;
+            AddToNetworkIndex(nId, info);
+        } else {
+            for (const int bucket : entry.new_buckets) {
+                if (bucket < 0 || bucket >= ADDRMAN_NEW_BUCKET_COUNT) {
+                    throw std::ios_base::failure("Corrupt addrman journal record: invalid bucket");
+                }
+                const int pos{info.GetBucketPosition(nKey, true, bucket)};
+                if (vvNew[bucket][pos] != -1) {
+                    throw std::ios_base::failure("Corrupt addrman journal record: new position in use");
+                }
+                vvNew[bucket][pos] = nId;
+                info.nRefCount++;
+            }
+        }
+    }
+
+    const int check_code{CheckAddrman()};
+    if (check_code != 0) {
+        throw std::ios_base::failure(strprintf(
+            "Corrupt addrman journal record. Consistency check failed with code %s",
+            check_code));
+    }
+
+    m_journal_changed.clear();
+    m_journal_removed.clear();
 }
 
 AddrInfo* AddrManImpl::Find(const CService& addr, int* pnId)
@@ -416,15 +561,17 @@ AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource,
     AssertLockHeld(cs);
 
     int nId = nIdCount++;
-    mapInfo[nId] = AddrInfo(addr, addrSource);
+    AddrInfo& info = mapInfo[nId] = AddrInfo(addr, addrSource);
     mapAddr[addr] = nId;
-    mapInfo[nId].nRandomPos = vRandom.size();
+    info.nRandomPos = vRandom.size();
     vRandom.push_back(nId);
     nNew++;
     m_network_counts[addr.GetNetwork()].n_new++;
+    AddToNetworkIndex(nId, info);
+    MarkChanged(nId);
     if (pnId)
         *pnId = nId;
-    return &mapInfo[nId];
+    return &info;
 }
 
 void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
@@ -451,6 +598,34 @@ void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
     vRandom[nRndPos2] = nId1;
 }
 
+void AddrManImpl::AddToNetworkIndex(int nId, AddrInfo& info)
+{
+    AssertLockHeld(cs);
+
+    std::vector<int>& ids{m_network_index[info.GetNetwork()][info.fInTried]};
+    info.m_network_pos = ids.size();
+    ids.push_back(nId);
+}
+
+void AddrManImpl::RemoveFromNetworkIndex(AddrInfo& info)
+{
+    AssertLockHeld(cs);
+
+    std::vector<int>& ids{m_network_index[info.GetNetwork()][info.fInTried]};
+    assert(info.m_network_pos >= 0 && (size_t)info.m_network_pos < ids.size());
+
+    // Move the last entry into the vacated position.
+    const int nIdLast{ids.back()};
+    if ((size_t)info.m_network_pos != ids.size() - 1) {
+        const auto it_last{mapInfo.find(nIdLast)};
+        assert(it_last != mapInfo.end());
+        it_last->second.m_network_pos = info.m_network_pos;
+        ids[info.m_network_pos] = nIdLast;
+    }
+    ids.pop_back();
+    info.m_network_pos = -1;
+}
+
 void AddrManImpl::Delete(int nId)
 {
     AssertLockHeld(cs);
@@ -462,12 +637,53 @@ void AddrManImpl::Delete(int nId)
 
     SwapRandom(info.nRandomPos, vRandom.size() - 1);
     m_network_counts[info.GetNetwork()].n_new--;
+    RemoveFromNetworkIndex(info);
     vRandom.pop_back();
+    m_journal_changed.erase(nId);
+    m_journal_removed.insert(info);
     mapAddr.erase(info);
     mapInfo.erase(nId);
     nNew--;
 }
 
+void AddrManImpl::Remove(const CService& addr)
+{
+    AssertLockHeld(cs);
+
+    int nId;
+    AddrInfo* pinfo = Find(addr, &nId);
+    if (!pinfo) return;
+    AddrInfo& info = *pinfo;
+
+    if (info.fInTried) {
+        const int bucket{info.GetTriedBucket(nKey, m_netgroupman)};
+        const int pos{info.GetBucketPosition(nKey, false, bucket)};
+        assert(vvTried[bucket][pos] == nId);
+        vvTried[bucket][pos] = -1;
+        RemoveFromNetworkIndex(info);
+        info.fInTried = false;
+        nTried--;
+        m_network_counts[info.GetNetwork()].n_tried--;
+        // Delete() expects a new table entry
+        nNew++;
+        m_network_counts[info.GetNetwork()].n_new++;
+        AddToNetworkIndex(nId, info);
+    } else {
+        const int start_bucket{info.GetNewBucket(nKey, m_netgroupman)};
+        for (int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT && info.nRefCount > 0; ++n) {
+            const int bucket{(start_bucket + n) % ADDRMAN_NEW_BUCKET_COUNT};
+            const int pos{info.GetBucketPosition(nKey, true, bucket)};
+            if (vvNew[bucket][pos] == nId) {
+                vvNew[bucket][pos] = -1;
+                info.nRefCount--;
+            }
+        }
+    }
+    assert(info.nRefCount == 0);
+    m_tried_collisions.erase(nId);
+    Delete(nId);
+}
+
 void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
 {
     AssertLockHeld(cs);
@@ -478,6 +694,7 @@ void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
         AddrInfo& infoDelete = mapInfo[nIdDelete];
         assert(infoDelete.nRefCount > 0);
         infoDelete.nRefCount--;
+        MarkChanged(nIdDelete);
         vvNew[nUBucket][nUBucketPos] = -1;
         LogPrint(BCLog::ADDRMAN, "Removed %s from new[%i][%i]\n", infoDelete.ToStringAddrPort(), nUBucket, nUBucketPos);
         if (infoDelete.nRefCount == 0) {
@@ -503,8 +720,10 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
     }
     nNew--;
     m_network_counts[info.GetNetwork()].n_new--;
+    RemoveFromNetworkIndex(info);
 
     assert(info.nRefCount == 0);
+    MarkChanged(nId);
 
     // which tried bucket to move the entry to
     int nKBucket = info.GetTriedBucket(nKey, m_netgroupman);
@@ -516,8 +735,10 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
         int nIdEvict = vvTried[nKBucket][nKBucketPos];
         assert(mapInfo.count(nIdEvict) == 1);
         AddrInfo& infoOld = mapInfo[nIdEvict];
+        MarkChanged(nIdEvict);
 
         // Remove the to-be-evicted item from the tried set.
+        RemoveFromNetworkIndex(infoOld);
         infoOld.fInTried = false;
         vvTried[nKBucket][nKBucketPos] = -1;
         nTried--;
@@ -534,6 +755,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
         vvNew[nUBucket][nUBucketPos] = nIdEvict;
         nNew++;
         m_network_counts[infoOld.GetNetwork()].n_new++;
+        AddToNetworkIndex(nIdEvict, infoOld);
         LogPrint(BCLog::ADDRMAN, "Moved %s from tried[%i][%i] to new[%i][%i] to make space\n",
                  infoOld.ToStringAddrPort(), nKBucket, nKBucketPos, nUBucket, nUBucketPos);
     }
@@ -543,6 +765,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
     nTried++;
     info.fInTried = true;
     m_network_counts[info.GetNetwork()].n_tried++;
+    AddToNetworkIndex(nId, info);
 }
 
 bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::chrono::seconds time_penalty)
@@ -561,6 +784,8 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
     }
 
     if (pinfo) {
+        MarkChanged(nId);
+
         // periodically update nTime
         const bool currently_online{NodeClock::now() - addr.nTime < 24h};
         const auto update_interval{currently_online ? 1h : 24h};
@@ -636,6 +861,7 @@ bool AddrManImpl::Good_(const CService& addr, bool test_before_evict, NodeSecond
     if (!pinfo) return false;
 
     AddrInfo& info = *pinfo;
+    MarkChanged(nId);
 
     // update info
     info.m_last_success = time;
@@ -693,7 +919,8 @@ void AddrManImpl::Attempt_(const CService& addr, bool fCountFailure, NodeSeconds
 {
     AssertLockHeld(cs);
 
-    AddrInfo* pinfo = Find(addr);
+    int nId;
+    AddrInfo* pinfo = Find(addr, &nId);
 
     // if not found, bail out
     if (!pinfo)
@@ -706,6 +933,7 @@ void AddrManImpl::Attempt_(const CService& addr, bool fCountFailure, NodeSeconds
     if (fCountFailure && info.m_last_count_attempt < m_last_good) {
         info.m_last_count_attempt = time;
         info.nAttempts++;
+        MarkChanged(nId);
     }
 }
 
@@ -741,6 +969,26 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, std::option
         search_tried = insecure_rand.randbool();
     }
 
+    if (network.has_value()) {
+        // The entries of the requested network may be very sparse in the
+        // bucket tables, so pick among them directly instead of searching the
+        // buckets.
+        const auto& ids{m_network_index.at(*network)[search_tried]};
+        double chance_factor = 1.0;
+        while (1) {
+            const int node_id{ids[insecure_rand.randrange(ids.size())]};
+            const auto it_found{mapInfo.find(node_id)};
+            assert(it_found != mapInfo.end());
+            const AddrInfo& info{it_found->second};
+
+            if (insecure_rand.randbits(30) < chance_factor * info.GetChance() * (1 << 30)) {
+                LogPrint(BCLog::ADDRMAN, "Selected %s from %s\n", info.ToStringAddrPort(), search_tried ? "tried" : "new");
+                return {info, info.m_last_try};
+            }
+            chance_factor *= 1.2;
+        }
+    }
+
     const int bucket_count{search_tried ? ADDRMAN_TRIED_BUCKET_COUNT : ADDRMAN_NEW_BUCKET_COUNT};
 
     // Loop through the addrman table until we find an appropriate entry
@@ -756,14 +1004,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, std::option
         for (i = 0; i < ADDRMAN_BUCKET_SIZE; ++i) {
             position = (initial_position + i) % ADDRMAN_BUCKET_SIZE;
             node_id = GetEntry(search_tried, bucket, position);
-            if (node_id != -1) {
-                if (network.has_value()) {
-                    const auto it{mapInfo.find(node_id)};
-                    if (Assume(it != mapInfo.end()) && it->second.GetNetwork() == *network) break;
-                } else {
-                    break;
-                }
-            }
+            if (node_id != -1) break;
         }
 
         // If the bucket is entirely empty, start over with a (likely) different one.
@@ -817,6 +1058,35 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
     // gather a list of random nodes, skipping those of low quality
     const auto now{Now<NodeSeconds>()};
     std::vector<CAddress> addresses;
+
+    // Entries whose network class is IPv4 may also be stored as IPv6 (e.g.
+    // 6to4 or Teredo addresses), so only other networks can be looked up in
+    // the per-network index.
+    if (network.has_value() && *network != NET_IPV4) {
+        std::vector<int> ids;
+        if (const auto it{m_network_index.find(*network)}; it != m_network_index.end()) {
+            ids.reserve(it->second[0].size() + it->second[1].size());
+            ids.insert(ids.end(), it->second[0].begin(), it->second[0].end());
+            ids.insert(ids.end(), it->second[1].begin(), it->second[1].end());
+        }
+        for (size_t n = 0; n < ids.size(); n++) {
+            if (addresses.size() >= nNodes)
+                break;
+
+            std::swap(ids[n], ids[insecure_rand.randrange(ids.size() - n) + n]);
+            const auto it{mapInfo.find(ids[n])};
+            assert(it != mapInfo.end());
+
+            const AddrInfo& ai{it->second};
+            if (ai.GetNetClass() != network) continue;
+            if (ai.IsTerrible(now)) continue;
+
+            addresses.push_back(ai);
+        }
+        LogPrint(BCLog::ADDRMAN, "GetAddr returned %d random addresses\n", addresses.size());
+        return addresses;
+    }
+
     for (unsigned int n = 0; n < vRandom.size(); n++) {
         if (addresses.size() >= nNodes)
             break;
@@ -868,7 +1138,8 @@ void AddrManImpl::Connected_(const CService& addr, NodeSeconds time)
 {
     AssertLockHeld(cs);
 
-    AddrInfo* pinfo = Find(addr);
+    int nId;
+    AddrInfo* pinfo = Find(addr, &nId);
 
     // if not found, bail out
     if (!pinfo)
@@ -880,6 +1151,7 @@ void AddrManImpl::Connected_(const CService& addr, NodeSeconds time)
     const auto update_interval{20min};
     if (time - info.nTime > update_interval) {
         info.nTime = time;
+        MarkChanged(nId);
     }
 }
 
@@ -887,7 +1159,8 @@ void AddrManImpl::SetServices_(const CService& addr, ServiceFlags nServices)
 {
     AssertLockHeld(cs);
 
-    AddrInfo* pinfo = Find(addr);
+    int nId;
+    AddrInfo* pinfo = Find(addr, &nId);
 
     // if not found, bail out
     if (!pinfo)
@@ -897,6 +1170,7 @@ void AddrManImpl::SetServices_(const CService& addr, ServiceFlags nServices)
 
     // update info
     info.nServices = nServices;
+    MarkChanged(nId);
 }
 
 void AddrManImpl::ResolveCollisions_()
@@ -1089,6 +1363,14 @@ int AddrManImpl::CheckAddrman() const
         }
         if (info.nRandomPos < 0 || (size_t)info.nRandomPos >= vRandom.size() || vRandom[info.nRandomPos] != n)
             return -14;
+        const auto it_net{m_network_index.find(info.GetNetwork())};
+        if (it_net == m_network_index.end()) {
+            return -22;
+        }
+        const std::vector<int>& net_ids{it_net->second[info.fInTried]};
+        if (info.m_network_pos < 0 || (size_t)info.m_network_pos >= net_ids.size() || net_ids[info.m_network_pos] != n) {
+            return -22;
+        }
         if (info.m_last_try < NodeSeconds{0s}) {
             return -6;
         }
@@ -1151,6 +1433,11 @@ int AddrManImpl::CheckAddrman() const
             return -21;
         }
     }
+    for (const auto& [net, ids] : m_network_index) {
+        if (local_counts[net].n_new != ids[0].size() || local_counts[net].n_tried != ids[1].size()) {
+            return -23;
+        }
+    }
 
     return 0;
 }
@@ -1276,6 +1563,18 @@ void AddrMan::Unserialize(Stream& s_)
     m_impl->Unserialize<Stream>(s_);
 }
 
+template <typename Stream>
+size_t AddrMan::SerializeJournal(Stream& s_) const
+{
+    return m_impl->SerializeJournal<Stream>(s_);
+}
+
+template <typename Stream>
+void AddrMan::UnserializeJournal(Stream& s_)
+{
+    m_impl->UnserializeJournal<Stream>(s_);
+}
+
 // explicit instantiation
 template void AddrMan::Serialize(HashedSourceWriter<AutoFile>&) const;
 template void AddrMan::Serialize(DataStream&) const;
@@ -1283,6 +1582,8 @@ template void AddrMan::Unserialize(AutoFile&);
 template void AddrMan::Unserialize(HashVerifier<AutoFile>&);
 template void AddrMan::Unserialize(DataStream&);
 template void AddrMan::Unserialize(HashVerifier<DataStream>&);
+template size_t AddrMan::SerializeJournal(DataStream&) const;
+template void AddrMan::UnserializeJournal(DataStream&);
 
 size_t AddrMan::Size(std::optional<Network> net, std::optional<bool> in_new) const
 {
@@ -100,6 +100,24 @@ public:
     template <typename Stream>
     void Unserialize(Stream& s_);
 
+    /**
+     * Write a journal record with the state of all entries that were changed
+     * since the last Serialize() or SerializeJournal() call.
+     *
+     * Applying the records in order with UnserializeJournal() to an addrman
+     * unserialized from the last full serialization yields the current state,
+     * so persisting changes costs time proportional to the number of changes
+     * rather than the size of the tables.
+     *
+     * @return  The number of changed entries in the record.
+     */
+    template <typename Stream>
+    size_t SerializeJournal(Stream& s_) const;
+
+    /** Apply a journal record written by SerializeJournal(). Throws std::ios_base::failure if it doesn't apply. */
+    template <typename Stream>
+    void UnserializeJournal(Stream& s_);
+
     /**
     * Return size information about addrman.
     *
@@ -15,6 +15,7 @@
 #include <uint256.h>
 #include <util/time.h>
 
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <set>
@@ -63,6 +64,9 @@ public:
     //! position in vRandom
     mutable int nRandomPos{-1};
 
+    //! position in the per-network index of the table (new or tried) this entry is in (memory only)
+    int m_network_pos{-1};
+
     SERIALIZE_METHODS(AddrInfo, obj)
     {
         READWRITE(AsBase<CAddress>(obj), obj.source, Using<ChronoFormatter<int64_t>>(obj.m_last_success), obj.nAttempts);
@@ -111,6 +115,12 @@ public:
     template <typename Stream>
     void Unserialize(Stream& s_) EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
+    template <typename Stream>
+    size_t SerializeJournal(Stream& s_) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    template <typename Stream>
+    void UnserializeJournal(Stream& s_) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
     size_t Size(std::optional<Network> net, std::optional<bool> in_new) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
     bool Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
@@ -225,6 +235,18 @@ private:
     /** Number of entries in addrman per network and new/tried table. */
     std::unordered_map<Network, NewTriedCount> m_network_counts GUARDED_BY(cs);
 
+    //! nIds of entries whose serialized state changed since the last Serialize() or
+    //! SerializeJournal(). Like vRandom, this is unobservable outside the class.
+    mutable std::unordered_set<int> m_journal_changed GUARDED_BY(cs);
+
+    //! Addresses of entries deleted since the last Serialize() or SerializeJournal().
+    mutable std::unordered_set<CService, CServiceHash> m_journal_removed GUARDED_BY(cs);
+
+    /** nIds of all entries per network, split into the new (index 0) and
+     *  tried (index 1) table. Allows selecting entries from a single network
+     *  in bounded time, without searching the bucket tables for them. */
+    std::unordered_map<Network, std::array<std::vector<int>, 2>> m_network_index GUARDED_BY(cs);
+
     //! Find an entry.
     AddrInfo* Find(const CService& addr, int* pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -234,9 +256,21 @@ private:
     //! Swap two elements in vRandom.
     void SwapRandom(unsigned int nRandomPos1, unsigned int nRandomPos2) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Add an entry to m_network_index, in the list matching its current table.
+    void AddToNetworkIndex(int nId, AddrInfo& info) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Remove an entry from m_network_index. Must be called before the entry changes tables.
+    void RemoveFromNetworkIndex(AddrInfo& info) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     //! Delete an entry. It must not be in tried, and have refcount 0.
     void Delete(int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Remove an entry from whichever table it is in and delete it, if it exists.
+    void Remove(const CService& addr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Record that an entry needs to be included in the next journal record.
+    void MarkChanged(int nId) const EXCLUSIVE_LOCKS_REQUIRED(cs) { m_journal_changed.insert(nId); }
+
     //! Clear a position in a "new" table. This is the only place where entries are actually deleted.
     void ClearNew(int nUBucket, int nUBucketPos) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
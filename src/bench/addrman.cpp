@@ -8,6 +8,7 @@
 #include <netgroup.h>
 #include <random.h>
 #include <util/check.h>
+#include <util/strencodings.h>
 #include <util/time.h>
 
 #include <optional>
@@ -131,6 +132,49 @@ static void AddrManSelectByNetwork(benchmark::Bench& bench)
     });
 }
 
+/* Add a few I2P addresses to an otherwise full addrman, and move half of them to the tried table. */
+static void AddSparseI2PAddresses(AddrMan& addrman)
+{
+    FastRandomContext rng(uint256(std::vector<unsigned char>(32, 42)));
+    const CNetAddr source{LookupHost("252.2.2.2", false).value()};
+    for (int i = 0; i < 16; ++i) {
+        CService i2p_service;
+        i2p_service.SetSpecial(EncodeBase32(rng.randbytes(ADDR_I2P_SIZE), /*pad=*/false) + ".b32.i2p");
+        CAddress i2p_address(i2p_service, NODE_NONE);
+        i2p_address.nTime = Now<NodeSeconds>();
+        addrman.Add({i2p_address}, source);
+        if (i % 2 == 0) addrman.Good(i2p_address);
+    }
+}
+
+static void AddrManSelectBySparseNetwork(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+    AddSparseI2PAddresses(addrman);
+    assert(addrman.Size(NET_I2P) > 0);
+
+    bench.run([&] {
+        const auto& address = addrman.Select(/*new_only=*/false, NET_I2P);
+        assert(address.first.IsI2P());
+    });
+}
+
+static void AddrManSelectNewOnlyBySparseNetwork(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+    AddSparseI2PAddresses(addrman);
+    assert(addrman.Size(NET_I2P, /*in_new=*/true) > 0);
+
+    bench.run([&] {
+        const auto& address = addrman.Select(/*new_only=*/true, NET_I2P);
+        assert(address.first.IsI2P());
+    });
+}
+
 static void AddrManGetAddr(benchmark::Bench& bench)
 {
     AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
@@ -143,6 +187,19 @@ static void AddrManGetAddr(benchmark::Bench& bench)
     });
 }
 
+static void AddrManGetAddrBySparseNetwork(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+    AddSparseI2PAddresses(addrman);
+
+    bench.run([&] {
+        const auto& addresses = addrman.GetAddr(/*max_addresses=*/2500, /*max_pct=*/23, /*network=*/NET_I2P);
+        assert(addresses.size() > 0);
+    });
+}
+
 static void AddrManAddThenGood(benchmark::Bench& bench)
 {
     auto markSomeAsGood = [](AddrMan& addrman) {
@@ -173,5 +230,8 @@ BENCHMARK(AddrManAdd, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelect, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelectFromAlmostEmpty, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelectByNetwork, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManSelectBySparseNetwork, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManSelectNewOnlyBySparseNetwork, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManGetAddr, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManGetAddrBySparseNetwork, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManAddThenGood, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,68 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+#include <node/blockcompression.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/check.h>
+#include <util/fs.h>
+
+#include <cstddef>
+#include <vector>
+
+using node::CompressBlockFile;
+using node::CompressedBlockFile;
+using node::CompressFrame;
+
+static void BlockCompressFrame(benchmark::Bench& bench)
+{
+    const auto block{MakeByteSpan(benchmark::data::block413567)};
+    const auto frame{block.first(node::DEFAULT_BLOCK_COMPRESSION_FRAME_SIZE)};
+    const auto compressed{CompressFrame(frame)};
+    bench.name(strprintf("%s (ratio %.3f)", __func__, compressed ? double(compressed->size()) / frame.size() : 1.0));
+    bench.batch(frame.size()).unit("byte").minEpochIterations(10).run([&] {
+        const auto out{CompressFrame(frame)};
+        ankerl::nanobench::doNotOptimizeAway(out);
+    });
+}
+
+static void BlockCompressedFileRead(benchmark::Bench& bench, size_t frame_size)
+{
+    // A block file made of copies of a block, read a block at a time from
+    // the compressed file as a block request would.
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const fs::path block_path{testing_setup->m_path_root / "blk.dat"};
+    const fs::path compressed_path{testing_setup->m_path_root / "blz.dat"};
+    const auto block{MakeByteSpan(benchmark::data::block413567)};
+    constexpr int BLOCK_COUNT{16};
+    {
+        AutoFile file{fsbridge::fopen(block_path, "wb")};
+        for (int i = 0; i < BLOCK_COUNT; ++i) file << block;
+    }
+    Assert(CompressBlockFile(block_path, compressed_path, frame_size));
+    const auto file{CompressedBlockFile::Open(compressed_path)};
+    Assert(file);
+
+    std::vector<std::byte> out(block.size());
+    int i{0};
+    bench.name(strprintf("%s (frame %u KiB, ratio %.3f)", __func__, frame_size >> 10,
+                         double(fs::file_size(compressed_path)) / fs::file_size(block_path)));
+    bench.unit("block").run([&] {
+        Assert(file->Read((i++ % BLOCK_COUNT) * block.size(), out));
+    });
+    fs::remove(block_path);
+    fs::remove(compressed_path);
+}
+
+static void BlockCompressedFileRead64(benchmark::Bench& bench) { BlockCompressedFileRead(bench, 64 << 10); }
+static void BlockCompressedFileRead256(benchmark::Bench& bench) { BlockCompressedFileRead(bench, 256 << 10); }
+static void BlockCompressedFileRead1024(benchmark::Bench& bench) { BlockCompressedFileRead(bench, 1024 << 10); }
+
+BENCHMARK(BlockCompressFrame, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockCompressedFileRead64, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockCompressedFileRead256, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockCompressedFileRead1024, benchmark::PriorityLevel::HIGH);
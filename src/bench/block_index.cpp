@@ -0,0 +1,88 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <kernel/cs_main.h>
+#include <node/blockstorage.h>
+#include <random.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstddef>
+#include <vector>
+
+using node::BlockMap;
+
+namespace {
+//! A block index of a chain of headers, with a short fork every 100 blocks.
+struct BlockIndexFixture {
+    static constexpr int CHAIN_LENGTH{200'000};
+    BlockMap block_index;
+    std::vector<CBlockIndex*> chain;
+    std::vector<CBlockIndex*> forks;
+    std::vector<uint256> hashes;
+
+    BlockIndexFixture()
+    {
+        LOCK(::cs_main);
+        FastRandomContext rng{/*fDeterministic=*/true};
+        CBlockIndex* prev{nullptr};
+        const auto insert{[&](CBlockIndex* parent) {
+            const auto [it, inserted]{block_index.try_emplace(rng.rand256())};
+            CBlockIndex* pindex{&it->second};
+            pindex->phashBlock = &it->first;
+            pindex->pprev = parent;
+            pindex->nHeight = parent ? parent->nHeight + 1 : 0;
+            pindex->BuildSkip();
+            hashes.push_back(it->first);
+            return pindex;
+        }};
+        for (int height = 0; height < CHAIN_LENGTH; ++height) {
+            prev = insert(prev);
+            chain.push_back(prev);
+            if (height % 100 == 50) {
+                CBlockIndex* fork{prev};
+                for (int i = 0; i < 3; ++i) fork = insert(fork);
+                forks.push_back(fork);
+            }
+        }
+    }
+};
+} // namespace
+
+static void BlockIndexLookup(benchmark::Bench& bench)
+{
+    const BlockIndexFixture fixture;
+    FastRandomContext rng{/*fDeterministic=*/true};
+    bench.minEpochIterations(1000).run([&] {
+        const auto it{fixture.block_index.find(fixture.hashes[rng.randrange(fixture.hashes.size())])};
+        ankerl::nanobench::doNotOptimizeAway(it);
+    });
+}
+
+static void BlockIndexLastCommonAncestor(benchmark::Bench& bench)
+{
+    const BlockIndexFixture fixture;
+    FastRandomContext rng{/*fDeterministic=*/true};
+    bench.minEpochIterations(1000).run([&] {
+        const CBlockIndex* fork{fixture.forks[rng.randrange(fixture.forks.size())]};
+        const CBlockIndex* tip{fixture.chain[rng.randrange(fixture.chain.size())]};
+        ankerl::nanobench::doNotOptimizeAway(LastCommonAncestor(fork, tip));
+    });
+}
+
+static void BlockIndexLocator(benchmark::Bench& bench)
+{
+    const BlockIndexFixture fixture;
+    FastRandomContext rng{/*fDeterministic=*/true};
+    bench.minEpochIterations(1000).run([&] {
+        const auto locator{LocatorEntries(fixture.chain[rng.randrange(fixture.chain.size())])};
+        ankerl::nanobench::doNotOptimizeAway(locator);
+    });
+}
+
+BENCHMARK(BlockIndexLookup, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockIndexLastCommonAncestor, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockIndexLocator, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,77 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+#include <chain.h>
+#include <coins.h>
+#include <consensus/validation.h>
+#include <kernel/cs_main.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+#include <version.h>
+
+#include <cassert>
+
+static CBlock LoadBlock()
+{
+    CBlock block;
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
+    stream >> block;
+    return block;
+}
+
+/** Append a mainnet block to the block files, as done for each block received. */
+static void WriteBlockToDisk(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>()};
+    node::BlockManager& blockman{testing_setup->m_node.chainman->m_blockman};
+    const CBlock block{LoadBlock()};
+    bench.unit("block").run([&] {
+        const FlatFilePos pos{blockman.SaveBlockToDisk(block, /*nHeight=*/1, /*dbp=*/nullptr)};
+        assert(!pos.IsNull());
+    });
+}
+
+/**
+ * Append the undo data of a mainnet block to the undo files, as done for each
+ * block connected. The spent coins are made up from the block's outputs.
+ */
+static void WriteUndoDataForBlock(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestChain100Setup>()};
+    node::BlockManager& blockman{testing_setup->m_node.chainman->m_blockman};
+    const CBlock block{LoadBlock()};
+    CBlockUndo blockundo;
+    for (const CTransactionRef& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        CTxUndo& txundo{blockundo.vtxundo.emplace_back()};
+        for (size_t i = 0; i < tx->vin.size(); ++i) {
+            txundo.vprevout.emplace_back(tx->vout[i % tx->vout.size()], /*nHeightIn=*/400'000, /*fCoinBaseIn=*/false);
+        }
+    }
+
+    LOCK(::cs_main);
+    CBlockIndex& index{*testing_setup->m_node.chainman->ActiveTip()};
+    const auto undo_pos{index.nUndoPos};
+    const auto status{index.nStatus};
+    bench.unit("block").run([&] {
+        // Pretend the undo data hasn't been written yet
+        index.nUndoPos = 0;
+        index.nStatus &= ~BLOCK_HAVE_UNDO;
+        BlockValidationState state;
+        assert(blockman.WriteUndoDataForBlock(blockundo, state, index));
+    });
+    index.nUndoPos = undo_pos;
+    index.nStatus = status;
+}
+
+BENCHMARK(WriteBlockToDisk, benchmark::PriorityLevel::HIGH);
+BENCHMARK(WriteUndoDataForBlock, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,69 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockfilter.h>
+#include <chain.h>
+#include <index/blockfilterindex.h>
+#include <interfaces/chain.h>
+#include <test/util/index.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/** Maximum sizes of the BIP 157 requests, as served by net_processing */
+static constexpr int CFILTERS_REQUEST_SIZE{1000};
+static constexpr int CFHEADERS_REQUEST_SIZE{2000};
+/** Number of light clients syncing the chain in one iteration */
+static constexpr int NUM_CLIENTS{8};
+
+/**
+ * Replay the requests of light clients syncing a chain of about 2100 blocks
+ * from a block filter index, as net_processing serves them: getcfcheckpt,
+ * then getcfheaders and getcfilters of the maximum size.
+ */
+static void BlockFilterIndexServeLightClients(benchmark::Bench& bench)
+{
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    for (int i = 0; i < 2000; ++i) {
+        MineBlock(testing_setup->m_node, P2WSH_OP_TRUE);
+    }
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return testing_setup->m_node.chainman->ActiveChain().Tip())};
+
+    BlockFilterIndex filter_index{interfaces::MakeChain(testing_setup->m_node), BlockFilterType::BASIC, 1 << 20, /*f_memory=*/false, /*f_wipe=*/true};
+    assert(filter_index.Init());
+    assert(filter_index.StartBackgroundSync());
+    IndexWaitSynced(filter_index);
+
+    bench.batch(NUM_CLIENTS * (tip->nHeight + 1)).unit("block").run([&] {
+        for (int client = 0; client < NUM_CLIENTS; ++client) {
+            uint256 header;
+            for (int height = CFCHECKPT_INTERVAL; height <= tip->nHeight; height += CFCHECKPT_INTERVAL) {
+                assert(filter_index.LookupFilterHeader(tip->GetAncestor(height), header));
+            }
+
+            std::vector<uint256> filter_hashes;
+            for (int start = 1; start <= tip->nHeight; start += CFHEADERS_REQUEST_SIZE) {
+                const CBlockIndex* stop_index{tip->GetAncestor(std::min(start + CFHEADERS_REQUEST_SIZE - 1, tip->nHeight))};
+                assert(filter_index.LookupFilterHeader(stop_index->GetAncestor(start - 1), header));
+                assert(filter_index.LookupFilterHashRange(start, stop_index, filter_hashes));
+            }
+
+            std::vector<BlockFilter> filters;
+            for (int start = 0; start <= tip->nHeight; start += CFILTERS_REQUEST_SIZE) {
+                const CBlockIndex* stop_index{tip->GetAncestor(std::min(start + CFILTERS_REQUEST_SIZE - 1, tip->nHeight))};
+                assert(filter_index.LookupFilterRange(start, stop_index, filters));
+            }
+        }
+    });
+
+    filter_index.Stop();
+}
+
+BENCHMARK(BlockFilterIndexServeLightClients, benchmark::PriorityLevel::HIGH);
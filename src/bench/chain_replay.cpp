@@ -0,0 +1,137 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <consensus/amount.h>
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <primitives/transaction.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <validation.h>
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+static constexpr int NUM_BLOCKS{25};
+static constexpr uint32_t SPENDS_PER_BLOCK{200};
+
+/** Mine a transaction with NUM_BLOCKS * SPENDS_PER_BLOCK outputs, once it can spend a coinbase. */
+static CMutableTransaction MineFanout(TestChain100Setup& testing_setup)
+{
+    std::vector<COutPoint> coinbases;
+    for (int i = 0; i <= COINBASE_MATURITY; ++i) {
+        coinbases.push_back(MineBlock(testing_setup.m_node, P2WSH_OP_TRUE));
+    }
+    CMutableTransaction fanout;
+    fanout.vin.emplace_back(coinbases.front());
+    fanout.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+    fanout.vout.resize(NUM_BLOCKS * SPENDS_PER_BLOCK, CTxOut{COIN / 200, P2WSH_OP_TRUE});
+    testing_setup.CreateAndProcessBlock({fanout}, P2WSH_OP_TRUE);
+    return fanout;
+}
+
+/** Extend the chain by NUM_BLOCKS blocks of SPENDS_PER_BLOCK transactions spending the fanout outputs. */
+static void SpendFanout(TestChain100Setup& testing_setup, const CMutableTransaction& fanout, CAmount value)
+{
+    for (int b = 0; b < NUM_BLOCKS; ++b) {
+        std::vector<CMutableTransaction> spends(SPENDS_PER_BLOCK);
+        for (uint32_t i = 0; i < SPENDS_PER_BLOCK; ++i) {
+            spends[i].vin.emplace_back(fanout.GetHash(), b * SPENDS_PER_BLOCK + i);
+            spends[i].vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+            spends[i].vout.emplace_back(value, P2WSH_OP_TRUE);
+        }
+        testing_setup.CreateAndProcessBlock(spends, P2WSH_OP_TRUE);
+    }
+}
+
+/** Extend the chain by NUM_BLOCKS blocks of SPENDS_PER_BLOCK transactions, returning the height it was extended from. */
+static int ExtendChain(TestChain100Setup& testing_setup)
+{
+    const CMutableTransaction fanout{MineFanout(testing_setup)};
+    const int fork_height{WITH_LOCK(::cs_main, return testing_setup.m_node.chainman->ActiveHeight())};
+    SpendFanout(testing_setup, fanout, COIN / 400);
+    return fork_height;
+}
+
+/**
+ * Disconnect and connect again the last blocks of a regtest chain, the
+ * blocks being read from disk as they are connected, as done when replaying
+ * a chain that is already on disk. Blocks are read ahead of the tip unless
+ * prefetch is zero.
+ */
+static void ChainReplay(benchmark::Bench& bench, int prefetch)
+{
+    const std::string prefetch_arg{strprintf("-blockprefetch=%d", prefetch)};
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>(ChainType::REGTEST, {prefetch_arg.c_str()})};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+    const int fork_height{ExtendChain(*testing_setup)};
+
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    CBlockIndex* first{WITH_LOCK(::cs_main, return chainman.ActiveChain()[fork_height + 1])};
+    bench.batch(NUM_BLOCKS).unit("block").run([&] {
+        BlockValidationState state;
+        assert(chainstate.InvalidateBlock(state, first));
+        WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(first));
+        assert(chainstate.ActivateBestChain(state));
+        assert(WITH_LOCK(::cs_main, return chainman.ActiveHeight()) == fork_height + NUM_BLOCKS);
+    });
+}
+
+/** Verify the last blocks of a regtest chain at the highest -checklevel, as done at startup. */
+static void VerifyDB(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    ExtendChain(*testing_setup);
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    bench.batch(NUM_BLOCKS).unit("block").run([&] {
+        LOCK(::cs_main);
+        const VerifyDBResult result{CVerifyDB{chainman.GetNotifications()}.VerifyDB(
+            chainstate, chainman.GetConsensus(), chainstate.CoinsTip(), /*nCheckLevel=*/4, /*nCheckDepth=*/NUM_BLOCKS)};
+        assert(result == VerifyDBResult::SUCCESS);
+    });
+}
+
+/**
+ * Reorganize between two forks of NUM_BLOCKS blocks with the same work, as
+ * done when a deep reorg switches to a competing chain whose blocks are
+ * already on disk.
+ */
+static void DeepReorg(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    ChainstateManager& chainman{*testing_setup->m_node.chainman};
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    const CMutableTransaction fanout{MineFanout(*testing_setup)};
+    const int fork_height{WITH_LOCK(::cs_main, return chainman.ActiveHeight())};
+    SpendFanout(*testing_setup, fanout, COIN / 400);
+    CBlockIndex* tip_a{WITH_LOCK(::cs_main, return chainman.ActiveTip())};
+    CBlockIndex* first_a{WITH_LOCK(::cs_main, return chainman.ActiveChain()[fork_height + 1])};
+
+    // Mine the second fork on top of the fanout, spending the same outputs
+    BlockValidationState state;
+    assert(chainstate.InvalidateBlock(state, first_a));
+    SpendFanout(*testing_setup, fanout, COIN / 500);
+    CBlockIndex* tip_b{WITH_LOCK(::cs_main, return chainman.ActiveTip())};
+    WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(first_a));
+
+    bench.batch(NUM_BLOCKS).unit("block").run([&] {
+        CBlockIndex* tip{WITH_LOCK(::cs_main, return chainman.ActiveTip()) == tip_a ? tip_b : tip_a};
+        assert(chainstate.PreciousBlock(state, tip));
+        assert(WITH_LOCK(::cs_main, return chainman.ActiveTip()) == tip);
+    });
+}
+
+static void ChainReplayNoPrefetch(benchmark::Bench& bench) { ChainReplay(bench, 0); }
+static void ChainReplayPrefetch(benchmark::Bench& bench) { ChainReplay(bench, DEFAULT_BLOCK_PREFETCH); }
+
+BENCHMARK(ChainReplayNoPrefetch, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ChainReplayPrefetch, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyDB, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DeepReorg, benchmark::PriorityLevel::HIGH);
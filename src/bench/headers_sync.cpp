@@ -0,0 +1,81 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <common/args.h>
+#include <headerssync.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <util/chaintype.h>
+#include <validation.h>
+
+#include <cassert>
+#include <vector>
+
+/** Number of headers in a full headers message */
+static constexpr size_t HEADERS_PER_MESSAGE{2000};
+/** Number of headers messages making up the synced chain */
+static constexpr size_t NUM_MESSAGES{10};
+
+static std::vector<std::vector<CBlockHeader>> GenerateHeadersMessages(const CBlockHeader& genesis, const Consensus::Params& params)
+{
+    std::vector<std::vector<CBlockHeader>> messages(NUM_MESSAGES);
+    uint256 prev_hash{genesis.GetHash()};
+    uint32_t prev_time{genesis.nTime};
+    for (auto& headers : messages) {
+        headers.resize(HEADERS_PER_MESSAGE);
+        for (CBlockHeader& header : headers) {
+            header.nVersion = genesis.nVersion;
+            header.hashPrevBlock = prev_hash;
+            header.nTime = ++prev_time;
+            header.nBits = genesis.nBits;
+            while (!CheckProofOfWork(header.GetHash(), header.nBits, params)) {
+                ++header.nNonce;
+            }
+            prev_hash = header.GetHash();
+        }
+    }
+    return messages;
+}
+
+/**
+ * Run a low-work headers sync over a regtest chain: every headers message is
+ * checked for proof of work and fed to HeadersSyncState, first in PRESYNC and
+ * then in REDOWNLOAD, as net_processing does.
+ */
+static void HeadersSyncPresyncAndRedownload(benchmark::Bench& bench)
+{
+    const auto chain_params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    const Consensus::Params& consensus{chain_params->GetConsensus()};
+    const CBlockHeader genesis{chain_params->GenesisBlock().GetBlockHeader()};
+    const uint256 genesis_hash{genesis.GetHash()};
+    CBlockIndex chain_start{genesis};
+    chain_start.phashBlock = &genesis_hash;
+    chain_start.nChainWork = GetBlockProof(chain_start);
+
+    const auto messages{GenerateHeadersMessages(genesis, consensus)};
+    arith_uint256 minimum_work{chain_start.nChainWork};
+    for (const auto& headers : messages) {
+        minimum_work += CalculateHeadersWork(headers);
+    }
+
+    bench.batch(2 * NUM_MESSAGES * HEADERS_PER_MESSAGE).unit("header").run([&] {
+        HeadersSyncState sync{/*id=*/0, consensus, &chain_start, minimum_work};
+        size_t accepted{0};
+        while (sync.GetState() != HeadersSyncState::State::FINAL) {
+            for (const auto& headers : messages) {
+                assert(HasValidProofOfWork(headers, consensus));
+                const auto result{sync.ProcessNextHeaders(headers, /*full_headers_message=*/true)};
+                assert(result.success);
+                accepted += result.pow_validated_headers.size();
+                if (!result.request_more) break;
+            }
+        }
+        assert(accepted == NUM_MESSAGES * HEADERS_PER_MESSAGE);
+    });
+}
+
+BENCHMARK(HeadersSyncPresyncAndRedownload, benchmark::PriorityLevel::HIGH);
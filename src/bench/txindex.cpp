@@ -0,0 +1,96 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <common/args.h>
+#include <consensus/consensus.h>
+#include <index/txindex.h>
+#include <interfaces/chain.h>
+#include <test/util/index.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/fs.h>
+#include <validation.h>
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+/** Total size of the files under a directory. */
+static uintmax_t DirectorySize(const fs::path& dir)
+{
+    uintmax_t size{0};
+    for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+        if (entry.is_regular_file()) size += entry.file_size();
+    }
+    return size;
+}
+
+/**
+ * Look up every transaction of a chain with a block of 1000 transactions on
+ * top of about 200 blocks with few transactions. The disk footprint of the
+ * index is appended to the benchmark name.
+ */
+static void TxIndexLookup(benchmark::Bench& bench, TxIndexFormat format, const std::string& name)
+{
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    std::vector<COutPoint> coinbases;
+    for (int i = 0; i <= COINBASE_MATURITY; ++i) {
+        coinbases.push_back(MineBlock(testing_setup->m_node, P2WSH_OP_TRUE));
+    }
+    CScriptWitness witness;
+    witness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+
+    constexpr uint32_t NUM_TXS{1000};
+    CMutableTransaction fanout;
+    fanout.vin.emplace_back(coinbases.front());
+    fanout.vin.back().scriptWitness = witness;
+    fanout.vout.resize(NUM_TXS, CTxOut{COIN, P2WSH_OP_TRUE});
+    testing_setup->CreateAndProcessBlock({fanout}, P2WSH_OP_TRUE);
+    std::vector<CMutableTransaction> spends(NUM_TXS);
+    for (uint32_t i = 0; i < NUM_TXS; ++i) {
+        spends[i].vin.emplace_back(fanout.GetHash(), i);
+        spends[i].vin.back().scriptWitness = witness;
+        spends[i].vout.emplace_back(COIN, P2WSH_OP_TRUE);
+    }
+    testing_setup->CreateAndProcessBlock(spends, P2WSH_OP_TRUE);
+
+    std::vector<uint256> txids;
+    {
+        LOCK(::cs_main);
+        const CChain& chain{testing_setup->m_node.chainman->ActiveChain()};
+        for (const CBlockIndex* pindex{chain[1]}; pindex; pindex = chain.Next(pindex)) {
+            CBlock block;
+            assert(testing_setup->m_node.chainman->m_blockman.ReadBlockFromDisk(block, *pindex));
+            for (const auto& tx : block.vtx) txids.push_back(tx->GetHash());
+        }
+    }
+
+    // Write all entries of the compact format out to segment files.
+    TxIndex txindex{interfaces::MakeChain(testing_setup->m_node), 1 << 20, /*f_memory=*/false, /*f_wipe=*/false, format, /*segment_entries=*/1};
+    assert(txindex.Init());
+    assert(txindex.StartBackgroundSync());
+    IndexWaitSynced(txindex);
+
+    const fs::path index_dir{gArgs.GetDataDirNet() / "indexes" / (format == TxIndexFormat::COMPACT ? "compacttxindex" : "txindex")};
+    bench.name(strprintf("%s (%u bytes on disk)", name, DirectorySize(index_dir)));
+
+    bench.batch(txids.size()).unit("tx").run([&] {
+        uint256 block_hash;
+        CTransactionRef tx;
+        for (const auto& txid : txids) {
+            assert(txindex.FindTx(txid, block_hash, tx));
+        }
+    });
+
+    txindex.Stop();
+}
+
+static void TxIndexLookupLevelDB(benchmark::Bench& bench) { TxIndexLookup(bench, TxIndexFormat::LEVELDB, "TxIndexLookupLevelDB"); }
+static void TxIndexLookupCompact(benchmark::Bench& bench) { TxIndexLookup(bench, TxIndexFormat::COMPACT, "TxIndexLookupCompact"); }
+
+BENCHMARK(TxIndexLookupLevelDB, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TxIndexLookupCompact, benchmark::PriorityLevel::HIGH);
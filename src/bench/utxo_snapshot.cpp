@@ -0,0 +1,81 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <kernel/coinstats.h>
+#include <node/utxo_snapshot.h>
+#include <random.h>
+#include <script/script.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <util/fs.h>
+#include <util/signalinterrupt.h>
+#include <validation.h>
+
+#include <cassert>
+
+static constexpr uint32_t SNAPSHOT_TXS{50000};
+static constexpr int SNAPSHOT_BASE_HEIGHT{1000};
+
+/**
+ * Load a partitioned UTXO snapshot into a coins database and hash it, as done
+ * by loadtxoutset, on one thread or on as many as snapshots are loaded with.
+ */
+static void LoadUTXOSnapshot(benchmark::Bench& bench, int num_threads)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>()};
+    node::BlockManager& blockman{testing_setup->m_node.chainman->m_blockman};
+    const uint256 genesis_hash{WITH_LOCK(::cs_main, return testing_setup->m_node.chainman->ActiveTip()->GetBlockHash())};
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    CCoinsViewDB source{{.path = "source", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    uint64_t coins_count{0};
+    {
+        CCoinsViewCache cache{&source};
+        for (uint32_t i = 0; i < SNAPSHOT_TXS; ++i) {
+            const uint256 txid{rng.rand256()};
+            for (uint32_t n = 0; n < 1 + i % 4; ++n) {
+                const CScript script{CScript() << OP_DUP << OP_HASH160 << rng.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG};
+                cache.AddCoin(COutPoint{txid, n}, Coin{CTxOut{static_cast<CAmount>(rng.randrange(COIN)), script}, static_cast<int>(i % SNAPSHOT_BASE_HEIGHT), /*fCoinBaseIn=*/false}, /*possible_overwrite=*/false);
+                ++coins_count;
+            }
+        }
+        cache.SetBestBlock(genesis_hash);
+        assert(cache.Flush());
+    }
+
+    const fs::path snapshot_path{testing_setup->m_path_root / "utxo.dat"};
+    const node::SnapshotMetadata metadata{genesis_hash, coins_count, /*partitioned=*/true};
+    {
+        AutoFile file{fsbridge::fopen(snapshot_path, "wb")};
+        file << metadata;
+        for (const auto& cursor : source.PartitionCursors()) {
+            file.write(MakeByteSpan(node::SerializeSnapshotPartitions(*cursor, {})));
+        }
+    }
+
+    const util::SignalInterrupt interrupt;
+    bench.unit("coin").batch(coins_count).run([&] {
+        CCoinsViewDB coins_db{{.path = "loaded", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+        AutoFile file{fsbridge::fopen(snapshot_path, "rb")};
+        node::SnapshotMetadata read_metadata;
+        file >> read_metadata;
+        const bool loaded{node::LoadSnapshotPartitions(coins_db, file, read_metadata, SNAPSHOT_BASE_HEIGHT, /*cache_size=*/1 << 25, num_threads, interrupt)};
+        assert(loaded);
+        CCoinsViewCache cache{&coins_db};
+        cache.SetBestBlock(genesis_hash);
+        assert(cache.Flush());
+        const auto stats{kernel::ComputeUTXOStats(kernel::CoinStatsHashType::HASH_SERIALIZED, &coins_db, blockman, {}, num_threads)};
+        assert(stats && stats->coins_count == coins_count);
+    });
+    fs::remove(snapshot_path);
+}
+
+static void LoadUTXOSnapshotSingleThread(benchmark::Bench& bench) { LoadUTXOSnapshot(bench, 1); }
+static void LoadUTXOSnapshotParallel(benchmark::Bench& bench) { LoadUTXOSnapshot(bench, node::SnapshotThreads()); }
+
+BENCHMARK(LoadUTXOSnapshotSingleThread, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadUTXOSnapshotParallel, benchmark::PriorityLevel::HIGH);
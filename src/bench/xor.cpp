@@ -21,4 +21,19 @@ static void Xor(benchmark::Bench& bench)
     });
 }
 
+static void XorObfuscationKey(benchmark::Bench& bench)
+{
+    // The database values and block files are XOR-ed with an 8 byte key,
+    // from any offset in the key.
+    FastRandomContext frc{/*fDeterministic=*/true};
+    auto data{frc.randbytes<std::byte>(1 << 20)};
+    auto key{frc.randbytes<std::byte>(8)};
+    size_t offset{0};
+
+    bench.batch(data.size()).unit("byte").run([&] {
+        util::Xor(data, key, offset++);
+    });
+}
+
 BENCHMARK(Xor, benchmark::PriorityLevel::HIGH);
+BENCHMARK(XorObfuscationKey, benchmark::PriorityLevel::HIGH);
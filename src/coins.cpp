@@ -43,8 +43,11 @@ size_t CCoinsViewCache::DynamicMemoryUsage() const {
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        ++m_cache_hits;
         return it;
+    }
+    ++m_cache_misses;
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
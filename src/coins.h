@@ -243,6 +243,10 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage{0};
 
+    /* Number of coins looked up that were found in the cache, or fetched from the base view. */
+    mutable uint64_t m_cache_hits{0};
+    mutable uint64_t m_cache_misses{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn, bool deterministic = false);
 
@@ -331,6 +335,11 @@ public:
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    //! Number of coins looked up that were found in the cache, and that were
+    //! looked up in the base view.
+    uint64_t GetCacheHits() const { return m_cache_hits; }
+    uint64_t GetCacheMisses() const { return m_cache_misses; }
+
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
@@ -9,15 +9,20 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <sync.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
 #include <leveldb/cache.h>
 #include <leveldb/db.h>
 #include <leveldb/env.h>
@@ -30,6 +35,7 @@
 #include <leveldb/write_batch.h>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <utility>
 
 static auto CharCast(const std::byte* data) { return reinterpret_cast<const char*>(data); }
@@ -134,12 +140,17 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBOptions& db_options)
 {
     leveldb::Options options;
     options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    // up to two write buffers may be held in memory simultaneously
+    options.write_buffer_size = db_options.write_buffer_size.value_or(nCacheSize / 4);
+    options.max_file_size = db_options.max_file_size;
+    options.block_size = db_options.block_size;
+    if (db_options.bloom_filter_bits > 0) {
+        options.filter_policy = leveldb::NewBloomFilterPolicy(db_options.bloom_filter_bits);
+    }
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -218,6 +229,20 @@ struct LevelDBContext {
     leveldb::DB* pdb;
 };
 
+struct DBWriteQueue {
+    Mutex mutex;
+    std::condition_variable cond;
+    //! batches waiting to be written, the front one is being written
+    std::deque<leveldb::WriteBatch> batches GUARDED_BY(mutex);
+    //! number of batches in the queue, to skip the lock when it's empty
+    std::atomic<size_t> pending{0};
+    //! error of the first batch that failed to be written
+    leveldb::Status error GUARDED_BY(mutex);
+    bool stop GUARDED_BY(mutex){false};
+    //! started by the first call to WriteBatchAsync
+    std::thread thread GUARDED_BY(mutex);
+};
+
 CDBWrapper::CDBWrapper(const DBParams& params)
     : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
 {
@@ -226,7 +251,7 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     DBContext().iteroptions.verify_checksums = true;
     DBContext().iteroptions.fill_cache = false;
     DBContext().syncoptions.sync = true;
-    DBContext().options = GetOptions(params.cache_bytes);
+    DBContext().options = GetOptions(params.cache_bytes, params.options);
     DBContext().options.create_if_missing = true;
     if (params.memory_only) {
         DBContext().penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -247,6 +272,10 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     leveldb::Status status = leveldb::DB::Open(DBContext().options, fs::PathToString(params.path), &DBContext().pdb);
     HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
+    LogPrint(BCLog::LEVELDB, "LevelDB using write_buffer_size=%u max_file_size=%u block_size=%u bloom_filter_bits=%d async_write=%d\n",
+             DBContext().options.write_buffer_size, DBContext().options.max_file_size, DBContext().options.block_size,
+             params.options.bloom_filter_bits, params.options.async_write);
+    if (params.options.async_write) m_write_queue = std::make_unique<DBWriteQueue>();
 
     if (params.options.force_compact) {
         LogPrintf("Starting database compaction of %s\n", fs::PathToString(params.path));
@@ -276,6 +305,17 @@ CDBWrapper::CDBWrapper(const DBParams& params)
 
 CDBWrapper::~CDBWrapper()
 {
+    if (m_write_queue) {
+        // Write the queued batches before closing the database.
+        std::thread thread;
+        {
+            LOCK(m_write_queue->mutex);
+            m_write_queue->stop = true;
+            thread = std::move(m_write_queue->thread);
+        }
+        m_write_queue->cond.notify_all();
+        if (thread.joinable()) thread.join();
+    }
     delete DBContext().pdb;
     DBContext().pdb = nullptr;
     delete DBContext().options.filter_policy;
@@ -290,6 +330,7 @@ CDBWrapper::~CDBWrapper()
 
 bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 {
+    SyncPendingWrites();
     const bool log_memory = LogAcceptCategory(BCLog::LEVELDB, BCLog::Level::Debug);
     double mem_before = 0;
     if (log_memory) {
@@ -305,6 +346,68 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
     return true;
 }
 
+void CDBWrapper::WriteBatchAsync(CDBBatch& batch)
+{
+    if (!m_write_queue) {
+        WriteBatch(batch);
+        batch.Clear();
+        return;
+    }
+    DBWriteQueue& queue{*m_write_queue};
+    {
+        WAIT_LOCK(queue.mutex, lock);
+        queue.cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(queue.mutex) {
+            return queue.batches.size() < DBWRAPPER_MAX_QUEUED_BATCHES || !queue.error.ok();
+        });
+        HandleError(queue.error);
+        queue.batches.push_back(batch.m_impl_batch->batch);
+        ++queue.pending;
+        if (!queue.thread.joinable()) {
+            queue.thread = std::thread(&util::TraceThread, "dbwriter", [this] { ThreadWrite(); });
+        }
+    }
+    queue.cond.notify_all();
+    batch.Clear();
+}
+
+void CDBWrapper::SyncPendingWrites() const
+{
+    if (!m_write_queue || m_write_queue->pending == 0) return;
+    DBWriteQueue& queue{*m_write_queue};
+    WAIT_LOCK(queue.mutex, lock);
+    queue.cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(queue.mutex) { return queue.batches.empty(); });
+    HandleError(queue.error);
+}
+
+void CDBWrapper::ThreadWrite()
+{
+    DBWriteQueue& queue{*m_write_queue};
+    WAIT_LOCK(queue.mutex, lock);
+    while (true) {
+        queue.cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(queue.mutex) { return queue.stop || !queue.batches.empty(); });
+        if (queue.batches.empty()) return;
+        // References to the front batch stay valid while batches are queued behind it.
+        leveldb::WriteBatch& batch{queue.batches.front()};
+        leveldb::Status status;
+        {
+            REVERSE_LOCK(lock);
+            status = DBContext().pdb->Write(DBContext().writeoptions, &batch);
+        }
+        queue.batches.pop_front();
+        if (status.ok()) {
+            --queue.pending;
+        } else {
+            LogPrintf("LevelDB write failure in %s: %s\n", m_name, status.ToString());
+            // The database can't be written anymore, drop the batches queued
+            // after this one. The pending count is left set, so that
+            // SyncPendingWrites keeps reporting the error.
+            queue.error = status;
+            queue.batches.clear();
+        }
+        queue.cond.notify_all();
+    }
+}
+
 size_t CDBWrapper::DynamicMemoryUsage() const
 {
     std::string memory;
@@ -337,6 +440,7 @@ std::vector<unsigned char> CDBWrapper::CreateObfuscateKey() const
 
 std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
 {
+    SyncPendingWrites();
     leveldb::Slice slKey(CharCast(key.data()), key.size());
     std::string strValue;
     leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
@@ -351,6 +455,7 @@ std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
 
 bool CDBWrapper::ExistsImpl(Span<const std::byte> key) const
 {
+    SyncPendingWrites();
     leveldb::Slice slKey(CharCast(key.data()), key.size());
 
     std::string strValue;
@@ -392,9 +497,26 @@ CDBIterator::CDBIterator(const CDBWrapper& _parent, std::unique_ptr<IteratorImpl
 
 CDBIterator* CDBWrapper::NewIterator()
 {
+    SyncPendingWrites();
     return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(DBContext().iteroptions))};
 }
 
+std::vector<std::unique_ptr<CDBIterator>> CDBWrapper::NewIterators(size_t count)
+{
+    SyncPendingWrites();
+    leveldb::ReadOptions options{DBContext().iteroptions};
+    options.snapshot = DBContext().pdb->GetSnapshot();
+    std::vector<std::unique_ptr<CDBIterator>> iterators;
+    iterators.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        iterators.emplace_back(new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(options))});
+    }
+    // The iterators pin the state they read, releasing the snapshot only lets
+    // later iterators and compactions move past it.
+    DBContext().pdb->ReleaseSnapshot(options.snapshot);
+    return iterators;
+}
+
 void CDBIterator::SeekImpl(Span<const std::byte> key)
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
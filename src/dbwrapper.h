@@ -22,11 +22,32 @@
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
+//! Number of batches queued by WriteBatchAsync, including the one being written, before it blocks
+static const size_t DBWRAPPER_MAX_QUEUED_BATCHES = 2;
+
+//! -dbmaxfilesize default (bytes)
+static const size_t DEFAULT_DB_MAX_FILE_SIZE = 2 << 20;
+//! -dbblocksize default (bytes)
+static const size_t DEFAULT_DB_BLOCK_SIZE = 4 << 10;
+//! -dbbloombits default
+static const int DEFAULT_DB_BLOOM_BITS = 10;
+//! -dbasyncwrite default
+static const bool DEFAULT_DB_ASYNC_WRITE = true;
 
 //! User-controlled performance and debug options.
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! Size of the memtable, a quarter of the cache size if unset.
+    std::optional<size_t> write_buffer_size{};
+    //! Size of the table files.
+    size_t max_file_size = DEFAULT_DB_MAX_FILE_SIZE;
+    //! Size of the uncompressed blocks of the table files.
+    size_t block_size = DEFAULT_DB_BLOCK_SIZE;
+    //! Bits per key of the bloom filters of the table files, 0 to disable them.
+    int bloom_filter_bits = DEFAULT_DB_BLOOM_BITS;
+    //! Write the batches passed to WriteBatchAsync on a background thread.
+    bool async_write = DEFAULT_DB_ASYNC_WRITE;
 };
 
 //! Application-specific storage settings.
@@ -177,6 +198,7 @@ public:
 };
 
 struct LevelDBContext;
+struct DBWriteQueue;
 
 class CDBWrapper
 {
@@ -205,6 +227,11 @@ private:
     //! whether or not the database resides in memory
     bool m_is_memory;
 
+    //! batches being written on a background thread, if DBOptions::async_write is set
+    std::unique_ptr<DBWriteQueue> m_write_queue;
+
+    void ThreadWrite();
+
     std::optional<std::string> ReadImpl(Span<const std::byte> key) const;
     bool ExistsImpl(Span<const std::byte> key) const;
     size_t EstimateSizeImpl(Span<const std::byte> key1, Span<const std::byte> key2) const;
@@ -272,11 +299,30 @@ public:
 
     bool WriteBatch(CDBBatch& batch, bool fSync = false);
 
+    /**
+     * Queue a batch to be written on a background thread and clear it, so
+     * that the caller can fill it again while it's being written. Blocks while
+     * DBWRAPPER_MAX_QUEUED_BATCHES batches are queued. Reads, iterators and
+     * WriteBatch wait for the queued batches to be written first, so they
+     * observe the batches in order. Without DBOptions::async_write, the batch
+     * is written before returning.
+     */
+    void WriteBatchAsync(CDBBatch& batch);
+
+    /**
+     * Wait for the batches queued by WriteBatchAsync to be written. Throws a
+     * dbwrapper_error if one of them failed.
+     */
+    void SyncPendingWrites() const;
+
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
     CDBIterator* NewIterator();
 
+    /** Create several iterators that all read the same state of the database. */
+    std::vector<std::unique_ptr<CDBIterator>> NewIterators(size_t count);
+
     /**
      * Return true if the database managed by this class contains no entries.
      */
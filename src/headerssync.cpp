@@ -19,6 +19,15 @@ constexpr size_t HEADER_COMMITMENT_PERIOD{606};
 //! received and validated against commitments.
 constexpr size_t REDOWNLOAD_BUFFER_SIZE{14441}; // 14441/606 = ~23.8 commitments
 
+//! Only buffer segments fetched from other peers this far ahead of the
+//! redownload, bounding the memory used for them.
+constexpr size_t MAX_FETCHED_SEGMENTS{16};
+
+//! Remember at most this many segment hashes during PRESYNC (32 KiB, enough
+//! for a chain of ~2 million headers); later segments are only fetched from
+//! the peer we're syncing with.
+constexpr size_t MAX_SEGMENT_HASHES{1024};
+
 // Our memory analysis assumes 48 bytes for a CompressedHeader (so we should
 // re-calculate parameters if we compress further)
 static_assert(sizeof(CompressedHeader) == 48);
@@ -41,6 +50,8 @@ HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus
     // exceeds this bound, because it's not possible for a consensus-valid
     // chain to be longer than this (at the current time -- in the future we
     // could try again, if necessary, to sync a longer chain).
+    m_segment_hashes.push_back(chain_start->GetBlockHash());
+
     m_max_commitments = 6*(Ticks<std::chrono::seconds>(GetAdjustedTime() - NodeSeconds{std::chrono::seconds{chain_start->GetMedianTimePast()}}) + MAX_FUTURE_BLOCK_TIME) / HEADER_COMMITMENT_PERIOD;
 
     LogPrint(BCLog::NET, "Initial headers sync started with peer=%d: height=%i, max_commitments=%i, min_work=%s\n", m_id, m_current_height, m_max_commitments, m_minimum_required_work.ToString());
@@ -55,6 +66,8 @@ void HeadersSyncState::Finalize()
     ClearShrink(m_header_commitments);
     m_last_header_received.SetNull();
     ClearShrink(m_redownloaded_headers);
+    ClearShrink(m_segment_hashes);
+    m_fetched_segments.clear();
     m_redownload_buffer_last_hash.SetNull();
     m_redownload_buffer_first_prev_hash.SetNull();
     m_process_all_remaining_headers = false;
@@ -112,6 +125,9 @@ HeadersSyncState::ProcessingResult HeadersSyncState::ProcessNextHeaders(const
             }
         }
 
+        // Continue with any segments that other peers served us ahead of time.
+        if (ret.success) ret.success = ProcessFetchedSegments();
+
         if (ret.success) {
             // Return any headers that are ready for acceptance.
             ret.pow_validated_headers = PopHeadersReadyForAcceptance();
@@ -206,7 +222,12 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
         }
     }
 
-    m_current_chain_work += GetBlockProof(CBlockIndex(current));
+    if (size_t(next_height - m_chain_start->nHeight) % HEADERS_SYNC_SEGMENT_SIZE == 0 &&
+            m_segment_hashes.size() < MAX_SEGMENT_HASHES) {
+        m_segment_hashes.push_back(current.GetHash());
+    }
+
+    m_current_chain_work += GetHeaderWork(current.nBits);
     m_last_header_received = current;
     m_current_height = next_height;
 
@@ -219,6 +240,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
     if (m_download_state != State::REDOWNLOAD) return false;
 
     int64_t next_height = m_redownload_buffer_last_height + 1;
+    const uint256 hash{header.GetHash()};
 
     // Ensure that we're working on a header that connects to the chain we're
     // downloading.
@@ -242,7 +264,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
     }
 
     // Track work on the redownloaded chain
-    m_redownload_chain_work += GetBlockProof(CBlockIndex(header));
+    m_redownload_chain_work += GetHeaderWork(header.nBits);
 
     if (m_redownload_chain_work >= m_minimum_required_work) {
         m_process_all_remaining_headers = true;
@@ -261,7 +283,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
             // we've run out of commitments.
             return false;
         }
-        bool commitment = m_hasher(header.GetHash()) & 1;
+        bool commitment = m_hasher(hash) & 1;
         bool expected_commitment = m_header_commitments.front();
         m_header_commitments.pop_front();
         if (commitment != expected_commitment) {
@@ -273,7 +295,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
     // Store this header for later processing.
     m_redownloaded_headers.emplace_back(header);
     m_redownload_buffer_last_height = next_height;
-    m_redownload_buffer_last_hash = header.GetHash();
+    m_redownload_buffer_last_hash = hash;
 
     return true;
 }
@@ -294,6 +316,76 @@ std::vector<CBlockHeader> HeadersSyncState::PopHeadersReadyForAcceptance()
     return ret;
 }
 
+size_t HeadersSyncState::GetRedownloadSegment() const
+{
+    return size_t(m_redownload_buffer_last_height - m_chain_start->nHeight) / HEADERS_SYNC_SEGMENT_SIZE;
+}
+
+std::vector<std::pair<size_t, uint256>> HeadersSyncState::GetSegmentsToFetch() const
+{
+    std::vector<std::pair<size_t, uint256>> ret;
+    if (m_download_state != State::REDOWNLOAD || m_process_all_remaining_headers) return ret;
+
+    // Only full segments, which end at a header we know the hash of, can be
+    // fetched.
+    const size_t current{GetRedownloadSegment()};
+    for (size_t index{current + 1}; index <= current + MAX_FETCHED_SEGMENTS && index + 1 < m_segment_hashes.size(); ++index) {
+        if (!m_fetched_segments.count(index)) ret.emplace_back(index, m_segment_hashes[index]);
+    }
+    return ret;
+}
+
+bool HeadersSyncState::AddFetchedSegment(size_t index, std::vector<CBlockHeader>&& headers)
+{
+    if (m_download_state != State::REDOWNLOAD) return false;
+
+    const size_t current{GetRedownloadSegment()};
+    if (index <= current || index > current + MAX_FETCHED_SEGMENTS || index + 1 >= m_segment_hashes.size()) {
+        return false;
+    }
+    // Headers ending at the hash we saw during PRESYNC are the chain we saw
+    // during PRESYNC; they'll still be checked against our commitments once
+    // the redownload reaches them.
+    if (headers.size() != HEADERS_SYNC_SEGMENT_SIZE ||
+            headers.front().hashPrevBlock != m_segment_hashes[index] ||
+            headers.back().GetHash() != m_segment_hashes[index + 1]) {
+        return false;
+    }
+    m_fetched_segments.try_emplace(index, std::move(headers));
+    return true;
+}
+
+bool HeadersSyncState::ProcessFetchedSegments()
+{
+    Assume(m_download_state == State::REDOWNLOAD);
+    if (m_download_state != State::REDOWNLOAD) return false;
+
+    while (size_t(m_redownload_buffer_last_height - m_chain_start->nHeight) % HEADERS_SYNC_SEGMENT_SIZE == 0) {
+        auto it{m_fetched_segments.find(GetRedownloadSegment())};
+        if (it == m_fetched_segments.end()) break;
+        for (const auto& hdr : it->second) {
+            if (!ValidateAndStoreRedownloadedHeader(hdr)) return false;
+        }
+        LogPrint(BCLog::NET, "Initial headers sync with peer=%d: used prefetched headers up to height=%i (redownload phase)\n", m_id, m_redownload_buffer_last_height);
+        m_fetched_segments.erase(it);
+    }
+
+    // Drop any segments that the redownload has gone past.
+    m_fetched_segments.erase(m_fetched_segments.begin(), m_fetched_segments.upper_bound(GetRedownloadSegment()));
+    return true;
+}
+
+const arith_uint256& HeadersSyncState::GetHeaderWork(uint32_t nBits)
+{
+    if (nBits != m_last_work_bits) {
+        CBlockIndex dummy;
+        dummy.nBits = nBits;
+        m_last_work = GetBlockProof(dummy);
+        m_last_work_bits = nBits;
+    }
+    return m_last_work;
+}
+
 CBlockLocator HeadersSyncState::NextHeadersRequestLocator() const
 {
     Assume(m_download_state != State::FINAL);
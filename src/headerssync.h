@@ -15,8 +15,14 @@
 #include <util/hasher.h>
 
 #include <deque>
+#include <map>
+#include <utility>
 #include <vector>
 
+/** Number of headers in a segment of the chain that can be fetched from other
+ * peers during REDOWNLOAD (the number of headers in a full headers message) */
+static constexpr size_t HEADERS_SYNC_SEGMENT_SIZE{2000};
+
 // A compressed CBlockHeader, which leaves out the prevhash
 struct CompressedHeader {
     // header
@@ -96,6 +102,12 @@ struct CompressedHeader {
  * parametrization, we can achieve a given security target for potential
  * permanent memory usage, while choosing N to minimize memory use during the
  * sync (temporary, per-peer storage).
+ *
+ * During presync, we also remember the hash of every
+ * HEADERS_SYNC_SEGMENT_SIZE-th header. In the redownload phase, these let the
+ * caller fetch later segments of the chain from other peers in parallel
+ * (see GetSegmentsToFetch() and AddFetchedSegment()). Fetched segments are
+ * buffered and validated in order, exactly like headers from this peer.
  */
 
 class HeadersSyncState {
@@ -168,6 +180,24 @@ public:
     ProcessingResult ProcessNextHeaders(const std::vector<CBlockHeader>&
             received_headers, bool full_headers_message);
 
+    /** During REDOWNLOAD, return segments of the chain following the one being
+     * redownloaded from this peer, that have not been fetched yet. Each is
+     * returned as its index and the hash of the header it builds on, which
+     * can be used to request the segment from any peer with a GETHEADERS.
+     */
+    std::vector<std::pair<size_t, uint256>> GetSegmentsToFetch() const;
+
+    /** Store a segment of headers that was fetched from another peer, to be
+     * validated once the redownload reaches it.
+     *
+     * Assumes the caller has already verified the headers are continuous and
+     * satisfy the proof-of-work target included in them.
+     *
+     * Returns false if the headers are not the expected segment, or it is no
+     * longer needed.
+     */
+    bool AddFetchedSegment(size_t index, std::vector<CBlockHeader>&& headers);
+
     /** Issue the next GETHEADERS message to our peer.
      *
      * This will return a locator appropriate for the current sync object, to continue the
@@ -207,6 +237,19 @@ private:
     /** Return a set of headers that satisfy our proof-of-work threshold */
     std::vector<CBlockHeader> PopHeadersReadyForAcceptance();
 
+    /** In REDOWNLOAD, the index of the segment the redownload buffer ends in,
+     * i.e. the one being fetched from this peer */
+    size_t GetRedownloadSegment() const;
+
+    /** In REDOWNLOAD, check and buffer segments fetched from other peers that
+     * continue the redownload buffer */
+    bool ProcessFetchedSegments();
+
+    /** Return the work represented by a header with the given nBits. nBits
+     * only changes at difficulty adjustments, so the last result is cached
+     * rather than dividing 256-bit numbers for every header. */
+    const arith_uint256& GetHeaderWork(uint32_t nBits);
+
 private:
     /** NodeId of the peer (used for log messages) **/
     const NodeId m_id;
@@ -242,6 +285,16 @@ private:
     /** Height of m_last_header_received */
     int64_t m_current_height{0};
 
+    /** Hashes of the headers at every HEADERS_SYNC_SEGMENT_SIZE-th height
+     * after m_chain_start (and of m_chain_start itself) seen during PRESYNC.
+     * Segment i is made up of the headers building on m_segment_hashes[i], up
+     * to the one hashing to m_segment_hashes[i + 1]. */
+    std::vector<uint256> m_segment_hashes;
+
+    /** Segments fetched from other peers, by index, that the redownload
+     * has not reached yet. */
+    std::map<size_t, std::vector<CBlockHeader>> m_fetched_segments;
+
     /** During phase 2 (REDOWNLOAD), we buffer redownloaded headers in memory
      *  until enough commitments have been verified; those are stored in
      *  m_redownloaded_headers */
@@ -273,6 +326,10 @@ private:
 
     /** Current state of our headers sync. */
     State m_download_state{State::PRESYNC};
+
+    /** nBits of the last header passed to GetHeaderWork(), and its work. */
+    uint32_t m_last_work_bits{0};
+    arith_uint256 m_last_work{0};
 };
 
 #endif // BITCOIN_HEADERSSYNC_H
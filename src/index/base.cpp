@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chain.h>
 #include <chainparams.h>
 #include <common/args.h>
 #include <index/base.h>
@@ -20,6 +21,8 @@
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -27,6 +30,10 @@ constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
+//! Number of threads reading blocks ahead of the indexes
+constexpr int SYNC_READ_AHEAD_THREADS{2};
+//! Maximum number of blocks read ahead of the index furthest behind
+constexpr size_t SYNC_READ_AHEAD_BLOCKS{16};
 
 template <typename... Args>
 void BaseIndex::FatalErrorf(const char* fmt, const Args&... args)
@@ -142,10 +149,12 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain&
     return chain.Next(chain.FindFork(pindex_prev));
 }
 
-void BaseIndex::ThreadSync()
+void BaseIndex::ThreadSync(std::shared_ptr<IndexSyncCoordinator> coordinator)
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
+        if (!coordinator) coordinator = std::make_shared<IndexSyncCoordinator>(m_chainstate->m_blockman);
+        IndexSyncCoordinator::Registration registration{*coordinator, *this};
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
         while (true) {
@@ -176,6 +185,7 @@ void BaseIndex::ThreadSync()
                     return;
                 }
                 pindex = pindex_next;
+                coordinator->Schedule(*this, pindex, m_chainstate->m_chain);
             }
 
             auto current_time{std::chrono::steady_clock::now()};
@@ -192,16 +202,13 @@ void BaseIndex::ThreadSync()
                 Commit();
             }
 
-            CBlock block;
-            interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            const auto sync_block{coordinator->Take(*this, pindex)};
+            if (!sync_block->read_ok) {
                 FatalErrorf("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
-            } else {
-                block_info.data = &block;
             }
-            if (!CustomAppend(block_info)) {
+            if (!CustomAppend(sync_block->info)) {
                 FatalErrorf("%s: Failed to write block %s to index database",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
@@ -226,7 +233,8 @@ bool BaseIndex::Commit()
         ok = CustomCommit(batch);
         if (ok) {
             GetDB().WriteBestBlock(batch, GetLocator(*m_chain, m_best_block_index.load()->GetBlockHash()));
-            ok = GetDB().WriteBatch(batch);
+            // Later reads and writes of the index wait for the commit.
+            GetDB().WriteBatchAsync(batch);
         }
     }
     if (!ok) {
@@ -390,11 +398,11 @@ void BaseIndex::Interrupt()
     m_interrupt();
 }
 
-bool BaseIndex::StartBackgroundSync()
+bool BaseIndex::StartBackgroundSync(std::shared_ptr<IndexSyncCoordinator> coordinator)
 {
     if (!m_init) throw std::logic_error("Error: Cannot start a non-initialized index");
 
-    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] { ThreadSync(); });
+    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this, coordinator = std::move(coordinator)] { ThreadSync(coordinator); });
     return true;
 }
 
@@ -440,3 +448,163 @@ void BaseIndex::SetBestBlockIndex(const CBlockIndex* block)
     // updated and that the index object is safe to delete.
     m_best_block_index = block;
 }
+
+IndexSyncCoordinator::Block::Block(const CBlockIndex* pindex) : pindex{pindex}, info{kernel::MakeBlockInfo(pindex)} {}
+
+IndexSyncCoordinator::IndexSyncCoordinator(node::BlockManager& blockman) : m_blockman{blockman}
+{
+    for (int i = 0; i < SYNC_READ_AHEAD_THREADS; ++i) {
+        m_threads.emplace_back(&util::TraceThread, strprintf("indexread.%d", i), [this] { ThreadRead(); });
+    }
+}
+
+IndexSyncCoordinator::~IndexSyncCoordinator()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    for (std::thread& thread : m_threads) thread.join();
+}
+
+void IndexSyncCoordinator::Schedule(BaseIndex& index, const CBlockIndex* pindex, const CChain& chain)
+{
+    AssertLockHeld(cs_main);
+    LOCK(m_mutex);
+    m_target = chain.Tip();
+    m_indexes[&index] = pindex->nHeight;
+    UpdateWindow();
+}
+
+std::shared_ptr<const IndexSyncCoordinator::Block> IndexSyncCoordinator::Take(BaseIndex& index, const CBlockIndex* pindex)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_indexes[&index] = pindex->nHeight;
+        UpdateWindow();
+
+        std::shared_ptr<Entry> entry;
+        while (!m_window.empty() && m_target) {
+            const int window_start{m_window.front()->pindex->nHeight};
+            const int offset{pindex->nHeight - window_start};
+            if (offset >= 0 && offset < int(m_window.size())) {
+                if (m_window[offset]->pindex == pindex) entry = m_window[offset];
+                break;
+            }
+            // Wait for the indexes behind to catch up if the block is further
+            // ahead on the chain than what is read ahead, so it's read once
+            if (offset < int(SYNC_READ_AHEAD_BLOCKS) || m_target->GetAncestor(pindex->nHeight) != pindex) break;
+            m_cv.wait(lock);
+        }
+
+        if (entry) {
+            // Read it on this thread if no read-ahead thread picked it up yet
+            if (!entry->started) Read(*entry, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return entry->done; });
+            m_indexes[&index] = pindex->nHeight + 1;
+            UpdateWindow();
+            return std::shared_ptr<const Block>{entry, entry->block.get()};
+        }
+    }
+
+    // The block isn't part of the chain being read ahead, e.g. after a reorg
+    return ReadBlock(pindex, index.NeedsUndoData());
+}
+
+std::unique_ptr<IndexSyncCoordinator::Block> IndexSyncCoordinator::ReadBlock(const CBlockIndex* pindex, bool needs_undo) const
+{
+    auto block{std::make_unique<Block>(pindex)};
+    block->read_ok = m_blockman.ReadBlockFromDisk(block->block, *pindex);
+    block->info.data = &block->block;
+    if (block->read_ok && needs_undo && pindex->nHeight > 0) {
+        block->read_ok = m_blockman.UndoReadFromDisk(block->undo, *pindex);
+        block->info.undo_data = &block->undo;
+    }
+    return block;
+}
+
+void IndexSyncCoordinator::Unregister(BaseIndex& index)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_indexes.erase(&index);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_reading_for.count(&index) == 0; });
+        UpdateWindow();
+    }
+    m_cv.notify_all();
+}
+
+void IndexSyncCoordinator::UpdateWindow()
+{
+    AssertLockHeld(m_mutex);
+    const auto cancel{[](const std::shared_ptr<Entry>& entry) {
+        if (!entry->started) entry->started = entry->done = true;
+    }};
+
+    if (m_indexes.empty() || !m_target) {
+        std::for_each(m_window.begin(), m_window.end(), cancel);
+        m_window.clear();
+        m_queue.clear();
+        return;
+    }
+
+    const int start{std::min_element(m_indexes.begin(), m_indexes.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second};
+    while (!m_window.empty() && m_window.front()->pindex->nHeight < start) {
+        cancel(m_window.front());
+        m_window.pop_front();
+    }
+    // Start over if the index furthest behind isn't at the start of the
+    // window anymore, or if the chain was reorganized
+    if (!m_window.empty() && (m_window.front()->pindex->nHeight != start ||
+                              m_target->GetAncestor(m_window.back()->pindex->nHeight) != m_window.back()->pindex)) {
+        std::for_each(m_window.begin(), m_window.end(), cancel);
+        m_window.clear();
+    }
+    while (!m_queue.empty() && m_queue.front()->started) m_queue.pop_front();
+
+    int height{m_window.empty() ? start : m_window.back()->pindex->nHeight + 1};
+    for (; m_window.size() < SYNC_READ_AHEAD_BLOCKS && height <= m_target->nHeight; ++height) {
+        m_window.push_back(std::make_shared<Entry>(m_target->GetAncestor(height)));
+        m_queue.push_back(m_window.back());
+    }
+    m_cv.notify_all();
+}
+
+void IndexSyncCoordinator::Read(Entry& entry, UniqueLock<Mutex>& lock)
+{
+    AssertLockHeld(m_mutex);
+    entry.started = true;
+
+    std::vector<BaseIndex*> indexes;
+    bool needs_undo{false};
+    for (const auto& [index, next_height] : m_indexes) {
+        if (next_height <= entry.pindex->nHeight) {
+            indexes.push_back(index);
+            needs_undo |= index->NeedsUndoData();
+        }
+    }
+
+    for (const BaseIndex* index : indexes) m_reading_for.insert(index);
+    std::unique_ptr<Block> block;
+    {
+        REVERSE_LOCK(lock);
+        block = ReadBlock(entry.pindex, needs_undo);
+        if (block->read_ok) {
+            for (BaseIndex* index : indexes) index->CustomPrepare(block->info);
+        }
+    }
+    entry.block = std::move(block);
+    for (const BaseIndex* index : indexes) m_reading_for.erase(m_reading_for.find(index));
+    entry.done = true;
+    m_cv.notify_all();
+}
+
+void IndexSyncCoordinator::ThreadRead()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+        if (m_stop) return;
+        const std::shared_ptr<Entry> entry{m_queue.front()};
+        m_queue.pop_front();
+        if (!entry->started) Read(*entry, lock);
+    }
+}
@@ -7,18 +7,34 @@
 
 #include <dbwrapper.h>
 #include <interfaces/chain.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <threadsafety.h>
+#include <undo.h>
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
+class CChain;
 class Chainstate;
 class ChainstateManager;
+class IndexSyncCoordinator;
 namespace interfaces {
 class Chain;
 } // namespace interfaces
+namespace node {
+class BlockManager;
+} // namespace node
 
 struct IndexSummary {
     std::string name;
@@ -39,6 +55,8 @@ struct IndexSummary {
  */
 class BaseIndex : public CValidationInterface
 {
+    friend class IndexSyncCoordinator;
+
 protected:
     /**
      * The database stores a block locator of the chain the database is synced to
@@ -82,8 +100,9 @@ private:
     /// Intended to be run in its own thread, m_thread_sync, and can be
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
-    /// over and the sync thread exits.
-    void ThreadSync();
+    /// over and the sync thread exits. Blocks are read through the coordinator,
+    /// or through one of its own if the index syncs alone.
+    void ThreadSync(std::shared_ptr<IndexSyncCoordinator> coordinator);
 
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
     ///
@@ -118,6 +137,18 @@ protected:
     /// Write update index entries for a newly connected block.
     [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block) { return true; }
 
+    /// Whether CustomAppend needs the undo data of the block. If so, the
+    /// initial sync reads it along with the block and passes it in
+    /// block.undo_data.
+    virtual bool NeedsUndoData() const { return false; }
+
+    /// Do the part of the work for a block that doesn't depend on the previous
+    /// blocks, before it is passed to CustomAppend. During the initial sync
+    /// this is called on the read-ahead threads, so it can run for several
+    /// blocks at once and in any order, and the block may end up not being
+    /// appended if the chain is reorganized in the meantime.
+    virtual void CustomPrepare(const interfaces::BlockInfo& block) {}
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CustomCommit(CDBBatch& batch) { return true; }
@@ -128,6 +159,9 @@ protected:
 
     virtual DB& GetDB() const = 0;
 
+    /// Get the last block the index is in sync with.
+    const CBlockIndex* CurrentIndex() const { return m_best_block_index.load(); }
+
     /// Update the internal best block index as well as the prune lock.
     void SetBestBlockIndex(const CBlockIndex* block);
 
@@ -152,8 +186,9 @@ public:
     /// validation interface so that it stays in sync with blockchain updates.
     [[nodiscard]] bool Init();
 
-    /// Starts the initial sync process.
-    [[nodiscard]] bool StartBackgroundSync();
+    /// Starts the initial sync process. Indexes started with the same
+    /// coordinator share the blocks read for their sync.
+    [[nodiscard]] bool StartBackgroundSync(std::shared_ptr<IndexSyncCoordinator> coordinator = nullptr);
 
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
@@ -162,4 +197,91 @@ public:
     IndexSummary GetSummary() const;
 };
 
+/**
+ * Reads the blocks that indexes need for their initial sync, along with their
+ * undo data if any of the indexes needs it, on a small pool of threads, and
+ * hands each block read to every index syncing through the coordinator.
+ *
+ * Each index keeps its own sync thread, locator and commit cadence. Blocks
+ * are read ahead from the position of the index furthest behind, so an index
+ * ahead of the others waits for them to catch up instead of reading the
+ * blocks on its own, and every block is read from disk once.
+ */
+class IndexSyncCoordinator
+{
+public:
+    /** A block read for the indexes. */
+    struct Block {
+        const CBlockIndex* const pindex;
+        CBlock block;
+        CBlockUndo undo;
+        interfaces::BlockInfo info;
+        bool read_ok{false};
+
+        explicit Block(const CBlockIndex* pindex);
+    };
+
+    /** Registration of an index with the coordinator for the duration of its sync. */
+    class Registration
+    {
+    public:
+        Registration(IndexSyncCoordinator& coordinator, BaseIndex& index) : m_coordinator{coordinator}, m_index{index} {}
+        ~Registration() { m_coordinator.Unregister(m_index); }
+
+    private:
+        IndexSyncCoordinator& m_coordinator;
+        BaseIndex& m_index;
+    };
+
+    explicit IndexSyncCoordinator(node::BlockManager& blockman);
+    ~IndexSyncCoordinator();
+
+    /** Record that the index is about to append pindex, a block of the active chain, and read ahead from there. */
+    void Schedule(BaseIndex& index, const CBlockIndex* pindex, const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(cs_main, !m_mutex);
+
+    /** Return pindex's block, waiting for it to be read if needed. */
+    std::shared_ptr<const Block> Take(BaseIndex& index, const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Entry {
+        const CBlockIndex* const pindex;
+        //! Set once read. Built without holding m_mutex, as it needs cs_main
+        std::unique_ptr<Block> block;
+        bool started{false};
+        bool done{false};
+
+        explicit Entry(const CBlockIndex* pindex) : pindex{pindex} {}
+    };
+
+    node::BlockManager& m_blockman;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Height of the next block each registered index appends, once known
+    std::map<BaseIndex*, int> m_indexes GUARDED_BY(m_mutex);
+    //! Tip of the active chain, the blocks read ahead are its ancestors
+    const CBlockIndex* m_target GUARDED_BY(m_mutex){nullptr};
+    //! Blocks read ahead, in chain order, from the position of the index furthest behind
+    std::deque<std::shared_ptr<Entry>> m_window GUARDED_BY(m_mutex);
+    //! Blocks of the window not picked up by a read-ahead thread yet
+    std::deque<std::shared_ptr<Entry>> m_queue GUARDED_BY(m_mutex);
+    //! Indexes that blocks are being read for, once per block
+    std::multiset<const BaseIndex*> m_reading_for GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+
+    /** Drop the blocks no index needs anymore and schedule the following ones. */
+    void UpdateWindow() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    /** Read the block, and its undo data if needed. */
+    std::unique_ptr<Block> ReadBlock(const CBlockIndex* pindex, bool needs_undo) const;
+
+    /** Read the entry's block for the indexes that will append it, releasing the lock meanwhile. */
+    void Read(Entry& entry, UniqueLock<Mutex>& lock) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    /** Forget about the index, once no read in progress can use it anymore. */
+    void Unregister(BaseIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void ThreadRead() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 #endif // BITCOIN_INDEX_BASE_H
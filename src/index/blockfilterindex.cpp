@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <map>
+#include <optional>
 
 #include <clientversion.h>
 #include <common/args.h>
@@ -37,12 +38,9 @@ constexpr uint8_t DB_FILTER_POS{'P'};
 constexpr unsigned int MAX_FLTR_FILE_SIZE = 0x1000000; // 16 MiB
 /** The pre-allocation chunk size for fltr?????.dat files */
 constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000; // 1 MiB
-/** Maximum size of the cfheaders cache
- *  We have a limit to prevent a bug in filling this cache
- *  potentially turning into an OOM. At 2000 entries, this cache
- *  is big enough for a 2,000,000 length block chain, which
- *  we should be enough until ~2047. */
-constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
+/** Maximum size of the encoded filters kept in the cache of recently served filters. At about
+ *  20 KB per filter for recent blocks, this covers a getcfilters request of the maximum size. */
+constexpr size_t FILTER_CACHE_MAX_BYTES{32 << 20};
 
 namespace {
 
@@ -127,6 +125,26 @@ bool BlockFilterIndex::CustomInit(const std::optional<interfaces::BlockKey>& blo
         m_next_filter_pos.nFile = 0;
         m_next_filter_pos.nPos = 0;
     }
+
+    // Load the filter headers of the index chain. Lookups fall back to the database when they
+    // can't be loaded.
+    std::vector<uint256> filter_headers;
+    if (block) {
+        filter_headers.reserve(block->height + 1);
+        std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+        DBHeightKey key(0);
+        std::pair<uint256, DBVal> value;
+        for (db_it->Seek(key); db_it->Valid() && db_it->GetKey(key) && key.height == static_cast<int>(filter_headers.size()) &&
+                               key.height <= block->height && db_it->GetValue(value); db_it->Next()) {
+            filter_headers.push_back(value.second.header);
+        }
+        if (filter_headers.size() != static_cast<size_t>(block->height + 1) || value.first != block->hash) {
+            LogPrintf("%s: Unable to load the filter headers of %s, serving them from disk\n", __func__, GetName());
+            filter_headers.clear();
+        }
+    }
+    LOCK(m_filter_headers_mutex);
+    m_filter_headers = std::move(filter_headers);
     return true;
 }
 
@@ -147,25 +165,112 @@ bool BlockFilterIndex::CustomCommit(CDBBatch& batch)
     return true;
 }
 
-bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const
+static uint64_t FilterCacheKey(const FlatFilePos& pos)
 {
-    AutoFile filein{m_filter_fileseq->Open(pos, true)};
-    if (filein.IsNull()) {
-        return false;
+    return (uint64_t{static_cast<uint32_t>(pos.nFile)} << 32) | pos.nPos;
+}
+
+bool BlockFilterIndex::FindCachedFilter(const FlatFilePos& pos, BlockFilter& filter) const
+{
+    auto it = m_filter_cache_map.find(FilterCacheKey(pos));
+    if (it == m_filter_cache_map.end()) return false;
+    m_filter_cache.splice(m_filter_cache.begin(), m_filter_cache, it->second);
+    filter = it->second->second;
+    return true;
+}
+
+void BlockFilterIndex::CacheFilter(const FlatFilePos& pos, const BlockFilter& filter) const
+{
+    if (!m_filter_cache_map.emplace(FilterCacheKey(pos), m_filter_cache.end()).second) return;
+    m_filter_cache.emplace_front(pos, filter);
+    m_filter_cache_map[FilterCacheKey(pos)] = m_filter_cache.begin();
+    m_filter_cache_bytes += filter.GetEncodedFilter().size();
+    while (m_filter_cache_bytes > FILTER_CACHE_MAX_BYTES) {
+        const auto& [evicted_pos, evicted_filter] = m_filter_cache.back();
+        m_filter_cache_bytes -= evicted_filter.GetEncodedFilter().size();
+        m_filter_cache_map.erase(FilterCacheKey(evicted_pos));
+        m_filter_cache.pop_back();
     }
+}
 
-    // Check that the hash of the encoded_filter matches the one stored in the db.
+/** Read a filter at the current position of the file, checking it against the filter hash
+ *  stored in the db. Returns the number of bytes read, 0 on failure. */
+static size_t ReadFilter(AutoFile& filein, BlockFilterType filter_type, const uint256& hash, BlockFilter& filter)
+{
     uint256 block_hash;
     std::vector<uint8_t> encoded_filter;
     try {
         filein >> block_hash >> encoded_filter;
-        if (Hash(encoded_filter) != hash) return error("Checksum mismatch in filter decode.");
-        filter = BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter), /*skip_decode_check=*/true);
+        if (Hash(encoded_filter) != hash) {
+            error("Checksum mismatch in filter decode.");
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
+        return 0;
     }
-    catch (const std::exception& e) {
-        return error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
+    const size_t size{block_hash.size() + GetSizeOfCompactSize(encoded_filter.size()) + encoded_filter.size()};
+    filter = BlockFilter(filter_type, block_hash, std::move(encoded_filter), /*skip_decode_check=*/true);
+    return size;
+}
+
+bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const
+{
+    if (WITH_LOCK(m_filter_cache_mutex, return FindCachedFilter(pos, filter))) {
+        return true;
     }
 
+    AutoFile filein{m_filter_fileseq->Open(pos, true)};
+    if (filein.IsNull()) {
+        return false;
+    }
+    if (ReadFilter(filein, GetFilterType(), hash, filter) == 0) {
+        return false;
+    }
+
+    LOCK(m_filter_cache_mutex);
+    CacheFilter(pos, filter);
+    return true;
+}
+
+bool BlockFilterIndex::ReadFiltersFromDisk(const std::vector<std::pair<FlatFilePos, uint256>>& entries,
+                                           std::vector<BlockFilter>& filters_out) const
+{
+    filters_out.resize(entries.size());
+
+    std::vector<size_t> missing;
+    {
+        LOCK(m_filter_cache_mutex);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (!FindCachedFilter(entries[i].first, filters_out[i])) missing.push_back(i);
+        }
+    }
+
+    // Filters of consecutive blocks are usually stored next to each other, so the file is only
+    // opened again when moving to another one, and only gaps are seeked over.
+    std::optional<AutoFile> filein;
+    FlatFilePos file_pos;
+    for (const size_t i : missing) {
+        const auto& [pos, hash] = entries[i];
+        if (!filein || file_pos.nFile != pos.nFile) {
+            filein.emplace(m_filter_fileseq->Open(pos, true));
+        } else if (file_pos.nPos != pos.nPos && std::fseek(filein->Get(), pos.nPos, SEEK_SET) != 0) {
+            return error("%s: Failed to seek to filter in file %d", __func__, pos.nFile);
+        }
+        if (filein->IsNull()) {
+            return false;
+        }
+        const size_t size{ReadFilter(*filein, GetFilterType(), hash, filters_out[i])};
+        if (size == 0) {
+            return false;
+        }
+        file_pos = FlatFilePos{pos.nFile, static_cast<unsigned int>(pos.nPos + size)};
+    }
+
+    LOCK(m_filter_cache_mutex);
+    for (const size_t i : missing) {
+        CacheFilter(entries[i].first, filters_out[i]);
+    }
     return true;
 }
 
@@ -215,17 +320,43 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
     return data_size;
 }
 
+void BlockFilterIndex::CustomPrepare(const interfaces::BlockInfo& block)
+{
+    // The filter of a block other than genesis needs its undo data
+    if (block.height > 0 && !block.undo_data) return;
+
+    BlockFilter filter(m_filter_type, *Assert(block.data), block.undo_data ? *block.undo_data : CBlockUndo{});
+    LOCK(m_prepared_filters_mutex);
+    m_prepared_filters.try_emplace(block.hash, block.height, std::move(filter));
+}
+
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
+    std::optional<BlockFilter> prepared_filter;
+    {
+        LOCK(m_prepared_filters_mutex);
+        auto it = m_prepared_filters.find(block.hash);
+        if (it != m_prepared_filters.end()) {
+            prepared_filter = std::move(it->second.second);
+            m_prepared_filters.erase(it);
+        }
+        // Drop the filters prepared for blocks that were reorganized away
+        for (auto stale = m_prepared_filters.begin(); stale != m_prepared_filters.end();) {
+            stale = stale->second.first <= block.height ? m_prepared_filters.erase(stale) : std::next(stale);
+        }
+    }
+
     CBlockUndo block_undo;
     uint256 prev_header;
 
     if (block.height > 0) {
-        // pindex variable gives indexing code access to node internals. It
-        // will be removed in upcoming commit
-        const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
-        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
-            return false;
+        if (!prepared_filter && !block.undo_data) {
+            // pindex variable gives indexing code access to node internals. It
+            // will be removed in upcoming commit
+            const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+            if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+                return false;
+            }
         }
 
         std::pair<uint256, DBVal> read_out;
@@ -242,7 +373,10 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
+    if (!prepared_filter) {
+        prepared_filter.emplace(m_filter_type, *Assert(block.data), block.undo_data ? *block.undo_data : block_undo);
+    }
+    const BlockFilter& filter{*prepared_filter};
 
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
@@ -258,6 +392,12 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
     }
 
     m_next_filter_pos.nPos += bytes_written;
+
+    LOCK(m_filter_headers_mutex);
+    if (m_filter_headers.size() >= static_cast<size_t>(block.height)) {
+        m_filter_headers.resize(block.height);
+        m_filter_headers.push_back(value.second.header);
+    }
     return true;
 }
 
@@ -305,6 +445,10 @@ bool BlockFilterIndex::CustomRewind(const interfaces::BlockKey& current_tip, con
     batch.Write(DB_FILTER_POS, m_next_filter_pos);
     if (!m_db->WriteBatch(batch)) return false;
 
+    LOCK(m_filter_headers_mutex);
+    if (m_filter_headers.size() > static_cast<size_t>(new_tip.height + 1)) {
+        m_filter_headers.resize(new_tip.height + 1);
+    }
     return true;
 }
 
@@ -393,15 +537,15 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter&
 
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out)
 {
-    LOCK(m_cs_headers_cache);
-
-    bool is_checkpoint{block_index->nHeight % CFCHECKPT_INTERVAL == 0};
-
-    if (is_checkpoint) {
-        // Try to find the block in the headers cache if this is a checkpoint height.
-        auto header = m_headers_cache.find(block_index->GetBlockHash());
-        if (header != m_headers_cache.end()) {
-            header_out = header->second;
+    {
+        LOCK(m_filter_headers_mutex);
+        // The filter headers up to the height of the best block belong to its chain, as they are
+        // truncated before the best block is rewound, and appended before it moves forward.
+        const CBlockIndex* best_block{CurrentIndex()};
+        const int height{block_index->nHeight};
+        if (best_block && height <= best_block->nHeight && static_cast<size_t>(height) < m_filter_headers.size() &&
+            best_block->GetAncestor(height) == block_index) {
+            header_out = m_filter_headers[height];
             return true;
         }
     }
@@ -411,12 +555,6 @@ bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint25
         return false;
     }
 
-    if (is_checkpoint &&
-        m_headers_cache.size() < CF_HEADERS_CACHE_MAX_SZ) {
-        // Add to the headers cache if this is a checkpoint height.
-        m_headers_cache.emplace(block_index->GetBlockHash(), entry.header);
-    }
-
     header_out = entry.header;
     return true;
 }
@@ -429,16 +567,12 @@ bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* st
         return false;
     }
 
-    filters_out.resize(entries.size());
-    auto filter_pos_it = filters_out.begin();
+    std::vector<std::pair<FlatFilePos, uint256>> positions;
+    positions.reserve(entries.size());
     for (const auto& entry : entries) {
-        if (!ReadFilterFromDisk(entry.pos, entry.hash, *filter_pos_it)) {
-            return false;
-        }
-        ++filter_pos_it;
+        positions.emplace_back(entry.pos, entry.hash);
     }
-
-    return true;
+    return ReadFiltersFromDisk(positions, filters_out);
 }
 
 bool BlockFilterIndex::LookupFilterHashRange(int start_height, const CBlockIndex* stop_index,
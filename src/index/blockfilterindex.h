@@ -12,7 +12,9 @@
 #include <index/base.h>
 #include <util/hasher.h>
 
+#include <list>
 #include <unordered_map>
+#include <vector>
 
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 
@@ -35,23 +37,48 @@ private:
     FlatFilePos m_next_filter_pos;
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
-    bool ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const;
+    bool ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
+    /** Read the filters at the given positions with their filter hashes, opening each file once
+     *  and reading filters stored next to each other sequentially. */
+    bool ReadFiltersFromDisk(const std::vector<std::pair<FlatFilePos, uint256>>& entries,
+                             std::vector<BlockFilter>& filters_out) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
     size_t WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter);
 
-    Mutex m_cs_headers_cache;
-    /** cache of block hash to filter header, to avoid disk access when responding to getcfcheckpt. */
-    std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
+    Mutex m_filter_headers_mutex;
+    /** Filter headers of the blocks of the index chain by height, to avoid disk access when
+     *  responding to getcfheaders and getcfcheckpt. Only entries up to the height of the index
+     *  best block are served, as the ones above may belong to blocks being appended. */
+    std::vector<uint256> m_filter_headers GUARDED_BY(m_filter_headers_mutex);
+
+    mutable Mutex m_filter_cache_mutex;
+    /** Recently served filters by position in the filter files, most recent first. */
+    mutable std::list<std::pair<FlatFilePos, BlockFilter>> m_filter_cache GUARDED_BY(m_filter_cache_mutex);
+    mutable std::unordered_map<uint64_t, decltype(m_filter_cache)::iterator> m_filter_cache_map GUARDED_BY(m_filter_cache_mutex);
+    /** Total size of the encoded filters in m_filter_cache. */
+    mutable size_t m_filter_cache_bytes GUARDED_BY(m_filter_cache_mutex){0};
+
+    bool FindCachedFilter(const FlatFilePos& pos, BlockFilter& filter) const EXCLUSIVE_LOCKS_REQUIRED(m_filter_cache_mutex);
+    void CacheFilter(const FlatFilePos& pos, const BlockFilter& filter) const EXCLUSIVE_LOCKS_REQUIRED(m_filter_cache_mutex);
+
+    Mutex m_prepared_filters_mutex;
+    /** Filters built by CustomPrepare ahead of being appended, by block hash, along with the block height. */
+    std::unordered_map<uint256, std::pair<int, BlockFilter>, FilterHeaderHasher> m_prepared_filters GUARDED_BY(m_prepared_filters_mutex);
 
     bool AllowPrune() const override { return true; }
 
 protected:
-    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_filter_headers_mutex);
 
     bool CustomCommit(CDBBatch& batch) override;
 
-    bool CustomAppend(const interfaces::BlockInfo& block) override;
+    bool CustomAppend(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_filters_mutex, !m_filter_headers_mutex);
+
+    bool NeedsUndoData() const override { return true; }
+
+    void CustomPrepare(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_filters_mutex);
 
-    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override EXCLUSIVE_LOCKS_REQUIRED(!m_filter_headers_mutex);
 
     BaseIndex::DB& GetDB() const LIFETIMEBOUND override { return *m_db; }
 
@@ -63,14 +90,14 @@ public:
     BlockFilterType GetFilterType() const { return m_filter_type; }
 
     /** Get a single filter by block. */
-    bool LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const;
+    bool LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
 
     /** Get a single filter header by block. */
-    bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_cache);
+    bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) EXCLUSIVE_LOCKS_REQUIRED(!m_filter_headers_mutex);
 
     /** Get a range of filters between two heights on a chain. */
     bool LookupFilterRange(int start_height, const CBlockIndex* stop_index,
-                           std::vector<BlockFilter>& filters_out) const;
+                           std::vector<BlockFilter>& filters_out) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
 
     /** Get a range of filter hashes between two heights on a chain. */
     bool LookupFilterHashRange(int start_height, const CBlockIndex* stop_index,
@@ -49,6 +49,8 @@ protected:
 
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool NeedsUndoData() const override { return true; }
+
     bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
 
     BaseIndex::DB& GetDB() const override { return *m_db; }
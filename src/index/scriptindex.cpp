@@ -0,0 +1,299 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/scriptindex.h>
+
+#include <common/args.h>
+#include <compressor.h>
+#include <crypto/sha256.h>
+#include <dbwrapper.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <undo.h>
+#include <validation.h>
+
+/* The index database has the following layout:
+ *
+ * Keys for outputs have the type [DB_SCRIPT_OUTPUT, script hash, height, tx index, vout] and
+ * the amount and truncated txid of the output as value.
+ * Keys for inputs have the type [DB_SCRIPT_SPEND, script hash, height, vout, truncated txid] of
+ * the spent output, and the height, tx index and input index of the spending input as value.
+ * Integers in keys are big-endian, so that the entries of a script are sorted in chain order.
+ */
+constexpr uint8_t DB_SCRIPT_OUTPUT{'o'};
+constexpr uint8_t DB_SCRIPT_SPEND{'i'};
+
+std::unique_ptr<ScriptIndex> g_scriptindex;
+
+namespace {
+
+uint256 HashScript(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+uint64_t TxidPrefix(const uint256& txid) { return txid.GetUint64(0); }
+
+struct DBOutputKey {
+    uint256 script_hash;
+    ScriptOutputPos pos;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_SCRIPT_OUTPUT);
+        s << script_hash;
+        ser_writedata32be(s, pos.height);
+        ser_writedata32be(s, pos.tx_index);
+        ser_writedata32be(s, pos.vout);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_SCRIPT_OUTPUT) {
+            throw std::ios_base::failure("Invalid format for scriptindex DB output key");
+        }
+        s >> script_hash;
+        pos.height = ser_readdata32be(s);
+        pos.tx_index = ser_readdata32be(s);
+        pos.vout = ser_readdata32be(s);
+    }
+};
+
+struct DBOutputValue {
+    CAmount amount;
+    uint64_t txid_prefix;
+
+    SERIALIZE_METHODS(DBOutputValue, obj) { READWRITE(Using<AmountCompression>(obj.amount), obj.txid_prefix); }
+};
+
+struct DBSpendKey {
+    uint256 script_hash;
+    int height;
+    uint32_t vout;
+    uint64_t txid_prefix;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_SCRIPT_SPEND);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, vout);
+        s << txid_prefix;
+    }
+};
+
+struct DBSpendValue {
+    int height;
+    uint32_t tx_index;
+    uint32_t vin;
+
+    SERIALIZE_METHODS(DBSpendValue, obj) { READWRITE(VARINT_MODE(obj.height, VarIntMode::NONNEGATIVE_SIGNED), VARINT(obj.tx_index), VARINT(obj.vin)); }
+};
+
+struct BlockEntries {
+    std::vector<std::pair<DBOutputKey, DBOutputValue>> outputs;
+    std::vector<std::pair<DBSpendKey, DBSpendValue>> spends;
+};
+
+BlockEntries GetBlockEntries(const CBlock& block, const CBlockUndo& block_undo, int height)
+{
+    BlockEntries entries;
+    for (uint32_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx{*block.vtx[i]};
+        const uint64_t txid_prefix{TxidPrefix(tx.GetHash())};
+        for (uint32_t n = 0; n < tx.vout.size(); ++n) {
+            const CTxOut& out{tx.vout[n]};
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            entries.outputs.emplace_back(DBOutputKey{HashScript(out.scriptPubKey), {height, i, n}},
+                                         DBOutputValue{out.nValue, txid_prefix});
+        }
+        if (tx.IsCoinBase()) continue;
+
+        const CTxUndo& tx_undo{block_undo.vtxundo.at(i - 1)};
+        for (uint32_t vin = 0; vin < tx.vin.size(); ++vin) {
+            const Coin& coin{tx_undo.vprevout.at(vin)};
+            const COutPoint& prevout{tx.vin[vin].prevout};
+            entries.spends.emplace_back(DBSpendKey{HashScript(coin.out.scriptPubKey), static_cast<int>(coin.nHeight), prevout.n, TxidPrefix(prevout.hash)},
+                                        DBSpendValue{height, i, vin});
+        }
+    }
+    return entries;
+}
+
+} // namespace
+
+ScriptIndex::ScriptIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "scriptindex")
+{
+    fs::path path{gArgs.GetDataDirNet() / "indexes" / "script"};
+    fs::create_directories(path);
+
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+bool ScriptIndex::WriteBlock(const interfaces::BlockInfo& block, const CBlockUndo& block_undo)
+{
+    const BlockEntries entries{GetBlockEntries(*Assert(block.data), block_undo, block.height)};
+    CDBBatch batch(*m_db);
+    for (const auto& [key, value] : entries.outputs) {
+        batch.Write(key, value);
+    }
+    for (const auto& [key, value] : entries.spends) {
+        batch.Write(key, value);
+    }
+    return m_db->WriteBatch(batch);
+}
+
+void ScriptIndex::CustomPrepare(const interfaces::BlockInfo& block)
+{
+    // Outputs of the genesis block are not spendable.
+    if (block.height == 0 || !block.undo_data) return;
+
+    // Entries of a block only depend on the block and its undo data, so they
+    // can be written ahead of the block being appended. Entries written for a
+    // block that ends up reorganized away are dropped by lookups. A rewind
+    // may erase entries shared with the disconnected blocks, so blocks
+    // prepared before a rewind are written again when appended.
+    const uint64_t rewinds{WITH_LOCK(m_prepared_blocks_mutex, return m_rewinds)};
+    if (WriteBlock(block, *block.undo_data)) {
+        LOCK(m_prepared_blocks_mutex);
+        if (m_rewinds == rewinds) m_prepared_blocks.emplace(block.hash, block.height);
+    }
+}
+
+bool ScriptIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // Outputs of the genesis block are not spendable.
+    if (block.height == 0) return true;
+
+    {
+        LOCK(m_prepared_blocks_mutex);
+        const bool prepared{m_prepared_blocks.erase(block.hash) > 0};
+        // Forget the blocks prepared on a chain that was reorganized away
+        for (auto stale = m_prepared_blocks.begin(); stale != m_prepared_blocks.end();) {
+            stale = stale->second <= block.height ? m_prepared_blocks.erase(stale) : std::next(stale);
+        }
+        if (prepared) return true;
+    }
+
+    if (block.undo_data) return WriteBlock(block, *block.undo_data);
+
+    CBlockUndo block_undo;
+    const CBlockIndex* pindex{WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash))};
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return false;
+    }
+    return WriteBlock(block, block_undo);
+}
+
+bool ScriptIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    CDBBatch batch(*m_db);
+    {
+        LOCK(cs_main);
+        const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+        const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+
+        do {
+            CBlock block;
+            CBlockUndo block_undo;
+            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *iter_tip) ||
+                !m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *iter_tip)) {
+                return error("%s: Failed to read block %s from disk",
+                             __func__, iter_tip->GetBlockHash().ToString());
+            }
+
+            const BlockEntries entries{GetBlockEntries(block, block_undo, iter_tip->nHeight)};
+            for (const auto& [key, value] : entries.outputs) {
+                batch.Erase(key);
+            }
+            for (const auto& [key, value] : entries.spends) {
+                batch.Erase(key);
+            }
+
+            iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+        } while (new_tip_index != iter_tip);
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    LOCK(m_prepared_blocks_mutex);
+    ++m_rewinds;
+    m_prepared_blocks.clear();
+    return true;
+}
+
+bool ScriptIndex::FindScriptOutputs(const CScript& script, const ScriptOutputPos& start, size_t count,
+                                    std::vector<ScriptOutput>& outputs, std::optional<ScriptOutputPos>& next) const
+{
+    outputs.clear();
+    next.reset();
+
+    // Blocks read for the entries, most entries of a page are in few blocks.
+    std::map<int, CBlock> blocks;
+    const auto read_block{[&](int height) -> const CBlock* {
+        if (auto it{blocks.find(height)}; it != blocks.end()) return &it->second;
+        const CBlockIndex* pindex{WITH_LOCK(::cs_main, return m_chainstate->m_chain[height])};
+        if (!pindex) return nullptr;
+        if (blocks.size() >= 16) blocks.clear();
+        CBlock& block{blocks[height]};
+        if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            blocks.erase(height);
+            throw std::runtime_error(strprintf("Failed to read block %s from disk", pindex->GetBlockHash().ToString()));
+        }
+        return &block;
+    }};
+
+    const uint256 script_hash{HashScript(script)};
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBOutputKey key;
+    try {
+        for (db_it->Seek(DBOutputKey{script_hash, start}); db_it->Valid(); db_it->Next()) {
+            if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+            if (outputs.size() == count) {
+                next = key.pos;
+                break;
+            }
+            DBOutputValue value;
+            if (!db_it->GetValue(value)) {
+                return error("%s: unable to read value in %s at height %d", __func__, GetName(), key.pos.height);
+            }
+
+            // Skip the entries of blocks that were reorganized away.
+            const CBlock* block{read_block(key.pos.height)};
+            if (!block || key.pos.tx_index >= block->vtx.size()) continue;
+            const CTransactionRef tx{block->vtx[key.pos.tx_index]};
+            if (TxidPrefix(tx->GetHash()) != value.txid_prefix || key.pos.vout >= tx->vout.size() ||
+                tx->vout[key.pos.vout].scriptPubKey != script) {
+                continue;
+            }
+
+            ScriptOutput& output{outputs.emplace_back()};
+            output.pos = key.pos;
+            output.txid = tx->GetHash();
+            output.amount = value.amount;
+
+            DBSpendValue spend;
+            if (!m_db->Read(DBSpendKey{script_hash, key.pos.height, key.pos.vout, value.txid_prefix}, spend)) continue;
+            const CBlock* spend_block{read_block(spend.height)};
+            if (!spend_block || spend.tx_index >= spend_block->vtx.size()) continue;
+            const CTransactionRef spend_tx{spend_block->vtx[spend.tx_index]};
+            if (spend.vin >= spend_tx->vin.size() || spend_tx->vin[spend.vin].prevout != COutPoint{output.txid, key.pos.vout}) {
+                continue;
+            }
+            output.spend = ScriptSpend{spend.height, spend_tx->GetHash(), spend.vin};
+        }
+    } catch (const std::runtime_error& e) {
+        return error("%s: %s", __func__, e.what());
+    }
+    return true;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SCRIPTINDEX_H
+#define BITCOIN_INDEX_SCRIPTINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+class CBlockUndo;
+class CScript;
+
+static constexpr bool DEFAULT_SCRIPTINDEX{false};
+/** Maximum number of outputs returned by a script history lookup */
+static constexpr size_t MAX_SCRIPTINDEX_RESULTS{1000};
+
+/** Position of an output in the chain, by which the outputs of a script are ordered. */
+struct ScriptOutputPos {
+    int height{0};
+    uint32_t tx_index{0};
+    uint32_t vout{0};
+
+    friend bool operator<(const ScriptOutputPos& a, const ScriptOutputPos& b)
+    {
+        return std::tie(a.height, a.tx_index, a.vout) < std::tie(b.height, b.tx_index, b.vout);
+    }
+};
+
+/** Input spending an output of a script. */
+struct ScriptSpend {
+    int height;
+    uint256 txid;
+    uint32_t vin;
+};
+
+/** Output paying to a script, and the input spending it if it's spent. */
+struct ScriptOutput {
+    ScriptOutputPos pos;
+    uint256 txid;
+    CAmount amount;
+    std::optional<ScriptSpend> spend;
+};
+
+/**
+ * ScriptIndex is used to look up the outputs paying to a scriptPubKey, and
+ * the inputs spending them, in the active chain.
+ *
+ * Outputs are stored under the SHA256 of their script followed by their
+ * position in the chain, and inputs under the hash of the script they spend
+ * followed by the position of the spent output, so that the entries of a
+ * script are contiguous and LevelDB's prefix compression of keys stores the
+ * script hash about once per run of entries. Entries are only appended as
+ * blocks are connected, and are derived from a block and its undo data alone,
+ * so the entries of blocks are written in parallel during the initial build.
+ *
+ * Entries store truncated txids, and lookups read the blocks of the entries,
+ * which drops entries left over from blocks that were reorganized away.
+ */
+class ScriptIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    Mutex m_prepared_blocks_mutex;
+    /// Blocks whose entries were written by CustomPrepare ahead of being appended, with their height.
+    std::map<uint256, int> m_prepared_blocks GUARDED_BY(m_prepared_blocks_mutex);
+    /// Number of rewinds, which invalidate the blocks being prepared.
+    uint64_t m_rewinds GUARDED_BY(m_prepared_blocks_mutex){0};
+
+    bool AllowPrune() const override { return false; }
+
+    /// Write the entries of the outputs and inputs of the block.
+    [[nodiscard]] bool WriteBlock(const interfaces::BlockInfo& block, const CBlockUndo& block_undo);
+
+protected:
+    void CustomPrepare(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_blocks_mutex);
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_blocks_mutex);
+
+    bool NeedsUndoData() const override { return true; }
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_blocks_mutex);
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit ScriptIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the outputs paying to a script, in chain order.
+    ///
+    /// @param[in]   script  The scriptPubKey to look up.
+    /// @param[in]   start  Position of the first output to return.
+    /// @param[in]   count  Maximum number of outputs to return.
+    /// @param[out]  outputs  The outputs found, with the inputs spending them.
+    /// @param[out]  next  Position of the next output, if there are more outputs than count.
+    /// @return  false if reading from the index or the blocks failed
+    bool FindScriptOutputs(const CScript& script, const ScriptOutputPos& start, size_t count,
+                           std::vector<ScriptOutput>& outputs, std::optional<ScriptOutputPos>& next) const;
+};
+
+/// The global script index, used by the getscripthistory RPC and REST endpoint. May be null.
+extern std::unique_ptr<ScriptIndex> g_scriptindex;
+
+#endif // BITCOIN_INDEX_SCRIPTINDEX_H
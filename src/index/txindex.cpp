@@ -6,21 +6,230 @@
 
 #include <clientversion.h>
 #include <common/args.h>
+#include <crypto/common.h>
 #include <index/disktxpos.h>
 #include <logging.h>
 #include <node/blockstorage.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <util/fs_helpers.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <set>
+#include <tuple>
+
+/* The COMPACT format database has the following layout:
+ *
+ * Keys for pending entries have the type [DB_TXINDEX_PENDING, CompactTxPos],
+ * where CompactTxPos is serialized as big-endian so that iterating over the
+ * pending entries returns them sorted by txid prefix.
+ * Keys for segment files have the type [DB_TXINDEX_SEGMENT, uint32 id] and
+ * the SegmentInfo of the file as value.
+ *
+ * A segment file seg<id>.dat holds its sorted CompactTxPos records, followed
+ * by the prefix of every SEGMENT_FENCE_INTERVAL-th record.
+ */
 constexpr uint8_t DB_TXINDEX{'t'};
+constexpr uint8_t DB_TXINDEX_PENDING{'p'};
+constexpr uint8_t DB_TXINDEX_SEGMENT{'g'};
+
+/** Number of segment records per prefix kept in memory to locate the records of a prefix */
+constexpr uint64_t SEGMENT_FENCE_INTERVAL{1024};
+/** Number of segment files of a level merged into a segment file of the next level */
+constexpr size_t SEGMENT_MERGE_FANIN{4};
 
 std::unique_ptr<TxIndex> g_txindex;
 
+namespace {
+
+/** Position of a transaction in the active chain, keyed by the leading 8 bytes of its txid. */
+struct CompactTxPos {
+    uint64_t prefix{0};
+    uint32_t height{0};
+    uint32_t index{0};
+
+    static constexpr uint64_t SERIALIZED_SIZE{16};
+
+    friend bool operator<(const CompactTxPos& a, const CompactTxPos& b)
+    {
+        return std::tie(a.prefix, a.height, a.index) < std::tie(b.prefix, b.height, b.index);
+    }
+    friend bool operator==(const CompactTxPos& a, const CompactTxPos& b)
+    {
+        return std::tie(a.prefix, a.height, a.index) == std::tie(b.prefix, b.height, b.index);
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata32be(s, prefix >> 32);
+        ser_writedata32be(s, prefix & 0xffffffff);
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, index);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = uint64_t{ser_readdata32be(s)} << 32;
+        prefix |= ser_readdata32be(s);
+        height = ser_readdata32be(s);
+        index = ser_readdata32be(s);
+    }
+};
+
+struct DBPendingKey {
+    CompactTxPos pos;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_TXINDEX_PENDING);
+        s << pos;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_TXINDEX_PENDING) {
+            throw std::ios_base::failure("Invalid format for txindex DB pending entry key");
+        }
+        s >> pos;
+    }
+};
+
+struct SegmentInfo {
+    /// Number of merges the entries of the segment went through
+    uint32_t level{0};
+    uint64_t count{0};
+    int32_t start_height{0};
+    int32_t end_height{0};
+
+    SERIALIZE_METHODS(SegmentInfo, obj) { READWRITE(obj.level, obj.count, obj.start_height, obj.end_height); }
+};
+
+uint64_t TxidPrefix(const uint256& txid) { return ReadBE64(txid.begin()); }
+
+/** Writes sorted records to a new segment file. */
+class SegmentWriter
+{
+    AutoFile m_file;
+    SegmentInfo m_info;
+    std::vector<uint64_t> m_fences;
+
+public:
+    SegmentWriter(const fs::path& path, uint32_t level) : m_file{fsbridge::fopen(path, "wb")}
+    {
+        m_info.level = level;
+        m_info.start_height = std::numeric_limits<int32_t>::max();
+    }
+
+    bool IsNull() const { return m_file.IsNull(); }
+
+    void Add(const CompactTxPos& pos)
+    {
+        if (m_info.count % SEGMENT_FENCE_INTERVAL == 0) m_fences.push_back(pos.prefix);
+        m_file << pos;
+        ++m_info.count;
+        m_info.start_height = std::min<int32_t>(m_info.start_height, pos.height);
+        m_info.end_height = std::max<int32_t>(m_info.end_height, pos.height);
+    }
+
+    /// Write the fences and flush the file to disk.
+    bool Finish()
+    {
+        m_file << m_fences;
+        return FileCommit(m_file.Get()) && m_file.fclose() == 0;
+    }
+
+    const SegmentInfo& Info() const { return m_info; }
+    std::vector<uint64_t>& Fences() { return m_fences; }
+};
+
+/** Reads the records of a segment file in order. */
+class SegmentReader
+{
+    AutoFile m_file;
+    uint64_t m_remaining;
+
+public:
+    CompactTxPos pos;
 
-/** Access to the txindex database (indexes/txindex/) */
+    SegmentReader(const fs::path& path, uint64_t count) : m_file{fsbridge::fopen(path, "rb")}, m_remaining{count} {}
+
+    bool IsNull() const { return m_file.IsNull(); }
+
+    /// Read the next record into pos, returns false past the last record.
+    bool Next()
+    {
+        if (m_remaining == 0) return false;
+        m_file >> pos;
+        --m_remaining;
+        return true;
+    }
+};
+
+} // namespace
+
+/** Immutable segment file of the COMPACT format */
+struct TxIndex::Segment {
+    uint32_t id;
+    fs::path path;
+    SegmentInfo info;
+    /// Prefix of every SEGMENT_FENCE_INTERVAL-th record
+    std::vector<uint64_t> fences;
+
+    /// Append the records with the given prefix to positions.
+    void Find(uint64_t prefix, std::vector<CompactTxPos>& positions) const
+    {
+        const auto fence{std::lower_bound(fences.begin(), fences.end(), prefix)};
+        if (fence == fences.begin() && (fence == fences.end() || *fence > prefix)) return;
+        // The records of the prefix may start before the first fence that isn't lower.
+        const uint64_t first{uint64_t(fence - fences.begin() - (fence == fences.begin() ? 0 : 1)) * SEGMENT_FENCE_INTERVAL};
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        if (file.IsNull() || std::fseek(file.Get(), first * CompactTxPos::SERIALIZED_SIZE, SEEK_SET) != 0) {
+            throw std::ios_base::failure(strprintf("Unable to open txindex segment %s", fs::PathToString(path)));
+        }
+        CompactTxPos pos;
+        for (uint64_t i = first; i < info.count; ++i) {
+            file >> pos;
+            if (pos.prefix > prefix) break;
+            if (pos.prefix == prefix) positions.push_back(pos);
+        }
+    }
+};
+
+static fs::path SegmentPath(const fs::path& dir, uint32_t id)
+{
+    return dir / fs::u8path(strprintf("seg%08u.dat", id));
+}
+
+const std::string& TxIndexFormatName(TxIndexFormat format)
+{
+    static const std::string leveldb{"leveldb"}, compact{"compact"};
+    return format == TxIndexFormat::COMPACT ? compact : leveldb;
+}
+
+bool TxIndexFormatByName(const std::string& name, TxIndexFormat& format)
+{
+    for (const auto candidate : {TxIndexFormat::LEVELDB, TxIndexFormat::COMPACT}) {
+        if (TxIndexFormatName(candidate) == name) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Access to the txindex database (indexes/txindex/, or indexes/compacttxindex/db/ in the COMPACT format) */
 class TxIndex::DB : public BaseIndex::DB
 {
 public:
-    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    explicit DB(const fs::path& path, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
 
     /// Read the disk location of the transaction data with the given hash. Returns false if the
     /// transaction hash is not indexed.
@@ -30,8 +239,8 @@ public:
     [[nodiscard]] bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
 };
 
-TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
-    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+TxIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(path, n_cache_size, f_memory, f_wipe)
 {}
 
 bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
@@ -48,18 +257,196 @@ bool TxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_
     return WriteBatch(batch);
 }
 
-TxIndex::TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
-    : BaseIndex(std::move(chain), "txindex"), m_db(std::make_unique<TxIndex::DB>(n_cache_size, f_memory, f_wipe))
+TxIndex::TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe,
+                 TxIndexFormat format, size_t segment_entries)
+    : BaseIndex(std::move(chain), "txindex"),
+      m_format{format},
+      m_compact_dir{gArgs.GetDataDirNet() / "indexes" / "compacttxindex"},
+      m_segment_entries{segment_entries},
+      m_db(std::make_unique<TxIndex::DB>(format == TxIndexFormat::COMPACT ? m_compact_dir / "db" : gArgs.GetDataDirNet() / "indexes" / "txindex",
+                                         n_cache_size, f_memory, f_wipe))
 {}
 
 TxIndex::~TxIndex() = default;
 
-bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
+bool TxIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
 {
-    // Exclude genesis block transaction because outputs are not spendable.
-    if (block.height == 0) return true;
+    if (m_format != TxIndexFormat::COMPACT) return true;
+
+    fs::create_directories(m_compact_dir);
+    std::vector<std::shared_ptr<const Segment>> segments;
+    std::set<fs::path> segment_paths;
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    std::pair<uint8_t, uint32_t> key;
+    for (db_it->Seek(std::make_pair(DB_TXINDEX_SEGMENT, uint32_t{0})); db_it->Valid(); db_it->Next()) {
+        if (!db_it->GetKey(key) || key.first != DB_TXINDEX_SEGMENT) break;
+        auto segment{std::make_shared<Segment>()};
+        segment->id = key.second;
+        segment->path = SegmentPath(m_compact_dir, segment->id);
+        if (!db_it->GetValue(segment->info)) {
+            return error("%s: unable to read segment %u info", __func__, segment->id);
+        }
+        AutoFile file{fsbridge::fopen(segment->path, "rb")};
+        try {
+            if (file.IsNull() || std::fseek(file.Get(), segment->info.count * CompactTxPos::SERIALIZED_SIZE, SEEK_SET) != 0) {
+                return error("%s: unable to open segment %s", __func__, fs::PathToString(segment->path));
+            }
+            file >> segment->fences;
+        } catch (const std::exception& e) {
+            return error("%s: unable to read segment %s: %s", __func__, fs::PathToString(segment->path), e.what());
+        }
+        m_next_segment_id = std::max(m_next_segment_id, segment->id + 1);
+        segment_paths.insert(segment->path);
+        segments.push_back(std::move(segment));
+    }
+
+    // Remove the segment files that were written but not committed.
+    for (const auto& entry : fs::directory_iterator(m_compact_dir)) {
+        if (entry.path().extension() == ".dat" && segment_paths.count(entry.path()) == 0) {
+            fs::remove(entry.path());
+        }
+    }
+
+    uint64_t pending_entries{0};
+    DBPendingKey pending_key;
+    for (db_it->Seek(DBPendingKey{}); db_it->Valid() && db_it->GetKey(pending_key); db_it->Next()) {
+        ++pending_entries;
+    }
+    m_pending_entries = pending_entries;
+
+    LOCK(m_segments_mutex);
+    m_segments = std::move(segments);
+    return true;
+}
 
+bool TxIndex::CustomCommit(CDBBatch& batch)
+{
+    if (m_format != TxIndexFormat::COMPACT) return true;
+
+    RemoveObsoleteSegments();
+    if (m_pending_entries < m_segment_entries) return true;
+    try {
+        return WriteSegments(batch);
+    } catch (const std::exception& e) {
+        return error("%s: unable to write segment: %s", __func__, e.what());
+    }
+}
+
+bool TxIndex::WriteSegments(CDBBatch& batch)
+{
+    // Pending entries are read from a snapshot of the database, entries
+    // written meanwhile remain pending.
+    auto segment{std::make_shared<Segment>()};
+    segment->id = m_next_segment_id++;
+    segment->path = SegmentPath(m_compact_dir, segment->id);
+    SegmentWriter writer{segment->path, /*level=*/0};
+    if (writer.IsNull()) {
+        return error("%s: unable to open segment %s", __func__, fs::PathToString(segment->path));
+    }
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBPendingKey key;
+    for (db_it->Seek(DBPendingKey{}); db_it->Valid() && db_it->GetKey(key); db_it->Next()) {
+        writer.Add(key.pos);
+        batch.Erase(key);
+    }
+    if (!writer.Finish()) {
+        return error("%s: unable to flush segment %s", __func__, fs::PathToString(segment->path));
+    }
+    if (writer.Info().count == 0) {
+        fs::remove(segment->path);
+        m_pending_entries = 0;
+        return true;
+    }
+    segment->info = writer.Info();
+    segment->fences = std::move(writer.Fences());
+    batch.Write(std::make_pair(DB_TXINDEX_SEGMENT, segment->id), segment->info);
+    m_pending_entries -= std::min<uint64_t>(m_pending_entries, segment->info.count);
+
+    std::vector<std::shared_ptr<const Segment>> segments{WITH_LOCK(m_segments_mutex, return m_segments)};
+    segments.push_back(std::move(segment));
+
+    // Merge the segments of a level once there are enough of them, so that
+    // lookups go through a number of segments logarithmic in the number of entries.
+    for (uint32_t level = 0;; ++level) {
+        std::vector<std::shared_ptr<const Segment>> inputs;
+        std::copy_if(segments.begin(), segments.end(), std::back_inserter(inputs),
+                     [&](const auto& s) { return s->info.level == level; });
+        if (inputs.size() < SEGMENT_MERGE_FANIN) break;
+
+        auto merged{std::make_shared<Segment>()};
+        merged->id = m_next_segment_id++;
+        merged->path = SegmentPath(m_compact_dir, merged->id);
+        SegmentWriter merge_writer{merged->path, level + 1};
+        if (merge_writer.IsNull()) {
+            return error("%s: unable to open segment %s", __func__, fs::PathToString(merged->path));
+        }
+        std::vector<std::unique_ptr<SegmentReader>> readers;
+        for (const auto& input : inputs) {
+            readers.push_back(std::make_unique<SegmentReader>(input->path, input->info.count));
+            if (readers.back()->IsNull()) {
+                return error("%s: unable to open segment %s", __func__, fs::PathToString(input->path));
+            }
+        }
+        std::vector<SegmentReader*> active;
+        for (const auto& reader : readers) {
+            if (reader->Next()) active.push_back(reader.get());
+        }
+        std::optional<CompactTxPos> last;
+        while (!active.empty()) {
+            const auto next{std::min_element(active.begin(), active.end(),
+                                             [](const auto* a, const auto* b) { return a->pos < b->pos; })};
+            // The same block may have been appended again after a reorg.
+            if (!last || !(*last == (*next)->pos)) {
+                merge_writer.Add((*next)->pos);
+                last = (*next)->pos;
+            }
+            if (!(*next)->Next()) active.erase(next);
+        }
+        if (!merge_writer.Finish()) {
+            return error("%s: unable to flush segment %s", __func__, fs::PathToString(merged->path));
+        }
+        merged->info = merge_writer.Info();
+        merged->fences = std::move(merge_writer.Fences());
+        batch.Write(std::make_pair(DB_TXINDEX_SEGMENT, merged->id), merged->info);
+
+        for (const auto& input : inputs) {
+            batch.Erase(std::make_pair(DB_TXINDEX_SEGMENT, input->id));
+            segments.erase(std::find(segments.begin(), segments.end(), input));
+            m_obsolete_segments.push_back(input);
+        }
+        segments.push_back(std::move(merged));
+    }
+
+    LOCK(m_segments_mutex);
+    m_segments = std::move(segments);
+    return true;
+}
+
+void TxIndex::RemoveObsoleteSegments()
+{
+    for (auto it = m_obsolete_segments.begin(); it != m_obsolete_segments.end();) {
+        const auto& segment{*it};
+        if (segment.use_count() == 1 && !m_db->Exists(std::make_pair(DB_TXINDEX_SEGMENT, segment->id))) {
+            fs::remove(segment->path);
+            it = m_obsolete_segments.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool TxIndex::WriteBlockTxs(const interfaces::BlockInfo& block)
+{
     assert(block.data);
+    if (m_format == TxIndexFormat::COMPACT) {
+        CDBBatch batch(*m_db);
+        for (uint32_t i = 0; i < block.data->vtx.size(); ++i) {
+            batch.Write(DBPendingKey{{TxidPrefix(block.data->vtx[i]->GetHash()), uint32_t(block.height), i}}, uint8_t{0});
+        }
+        if (!m_db->WriteBatch(batch)) return false;
+        m_pending_entries += block.data->vtx.size();
+        return true;
+    }
     CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
     std::vector<std::pair<uint256, CDiskTxPos>> vPos;
     vPos.reserve(block.data->vtx.size());
@@ -70,28 +457,128 @@ bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
     return m_db->WriteTxs(vPos);
 }
 
+void TxIndex::CustomPrepare(const interfaces::BlockInfo& block)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return;
+
+    // Entries of a block are independent from other blocks, so they can be
+    // written ahead of the block being appended. Entries written for a block
+    // that ends up reorganized away are harmless, as they are for a block
+    // disconnected after being appended.
+    if (WriteBlockTxs(block)) {
+        LOCK(m_prepared_blocks_mutex);
+        m_prepared_blocks.emplace(block.hash, block.height);
+    }
+}
+
+bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return true;
+
+    bool prepared{false};
+    {
+        LOCK(m_prepared_blocks_mutex);
+        prepared = m_prepared_blocks.erase(block.hash) > 0;
+        // Forget the blocks prepared on a chain that was reorganized away
+        for (auto stale = m_prepared_blocks.begin(); stale != m_prepared_blocks.end();) {
+            stale = stale->second <= block.height ? m_prepared_blocks.erase(stale) : std::next(stale);
+        }
+    }
+    return prepared || WriteBlockTxs(block);
+}
+
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
+bool TxIndex::FindCompactTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
+{
+    const uint64_t prefix{TxidPrefix(tx_hash)};
+    std::vector<CompactTxPos> positions;
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBPendingKey key;
+    for (db_it->Seek(DBPendingKey{{prefix, 0, 0}}); db_it->Valid() && db_it->GetKey(key) && key.pos.prefix == prefix; db_it->Next()) {
+        positions.push_back(key.pos);
+    }
+    try {
+        for (const auto& segment : WITH_LOCK(m_segments_mutex, return m_segments)) {
+            segment->Find(prefix, positions);
+        }
+    } catch (const std::exception& e) {
+        return error("%s: %s", __func__, e.what());
+    }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    // Several transactions may share the prefix, check the transaction at each position.
+    for (const auto& pos : positions) {
+        const CBlockIndex* pindex{WITH_LOCK(::cs_main, return m_chainstate->m_chain[int(pos.height)])};
+        if (!pindex) continue;
+        CBlock block;
+        if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            return error("%s: ReadBlockFromDisk failed for block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (pos.index < block.vtx.size() && block.vtx[pos.index]->GetHash() == tx_hash) {
+            block_hash = pindex->GetBlockHash();
+            tx = block.vtx[pos.index];
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Read a transaction out of a block read whole, for blocks in compressed block files. */
+static bool ReadTxFromRawBlock(const node::BlockManager& blockman, const CDiskTxPos& postx, CBlockHeader& header, CTransactionRef& tx)
+{
+    std::vector<uint8_t> block_data;
+    if (!blockman.ReadRawBlockFromDisk(block_data, postx)) {
+        return error("%s: ReadRawBlockFromDisk failed", __func__);
+    }
+    try {
+        SpanReader reader{CLIENT_VERSION, block_data};
+        reader >> header;
+        reader.ignore(postx.nTxOffset);
+        reader >> tx;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    return true;
+}
+
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
+    if (m_format == TxIndexFormat::COMPACT) {
+        return FindCompactTx(tx_hash, block_hash, tx);
+    }
+
     CDiskTxPos postx;
     if (!m_db->ReadTxPos(tx_hash, postx)) {
         return false;
     }
 
-    CAutoFile file{m_chainstate->m_blockman.OpenBlockFile(postx, true)};
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
-    }
+    const node::BlockManager& blockman{m_chainstate->m_blockman};
     CBlockHeader header;
-    try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
+    if (blockman.IsBlockFileCompressed(postx.nFile)) {
+        if (!ReadTxFromRawBlock(blockman, postx, header, tx)) return false;
+    } else {
+        CAutoFile file{blockman.OpenBlockFile(postx, true)};
+        if (file.IsNull()) {
+            // The block file may have been compressed since it was checked.
+            if (!blockman.IsBlockFileCompressed(postx.nFile)) {
+                return error("%s: OpenBlockFile failed", __func__);
+            }
+            if (!ReadTxFromRawBlock(blockman, postx, header, tx)) return false;
+        } else {
+            try {
+                file >> header;
+                if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
+                    return error("%s: fseek(...) failed", __func__);
+                }
+                file >> tx;
+            } catch (const std::exception& e) {
+                return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            }
         }
-        file >> tx;
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
     if (tx->GetHash() != tx_hash) {
         return error("%s: txid mismatch", __func__);
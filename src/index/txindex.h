@@ -6,13 +6,47 @@
 #define BITCOIN_INDEX_TXINDEX_H
 
 #include <index/base.h>
+#include <sync.h>
+#include <util/fs.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 static constexpr bool DEFAULT_TXINDEX{false};
 
+/** Storage format of the transaction index */
+enum class TxIndexFormat {
+    /// Disk location of each transaction, keyed by txid in LevelDB
+    LEVELDB,
+    /// Truncated txids with the height and position in the block of the transaction, in sorted segment files
+    COMPACT,
+};
+
+static constexpr TxIndexFormat DEFAULT_TXINDEX_FORMAT{TxIndexFormat::LEVELDB};
+/** Number of compact entries collected in LevelDB before they're written out as a segment file */
+static constexpr size_t TXINDEX_SEGMENT_ENTRIES{1 << 20};
+
+/** Get the name of a transaction index format. */
+const std::string& TxIndexFormatName(TxIndexFormat format);
+
+/** Find a transaction index format by its name. Returns false if the name is unknown. */
+bool TxIndexFormatByName(const std::string& name, TxIndexFormat& format);
+
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
- * The index is written to a LevelDB database and records the filesystem
- * location of each transaction by transaction hash.
+ *
+ * In the LEVELDB format, the index is written to a LevelDB database and
+ * records the filesystem location of each transaction by transaction hash.
+ *
+ * In the COMPACT format, the index records the leading 8 bytes of each txid
+ * with the height of the block and the position of the transaction in it, in
+ * 16 bytes per transaction. Entries are collected in LevelDB, then written out
+ * sorted to immutable segment files, which are merged as they pile up. Lookups
+ * read the candidate blocks of the active chain to resolve truncated txid
+ * collisions, so they are slower, and transactions of stale blocks aren't found.
  */
 class TxIndex final : public BaseIndex
 {
@@ -20,18 +54,62 @@ protected:
     class DB;
 
 private:
+    struct Segment;
+
+    const TxIndexFormat m_format;
+    /// Directory of the database and segment files of the COMPACT format.
+    const fs::path m_compact_dir;
+    /// Number of pending COMPACT entries to write out as a segment file.
+    const size_t m_segment_entries;
+
     const std::unique_ptr<DB> m_db;
 
+    /// Number of COMPACT entries in the database that aren't in a segment file yet.
+    std::atomic<uint64_t> m_pending_entries{0};
+
+    mutable Mutex m_segments_mutex;
+    /// Segment files of the COMPACT format that lookups go through.
+    std::vector<std::shared_ptr<const Segment>> m_segments GUARDED_BY(m_segments_mutex);
+
+    /// Segment files replaced by a merge, removed once the merge is committed
+    /// and no lookup is reading them. Only accessed when initializing or
+    /// committing the index.
+    std::vector<std::shared_ptr<const Segment>> m_obsolete_segments;
+    uint32_t m_next_segment_id{0};
+
+    Mutex m_prepared_blocks_mutex;
+    /// Blocks whose entries were written by CustomPrepare ahead of being appended, with their height.
+    std::map<uint256, int> m_prepared_blocks GUARDED_BY(m_prepared_blocks_mutex);
+
     bool AllowPrune() const override { return false; }
 
+    /// Write the disk location of each transaction of the block.
+    [[nodiscard]] bool WriteBlockTxs(const interfaces::BlockInfo& block);
+
+    /// Write the pending COMPACT entries out as a segment file, and merge
+    /// segment files as they pile up.
+    [[nodiscard]] bool WriteSegments(CDBBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(!m_segments_mutex);
+
+    /// Delete the files of the segments replaced by a committed merge.
+    void RemoveObsoleteSegments();
+
+    bool FindCompactTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const EXCLUSIVE_LOCKS_REQUIRED(!m_segments_mutex);
+
 protected:
-    bool CustomAppend(const interfaces::BlockInfo& block) override;
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_segments_mutex);
+
+    void CustomPrepare(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_blocks_mutex);
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_blocks_mutex);
+
+    bool CustomCommit(CDBBatch& batch) override EXCLUSIVE_LOCKS_REQUIRED(!m_segments_mutex);
 
     BaseIndex::DB& GetDB() const override;
 
 public:
     /// Constructs the index, which becomes available to be queried.
-    explicit TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    explicit TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false,
+                     TxIndexFormat format = DEFAULT_TXINDEX_FORMAT, size_t segment_entries = TXINDEX_SEGMENT_ENTRIES);
 
     // Destructor is declared because this class contains a unique_ptr to an incomplete type.
     virtual ~TxIndex() override;
@@ -42,7 +120,7 @@ public:
     /// @param[out]  block_hash  The hash of the block the transaction is found in.
     /// @param[out]  tx  The transaction itself.
     /// @return  true if transaction is found, false otherwise
-    bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+    bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const EXCLUSIVE_LOCKS_REQUIRED(!m_segments_mutex);
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
@@ -13,6 +13,7 @@
 #include <kernel/mempool_persist.h>
 #include <kernel/validation_cache_sizes.h>
 
+#include <addrdb.h>
 #include <addrman.h>
 #include <banman.h>
 #include <blockfilter.h>
@@ -23,12 +24,14 @@
 #include <common/args.h>
 #include <common/system.h>
 #include <consensus/amount.h>
+#include <dbwrapper.h>
 #include <deploymentstatus.h>
 #include <hash.h>
 #include <httprpc.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/scriptindex.h>
 #include <index/txindex.h>
 #include <init/common.h>
 #include <interfaces/chain.h>
@@ -41,6 +44,7 @@
 #include <net_processing.h>
 #include <netbase.h>
 #include <netgroup.h>
+#include <node/blockcompression.h>
 #include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
 #include <node/caches.h>
@@ -120,9 +124,11 @@ using kernel::LoadMempool;
 using kernel::ValidationCacheSizes;
 
 using node::ApplyArgsManOptions;
+using node::BLOCKFILE_CHUNK_SIZE;
 using node::BlockManager;
 using node::CacheSizes;
 using node::CalculateCacheSizes;
+using node::DEFAULT_BLOCK_COMPRESSION;
 using node::DEFAULT_PERSIST_MEMPOOL;
 using node::DEFAULT_PRINTPRIORITY;
 using node::DEFAULT_STOPATHEIGHT;
@@ -132,6 +138,7 @@ using node::LoadChainstate;
 using node::MempoolPath;
 using node::NodeContext;
 using node::ShouldPersistMempool;
+using node::UNDOFILE_CHUNK_SIZE;
 using node::ImportBlocks;
 using node::VerifyLoadedChainstate;
 
@@ -234,6 +241,9 @@ void Interrupt(NodeContext& node)
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
     }
+    if (g_scriptindex) {
+        g_scriptindex->Interrupt();
+    }
 }
 
 void Shutdown(NodeContext& node)
@@ -271,6 +281,8 @@ void Shutdown(NodeContext& node)
     // CScheduler/checkqueue, scheduler and load block thread.
     if (node.scheduler) node.scheduler->stop();
     if (node.chainman && node.chainman->m_thread_load.joinable()) node.chainman->m_thread_load.join();
+    if (node.chainman) node.chainman->StopBackgroundValidation();
+    if (node.chainman) node.chainman->m_blockman.StopBlockFileCompression();
     StopScriptCheckWorkerThreads();
 
     // After the threads that potentially access these pointers have been stopped,
@@ -311,6 +323,10 @@ void Shutdown(NodeContext& node)
         g_coin_stats_index->Stop();
         g_coin_stats_index.reset();
     }
+    if (g_scriptindex) {
+        g_scriptindex->Stop();
+        g_scriptindex.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -328,6 +344,7 @@ void Shutdown(NodeContext& node)
                 chainstate->ResetCoinsViews();
             }
         }
+        node.chainman->m_blockman.WriteBlockIndexSnapshot();
     }
     for (const auto& client : node.chain_clients) {
         client->stop();
@@ -436,6 +453,11 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-backgroundvalidationlatency=<n>", strprintf("While a UTXO snapshot is validated in the background, target time in milliseconds to connect new blocks to the chain. Background validation is throttled, and given less of the coins cache, when new blocks take longer (default: %d)", count_milliseconds(DEFAULT_BACKGROUND_VALIDATION_LATENCY)), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockcompression", strprintf("Compress block files in the background once they are complete, reads of blocks decompress only the part of the file they are in. Undo files are not compressed (default: %u)", DEFAULT_BLOCK_COMPRESSION), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockasyncflush", strprintf("Commit finished block and undo files to disk on a background thread, and start writing block and undo data back to disk as it is written (default: %u)", DEFAULT_BLOCK_ASYNC_FLUSH), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockfilechunksize=<n>", strprintf("Preallocate disk space in block files in chunks of <n> MiB (default: %u)", BLOCKFILE_CHUNK_SIZE >> 20), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockprefetch=<n>", strprintf("Number of blocks to read from disk ahead of the tip while connecting blocks that are already stored, as during -reindex-chainstate, 0 to disable (default: %d)", DEFAULT_BLOCK_PREFETCH), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-fastprune", "Use smaller block files and lower minimum prune height for testing purposes", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
 #if HAVE_SYSTEM
@@ -447,6 +469,11 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location (only useable from command line, not configuration file) (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbasyncwrite", strprintf("Write the batches of chainstate and index database flushes on a background thread while the next batch is prepared (default: %u)", DEFAULT_DB_ASYNC_WRITE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbblocksize=<n>", strprintf("Size in bytes of the blocks of the database table files (default: %u)", DEFAULT_DB_BLOCK_SIZE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbbloombits=<n>", strprintf("Bits per key of the bloom filters of the database table files, 0 to disable them (default: %d)", DEFAULT_DB_BLOOM_BITS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbmaxfilesize=<n>", strprintf("Size in bytes of the database table files (default: %u)", DEFAULT_DB_MAX_FILE_SIZE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbwritebuffersize=<n>", "Size in bytes of the in-memory database write buffer (default: a quarter of the database's cache)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-allowignoredconf", strprintf("For backwards compatibility, treat an unused %s file in the datadir as a warning, not an error.", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -459,17 +486,24 @@ void SetupServerArgs(ArgsManager& argsman)
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
-    argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex. "
+    argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex and -scriptindex. "
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >=%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex", "If enabled, wipe chain state and block index, and rebuild them from blk*.dat files on disk. Also wipe and rebuild other optional indexes that are active. If an assumeutxo snapshot was loaded, its chainstate will be wiped as well. The snapshot can then be reloaded via RPC.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex-chainstate", "If enabled, wipe chain state, and rebuild it from blk*.dat files on disk. If an assumeutxo snapshot was loaded, its chainstate will be wiped as well. The snapshot can then be reloaded via RPC.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-settings=<file>", strprintf("Specify path to dynamic settings data file. Can be disabled with -nosettings. File is written at runtime and not meant to be edited by users (use %s instead for custom settings). Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME, BITCOIN_SETTINGS_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-scriptindex", strprintf("Maintain an index of the outputs and spends of each scriptPubKey, used by the getscripthistory rpc call (default: %u)", DEFAULT_SCRIPTINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-startupnotify=<cmd>", "Execute command on startup.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-shutdownnotify=<cmd>", "Execute command immediately before beginning shutdown. The need for shutdown may be urgent, so be careful not to delay it long (if the command doesn't require interaction with the server, consider having it fork into the background).", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-txindexformat=<format>", strprintf("Storage format of the transaction index (default: %s). \"%s\" records the disk location of each transaction, "
+                                                        "\"%s\" records truncated txids with the block height and position of each transaction in a fraction of the space, "
+                                                        "at the cost of slower lookups that don't find transactions of stale blocks. Each format is built and kept separately.",
+                                                        TxIndexFormatName(DEFAULT_TXINDEX_FORMAT), TxIndexFormatName(TxIndexFormat::LEVELDB), TxIndexFormatName(TxIndexFormat::COMPACT)),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-undofilechunksize=<n>", strprintf("Preallocate disk space in undo files in chunks of <n> MiB (default: %u)", UNDOFILE_CHUNK_SIZE >> 20), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blockfilterindex=<type>",
                  strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
                  " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
@@ -495,10 +529,13 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-maxtimeadjustment", strprintf("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by outbound peers forward or backward by this amount (default: %u seconds).", DEFAULT_MAX_TIME_ADJUSTMENT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-maxuploadtarget=<n>", strprintf("Tries to keep outbound traffic under the given target per 24h. Limit does not apply to peers with 'download' permission or blocks created within past week. 0 = no limit (default: %s). Optional suffix units [k|K|m|M|g|G|t|T] (default: M). Lowercase is 1000 base while uppercase is 1024 base", DEFAULT_MAX_UPLOAD_TARGET), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onion=<ip:port>", "Use separate SOCKS5 proxy to reach peers via Tor onion services, set -noonion to disable (default: -proxy)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-fastblockrelay", strprintf("Announce new blocks to all peers, not only high-bandwidth compact block peers, once their proof of work has been checked and before they have been fully validated (default: %u)", DEFAULT_FAST_BLOCK_RELAY), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-headerssyncpeers=<n>", strprintf("Once a low-work headers sync has reached its work target, also fetch headers from up to <n> other outbound peers in parallel (default: %u)", DEFAULT_HEADERS_SYNC_PEERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-i2psam=<ip:port>", "I2P SAM proxy to reach I2P peers and accept I2P connections (default: none)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-i2pacceptincoming", strprintf("Whether to accept inbound I2P connections (default: %i). Ignored if -i2psam is not set. Listening for inbound I2P connections is done through the SAM proxy, not by binding to a local address and port.", DEFAULT_I2P_ACCEPT_INCOMING), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onlynet=<net>", "Make automatic outbound connections only to network <net> (" + Join(GetNetworkNames(), ", ") + "). Inbound and manual connections are not affected by this option. It can be specified multiple times to allow multiple networks.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-v2transport", strprintf("Support v2 transport (default: %u)", DEFAULT_V2_TRANSPORT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-peersjournal", strprintf("Persist changes to the address database by appending them to peers.journal, instead of rewriting peers.dat every time (default: %u)", DEFAULT_PEERS_JOURNAL), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerblockfilters", strprintf("Serve compact block filters to peers per BIP 157 (default: %u)", DEFAULT_PEERBLOCKFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-txreconciliation", strprintf("Enable transaction reconciliations per BIP 330 (default: %d)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
@@ -879,6 +916,11 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         return InitError(strprintf(_("Specified blocks directory \"%s\" does not exist."), args.GetArg("-blocksdir", "")));
     }
 
+    TxIndexFormat txindex_format;
+    if (!TxIndexFormatByName(args.GetArg("-txindexformat", TxIndexFormatName(DEFAULT_TXINDEX_FORMAT)), txindex_format)) {
+        return InitError(strprintf(_("Unknown -txindexformat value %s."), args.GetArg("-txindexformat", "")));
+    }
+
     // parse and validate enabled filter types
     std::string blockfilterindex_value = args.GetArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
     if (blockfilterindex_value == "" || blockfilterindex_value == "1") {
@@ -911,6 +953,8 @@ bool AppInitParameterInteraction(const ArgsManager& args)
     if (args.GetIntArg("-prune", 0)) {
         if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (args.GetBoolArg("-scriptindex", DEFAULT_SCRIPTINDEX))
+            return InitError(_("Prune mode is incompatible with -scriptindex."));
         if (args.GetBoolArg("-reindex-chainstate", false)) {
             return InitError(_("Prune mode is incompatible with -reindex-chainstate. Use full -reindex instead."));
         }
@@ -1456,6 +1500,9 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", cache_sizes.tx_index * (1.0 / 1024 / 1024));
     }
+    if (args.GetBoolArg("-scriptindex", DEFAULT_SCRIPTINDEX)) {
+        LogPrintf("* Using %.1f MiB for script index database\n", cache_sizes.script_index * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   cache_sizes.filter_index * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
@@ -1497,10 +1544,11 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
             // don't have any pending work.
             SyncWithValidationInterfaceQueue();
 
+            auto coordinator{std::make_shared<IndexSyncCoordinator>(node.chainman->m_blockman)};
             for (auto* index : node.indexes) {
                 index->Interrupt();
                 index->Stop();
-                if (!(index->Init() && index->StartBackgroundSync())) {
+                if (!(index->Init() && index->StartBackgroundSync(coordinator))) {
                     LogPrintf("[snapshot] WARNING failed to restart index %s on snapshot chain\n", index->GetName());
                 }
             }
@@ -1588,7 +1636,9 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     // ********************************************************* Step 8: start indexers
 
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
-        g_txindex = std::make_unique<TxIndex>(interfaces::MakeChain(node), cache_sizes.tx_index, false, fReindex);
+        TxIndexFormat txindex_format{DEFAULT_TXINDEX_FORMAT};
+        TxIndexFormatByName(args.GetArg("-txindexformat", TxIndexFormatName(DEFAULT_TXINDEX_FORMAT)), txindex_format);
+        g_txindex = std::make_unique<TxIndex>(interfaces::MakeChain(node), cache_sizes.tx_index, false, fReindex, txindex_format);
         node.indexes.emplace_back(g_txindex.get());
     }
 
@@ -1602,6 +1652,11 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         node.indexes.emplace_back(g_coin_stats_index.get());
     }
 
+    if (args.GetBoolArg("-scriptindex", DEFAULT_SCRIPTINDEX)) {
+        g_scriptindex = std::make_unique<ScriptIndex>(interfaces::MakeChain(node), cache_sizes.script_index, false, fReindex);
+        node.indexes.emplace_back(g_scriptindex.get());
+    }
+
     // Init indexes
     for (auto index : node.indexes) if (!index->Init()) return false;
 
@@ -1709,6 +1764,8 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
             pool->SetLoadTried(!chainman.m_interrupt);
         }
     });
+    chainman.StartBackgroundValidation();
+    chainman.m_blockman.StartBlockFileCompression();
 
     // Wait for genesis block to be processed
     {
@@ -1731,7 +1788,7 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     //// debug print
     {
         LOCK(cs_main);
-        LogPrintf("block tree size = %u\n", chainman.BlockIndex().size());
+        LogPrintf("block tree size = %u, using %.1f MiB\n", chainman.BlockIndex().size(), chainman.BlockIndex().DynamicMemoryUsage() * (1.0 / 1024 / 1024));
         chain_active_height = chainman.ActiveChain().Height();
         if (tip_info) {
             tip_info->block_height = chain_active_height;
@@ -1962,7 +2019,8 @@ bool StartIndexBackgroundSync(NodeContext& node)
         }
     }
 
-    // Start threads
-    for (auto index : node.indexes) if (!index->StartBackgroundSync()) return false;
+    // Start threads, sharing the blocks read for the indexes that are behind
+    auto coordinator{std::make_shared<IndexSyncCoordinator>(chainman.m_blockman)};
+    for (auto index : node.indexes) if (!index->StartBackgroundSync(coordinator)) return false;
     return true;
 }
@@ -9,9 +9,12 @@
 #include <util/fs.h>
 
 #include <cstdint>
+#include <optional>
 
 class CChainParams;
 
+static constexpr bool DEFAULT_BLOCK_ASYNC_FLUSH{true};
+
 namespace kernel {
 
 /**
@@ -22,6 +25,15 @@ struct BlockManagerOpts {
     const CChainParams& chainparams;
     uint64_t prune_target{0};
     bool fast_prune{false};
+    //! Replace finalized block files by compressed files in the background
+    bool compress_block_files{false};
+    //! Commit finished block and undo files to disk on a background thread,
+    //! and start writing block and undo data back to disk as it is written
+    bool async_flush{DEFAULT_BLOCK_ASYNC_FLUSH};
+    //! Disk space is preallocated in block and undo files in multiples of
+    //! these sizes, BLOCKFILE_CHUNK_SIZE and UNDOFILE_CHUNK_SIZE if unset
+    std::optional<uint32_t> block_file_chunk_size{};
+    std::optional<uint32_t> undo_file_chunk_size{};
     const fs::path blocks_dir;
     Notifications& notifications;
 };
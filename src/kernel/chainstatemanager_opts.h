@@ -21,6 +21,8 @@ class CChainParams;
 
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
+static constexpr std::chrono::milliseconds DEFAULT_BACKGROUND_VALIDATION_LATENCY{2s};
+static constexpr int DEFAULT_BLOCK_PREFETCH{8};
 
 namespace kernel {
 
@@ -41,6 +43,10 @@ struct ChainstateManagerOpts {
     std::optional<uint256> assumed_valid_block{};
     //! If the tip is older than this, the node is considered to be in initial block download.
     std::chrono::seconds max_tip_age{DEFAULT_MAX_TIP_AGE};
+    //! Target time to connect new blocks while a snapshot is validated in the background.
+    std::chrono::milliseconds background_validation_latency{DEFAULT_BACKGROUND_VALIDATION_LATENCY};
+    //! Number of blocks read from disk ahead of the tip while connecting blocks, zero to disable.
+    int block_prefetch{DEFAULT_BLOCK_PREFETCH};
     DBOptions block_tree_db{};
     DBOptions coins_db{};
     CoinsViewOptions coins_view{};
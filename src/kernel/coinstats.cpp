@@ -17,9 +17,11 @@
 #include <streams.h>
 #include <sync.h>
 #include <tinyformat.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <util/check.h>
 #include <util/overflow.h>
+#include <util/parallel.h>
 #include <validation.h>
 #include <version.h>
 
@@ -75,6 +77,11 @@ void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& c
     muhash.Remove(MakeUCharSpan(ss));
 }
 
+static void ApplyCoinHash(DataStream& ss, const COutPoint& outpoint, const Coin& coin)
+{
+    TxOutSer(ss, outpoint, coin);
+}
+
 static void ApplyCoinHash(std::nullptr_t, const COutPoint& outpoint, const Coin& coin) {}
 
 //! Warning: be very careful when changing this! assumeutxo and UTXO snapshot
@@ -112,13 +119,10 @@ static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<u
     }
 }
 
-//! Calculate statistics about the unspent transaction output set
+//! Add the statistics of the coins of a cursor to stats, and apply them to the hash
 template <typename T>
-static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+static bool ApplyCursorStats(CCoinsViewCursor* pcursor, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
-
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
@@ -143,6 +147,68 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
         ApplyStats(stats, prevkey, outputs);
         ApplyHash(hash_obj, prevkey, outputs);
     }
+    return true;
+}
+
+//! Calculate statistics about the unspent transaction output set
+template <typename T>
+static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+{
+    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+    assert(pcursor);
+
+    if (!ApplyCursorStats(pcursor.get(), stats, hash_obj, interruption_point)) return false;
+
+    FinalizeHash(hash_obj, stats);
+
+    stats.nDiskSize = view->EstimateSize();
+
+    return true;
+}
+
+static void MergeStats(CCoinsStats& stats, const CCoinsStats& partition_stats)
+{
+    stats.nTransactions += partition_stats.nTransactions;
+    stats.nTransactionOutputs += partition_stats.nTransactionOutputs;
+    stats.nBogoSize += partition_stats.nBogoSize;
+    stats.coins_count += partition_stats.coins_count;
+    if (stats.total_amount.has_value()) {
+        stats.total_amount = partition_stats.total_amount ? CheckedAdd(*stats.total_amount, *partition_stats.total_amount) : std::nullopt;
+    }
+}
+
+//! The serialized hash is computed over the coins in key order, so the
+//! partitions only serialize their coins, which are hashed in order.
+static void MergeHash(HashWriter& ss, const DataStream& partition_ss) { ss.write(MakeByteSpan(partition_ss)); }
+static void MergeHash(MuHash3072& muhash, const MuHash3072& partition_muhash) { muhash *= partition_muhash; }
+static void MergeHash(std::nullptr_t, std::nullptr_t) {}
+
+//! Calculate statistics about the unspent transaction output set, going over
+//! the partitions of the coins database on several threads.
+template <typename T, typename PartitionHash>
+static bool ComputeUTXOStats(CCoinsViewDB* view, CCoinsStats& stats, T hash_obj, PartitionHash, const std::function<void()>& interruption_point, int num_threads)
+{
+    struct PartitionStats {
+        bool success;
+        CCoinsStats stats;
+        PartitionHash hash_obj;
+    };
+
+    const auto cursors{view->PartitionCursors()};
+    bool success{true};
+    util::ParallelForOrdered(
+        "coinstats", cursors.size(), num_threads,
+        [&](size_t i) {
+            PartitionStats partition{true, CCoinsStats{}, PartitionHash{}};
+            partition.success = ApplyCursorStats(cursors[i].get(), partition.stats, partition.hash_obj, interruption_point);
+            return partition;
+        },
+        [&](PartitionStats&& partition) {
+            success &= partition.success;
+            MergeStats(stats, partition.stats);
+            MergeHash(hash_obj, partition.hash_obj);
+        });
+    if (!success) return false;
 
     FinalizeHash(hash_obj, stats);
 
@@ -179,6 +245,34 @@ std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsV
     return stats;
 }
 
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsViewDB* view, node::BlockManager& blockman, const std::function<void()>& interruption_point, int num_threads)
+{
+    CBlockIndex* pindex = WITH_LOCK(::cs_main, return blockman.LookupBlockIndex(view->GetBestBlock()));
+    CCoinsStats stats{Assert(pindex)->nHeight, pindex->GetBlockHash()};
+
+    bool success = [&]() -> bool {
+        switch (hash_type) {
+        case(CoinStatsHashType::HASH_SERIALIZED): {
+            HashWriter ss{};
+            return ComputeUTXOStats(view, stats, ss, DataStream{}, interruption_point, num_threads);
+        }
+        case(CoinStatsHashType::MUHASH): {
+            MuHash3072 muhash;
+            return ComputeUTXOStats(view, stats, muhash, MuHash3072{}, interruption_point, num_threads);
+        }
+        case(CoinStatsHashType::NONE): {
+            return ComputeUTXOStats(view, stats, nullptr, nullptr, interruption_point, num_threads);
+        }
+        } // no default case, so the compiler can warn about missing cases
+        assert(false);
+    }();
+
+    if (!success) {
+        return std::nullopt;
+    }
+    return stats;
+}
+
 static void FinalizeHash(HashWriter& ss, CCoinsStats& stats)
 {
     stats.hashSerialized = ss.GetHash();
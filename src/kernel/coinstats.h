@@ -15,6 +15,7 @@
 #include <optional>
 
 class CCoinsView;
+class CCoinsViewDB;
 class Coin;
 class COutPoint;
 class CScript;
@@ -77,6 +78,10 @@ void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& co
 void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 
 std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
+
+//! Compute the statistics over the partitions of a coins database on
+//! num_threads threads. The interruption point is called from all of them.
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsViewDB* view, node::BlockManager& blockman, const std::function<void()>& interruption_point, int num_threads);
 } // namespace kernel
 
 #endif // BITCOIN_KERNEL_COINSTATS_H
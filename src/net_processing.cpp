@@ -27,6 +27,7 @@
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <pow.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <random.h>
@@ -112,6 +113,7 @@ static constexpr auto BLOCK_STALLING_TIMEOUT_MAX{64s};
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
  *  less than this number, we reached its tip. Changing this value is a protocol upgrade. */
 static const unsigned int MAX_HEADERS_RESULTS = 2000;
+static_assert(HEADERS_SYNC_SEGMENT_SIZE == MAX_HEADERS_RESULTS, "headers sync segments must be full headers messages");
 /** Maximum depth of blocks we're willing to serve as compact blocks to peers
  *  when requested. For older blocks, a regular BLOCK response will be sent. */
 static const int MAX_CMPCTBLOCK_DEPTH = 5;
@@ -236,6 +238,10 @@ struct Peer {
      * message. If we can't announce via a `headers` message, we'll fall back to
      * announcing via `inv`. */
     std::vector<uint256> m_blocks_for_headers_relay GUARDED_BY(m_block_inv_mutex);
+    /** A PoW-valid block that we'd like to announce to this low-bandwidth peer
+     * before it has been connected (see -fastblockrelay). Null if there is
+     * nothing pending. */
+    uint256 m_fast_announce_block GUARDED_BY(m_block_inv_mutex);
     /** The final block hash that we sent in an `inv` message to this peer.
      * When the peer requests this block, we send an `inv` message to trigger
      * the peer to request the next sequence of block hashes.
@@ -375,6 +381,20 @@ struct Peer {
      * reorgs) **/
     std::unique_ptr<HeadersSyncState> m_headers_sync PT_GUARDED_BY(m_headers_sync_mutex) GUARDED_BY(m_headers_sync_mutex) {};
 
+    /** A segment of another peer's low-work headers sync that we asked this
+     * peer for, see RequestHeadersSegments(). */
+    struct HeadersSegmentRequest {
+        /** The peer whose headers sync the segment is for */
+        NodeId sync_peer;
+        /** Index of the segment in that headers sync */
+        size_t index;
+        /** Hash of the header the segment builds on, sent as locator */
+        uint256 locator;
+        /** When the getheaders was sent */
+        NodeClock::time_point time;
+    };
+    std::optional<HeadersSegmentRequest> m_headers_segment_request GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+
     /** Whether we've sent our peer a sendheaders message. **/
     std::atomic<bool> m_sent_sendheaders{false};
 
@@ -485,7 +505,7 @@ public:
 
     /** Overridden from CValidationInterface. */
     void BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected) override
-        EXCLUSIVE_LOCKS_REQUIRED(!m_recent_confirmed_transactions_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex);
     void BlockDisconnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex* pindex) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_recent_confirmed_transactions_mutex);
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override
@@ -493,7 +513,7 @@ public:
     void BlockChecked(const CBlock& block, const BlockValidationState& state) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override
-        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex);
 
     /** Implement NetEventsInterface */
     void InitializeNode(CNode& node, ServiceFlags our_services) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
@@ -607,8 +627,6 @@ private:
      * occasional non-connecting header (this can happen due to BIP 130 headers
      * announcements for blocks interacting with the 2hr (MAX_FUTURE_BLOCK_TIME) rule). */
     void HandleFewUnconnectingHeaders(CNode& pfrom, Peer& peer, const std::vector<CBlockHeader>& headers) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
-    /** Return true if the headers connect to each other, false otherwise */
-    bool CheckHeadersAreContinuous(const std::vector<CBlockHeader>& headers) const;
     /** Try to continue a low-work headers sync that has already begun.
      * Assumes the caller has already verified the headers connect, and has
      * checked that each header satisfies the proof-of-work target included in
@@ -629,7 +647,21 @@ private:
      */
     bool IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfrom,
             std::vector<CBlockHeader>& headers)
-        EXCLUSIVE_LOCKS_REQUIRED(peer.m_headers_sync_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_headers_sync_mutex, !m_peer_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
+    /** During the REDOWNLOAD phase of a low-work headers sync, ask other
+     * outbound peers for the segments of the chain following the one being
+     * redownloaded, with at most m_opts.headers_sync_peers requests in flight.
+     */
+    void RequestHeadersSegments(Peer& sync_peer)
+        EXCLUSIVE_LOCKS_REQUIRED(sync_peer.m_headers_sync_mutex, !m_peer_mutex, g_msgproc_mutex);
+    /** Pass headers that answer a getheaders sent by RequestHeadersSegments()
+     * to the headers sync they were requested for.
+     *
+     * @return      True if the headers were such an answer, and need no
+     *              further processing.
+     */
+    bool MaybeProcessHeadersSegment(Peer& peer, std::vector<CBlockHeader>& headers)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex);
     /** Check work on a headers chain to be processed, and if insufficient,
      * initiate our anti-DoS headers sync mechanism.
      *
@@ -845,6 +877,10 @@ private:
     Mutex m_most_recent_block_mutex;
     std::shared_ptr<const CBlock> m_most_recent_block GUARDED_BY(m_most_recent_block_mutex);
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> m_most_recent_compact_block GUARDED_BY(m_most_recent_block_mutex);
+    /** m_most_recent_compact_block serialized once as a CMPCTBLOCK message, shared by all announcements */
+    std::shared_ptr<const CSerializedNetMsg> m_most_recent_compact_block_msg GUARDED_BY(m_most_recent_block_mutex);
+    /** When NewPoWValidBlock was called for m_most_recent_block, used for relay latency logging */
+    SteadyClock::time_point m_most_recent_block_time GUARDED_BY(m_most_recent_block_mutex);
     uint256 m_most_recent_block_hash GUARDED_BY(m_most_recent_block_mutex);
     std::unique_ptr<const std::map<uint256, CTransactionRef>> m_most_recent_block_txs GUARDED_BY(m_most_recent_block_mutex);
 
@@ -1946,6 +1982,14 @@ void PeerManagerImpl::BlockConnected(
     }
     m_orphanage.EraseForBlock(*pblock);
 
+    {
+        LOCK(m_most_recent_block_mutex);
+        if (m_most_recent_block_hash == pindex->GetBlockHash()) {
+            LogPrint(BCLog::CMPCTBLOCK, "Block %s connected %.2fms after it was fast-announced\n",
+                     m_most_recent_block_hash.ToString(), Ticks<MillisecondsDouble>(SteadyClock::now() - m_most_recent_block_time));
+        }
+    }
+
     {
         LOCK(m_recent_confirmed_transactions_mutex);
         for (const auto& ptx : pblock->vtx) {
@@ -1980,10 +2024,12 @@ void PeerManagerImpl::BlockDisconnected(const std::shared_ptr<const CBlock> &blo
 
 /**
  * Maintain state about the best-seen block and fast-announce a compact block
- * to compatible peers.
+ * to compatible peers. With -fastblockrelay, low-bandwidth peers are also
+ * queued for an announcement before the block has been connected.
  */
 void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock)
 {
+    const auto time_start{SteadyClock::now()};
     auto pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs>(*pblock);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
 
@@ -1996,8 +2042,11 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
     if (!DeploymentActiveAt(*pindex, m_chainman, Consensus::DEPLOYMENT_SEGWIT)) return;
 
     uint256 hashBlock(pblock->GetHash());
-    const std::shared_future<CSerializedNetMsg> lazy_ser{
-        std::async(std::launch::deferred, [&] { return msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock); })};
+    // Serialize once; the same message is reused for every CMPCTBLOCK announcement
+    // of this block, including the ones made later from SendMessages and
+    // ProcessGetBlockData.
+    auto ser_cmpctblock{std::make_shared<const CSerializedNetMsg>(msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock))};
+    const auto time_serialized{SteadyClock::now()};
 
     {
         auto most_recent_block_txs = std::make_unique<std::map<uint256, CTransactionRef>>();
@@ -2010,10 +2059,14 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         m_most_recent_block_hash = hashBlock;
         m_most_recent_block = pblock;
         m_most_recent_compact_block = pcmpctblock;
+        m_most_recent_compact_block_msg = ser_cmpctblock;
         m_most_recent_block_txs = std::move(most_recent_block_txs);
+        m_most_recent_block_time = time_start;
     }
 
-    m_connman.ForEachNode([this, pindex, &lazy_ser, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    int num_hb_peers{0};
+    int num_lb_peers{0};
+    m_connman.ForEachNode([this, pindex, &ser_cmpctblock, &hashBlock, &num_hb_peers, &num_lb_peers](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
 
         if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
@@ -2022,16 +2075,31 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         CNodeState &state = *State(pnode->GetId());
         // If the peer has, or we announced to them the previous block already,
         // but we don't think they have this one, go ahead and announce it
-        if (state.m_requested_hb_cmpctblocks && !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
+        if (PeerHasHeader(&state, pindex) || !PeerHasHeader(&state, pindex->pprev)) return;
+        if (state.m_requested_hb_cmpctblocks) {
 
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
 
-            const CSerializedNetMsg& ser_cmpctblock{lazy_ser.get()};
-            m_connman.PushMessage(pnode, ser_cmpctblock.Copy());
+            m_connman.PushMessage(pnode, ser_cmpctblock->Copy());
             state.pindexBestHeaderSent = pindex;
+            ++num_hb_peers;
+        } else if (m_opts.fast_block_relay) {
+            // Whether the announcement is made via headers or inv depends on
+            // the peer's preferences, which are only accessible from the
+            // message handler thread, so leave the actual sending to SendMessages.
+            PeerRef peer{GetPeerRef(pnode->GetId())};
+            if (!peer) return;
+            LOCK(peer->m_block_inv_mutex);
+            peer->m_fast_announce_block = hashBlock;
+            ++num_lb_peers;
         }
     });
+    if (num_lb_peers > 0) m_connman.WakeMessageHandler();
+
+    LogPrint(BCLog::CMPCTBLOCK, "Fast-announced block %s: serialized in %.2fms, %d high-bandwidth peers, %d low-bandwidth peers queued, total %.2fms\n",
+             hashBlock.ToString(), Ticks<MillisecondsDouble>(time_serialized - time_start),
+             num_hb_peers, num_lb_peers, Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
 }
 
 /**
@@ -2224,10 +2292,26 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
 {
     std::shared_ptr<const CBlock> a_recent_block;
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> a_recent_compact_block;
+    std::shared_ptr<const CSerializedNetMsg> a_recent_compact_block_msg;
     {
         LOCK(m_most_recent_block_mutex);
         a_recent_block = m_most_recent_block;
         a_recent_compact_block = m_most_recent_compact_block;
+        a_recent_compact_block_msg = m_most_recent_compact_block_msg;
+    }
+
+    // With -fastblockrelay, a compact block request for the block we just
+    // fast-announced is answered from the cache right away, instead of
+    // waiting for ActivateBestChain to finish connecting it.
+    if (m_opts.fast_block_relay && inv.IsMsgCmpctBlk() && a_recent_compact_block_msg &&
+        a_recent_compact_block->header.GetHash() == inv.hash) {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = m_chainman.m_blockman.LookupBlockIndex(inv.hash);
+        if (pindex && !(pindex->nStatus & BLOCK_FAILED_MASK) && (pindex->nStatus & BLOCK_HAVE_DATA)) {
+            LogPrint(BCLog::CMPCTBLOCK, "Serving fast-announced compact block %s to peer=%d\n", inv.hash.ToString(), pfrom.GetId());
+            m_connman.PushMessage(&pfrom, a_recent_compact_block_msg->Copy());
+            return;
+        }
     }
 
     bool need_activate_chain = false;
@@ -2341,8 +2425,8 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             // and we don't feel like constructing the object for them, so
             // instead we respond with the full, non-compact block.
             if (CanDirectFetch() && pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_CMPCTBLOCK_DEPTH) {
-                if (a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
+                if (a_recent_compact_block_msg && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
+                    m_connman.PushMessage(&pfrom, a_recent_compact_block_msg->Copy());
                 } else {
                     CBlockHeaderAndShortTxIDs cmpctblock{*pblock};
                     m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, cmpctblock));
@@ -2484,14 +2568,25 @@ void PeerManagerImpl::SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlo
 
 bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
 {
-    // Do these headers have proof-of-work matching what's claimed?
-    if (!HasValidProofOfWork(headers, consensusParams)) {
-        Misbehaving(peer, 100, "header with invalid proof of work");
-        return false;
+    // Both checks need the hash of every header, so compute them in a single
+    // pass over the headers.
+    bool continuous{true};
+    uint256 hashLastBlock;
+    for (const CBlockHeader& header : headers) {
+        const uint256 hash{header.GetHash()};
+        // Do these headers have proof-of-work matching what's claimed?
+        if (!CheckProofOfWork(hash, header.nBits, consensusParams)) {
+            Misbehaving(peer, 100, "header with invalid proof of work");
+            return false;
+        }
+        // Are these headers connected to each other?
+        if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+            continuous = false;
+        }
+        hashLastBlock = hash;
     }
 
-    // Are these headers connected to each other?
-    if (!CheckHeadersAreContinuous(headers)) {
+    if (!continuous) {
         Misbehaving(peer, 20, "non-continuous headers sequence");
         return false;
     }
@@ -2549,18 +2644,6 @@ void PeerManagerImpl::HandleFewUnconnectingHeaders(CNode& pfrom, Peer& peer,
     }
 }
 
-bool PeerManagerImpl::CheckHeadersAreContinuous(const std::vector<CBlockHeader>& headers) const
-{
-    uint256 hashLastBlock;
-    for (const CBlockHeader& header : headers) {
-        if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
-            return false;
-        }
-        hashLastBlock = header.GetHash();
-    }
-    return true;
-}
-
 bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfrom, std::vector<CBlockHeader>& headers)
 {
     if (peer.m_headers_sync) {
@@ -2585,6 +2668,9 @@ bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfro
                             locator.vHave.front().ToString(), pfrom.GetId());
                 }
             }
+            // Fetch the segments after the one we just asked for from other
+            // peers in the meantime.
+            RequestHeadersSegments(peer);
         }
 
         if (peer.m_headers_sync->GetState() == HeadersSyncState::State::FINAL) {
@@ -2647,6 +2733,77 @@ bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfro
     return false;
 }
 
+void PeerManagerImpl::RequestHeadersSegments(Peer& sync_peer)
+{
+    if (m_opts.headers_sync_peers == 0 || !sync_peer.m_headers_sync) return;
+    auto segments{sync_peer.m_headers_sync->GetSegmentsToFetch()};
+    if (segments.empty()) return;
+
+    const auto current_time{NodeClock::now()};
+    uint32_t num_requests{0};
+    std::vector<PeerRef> idle_peers;
+    {
+        LOCK(m_peer_mutex);
+        for (const auto& [id, peer] : m_peer_map) {
+            if (id == sync_peer.m_id) continue;
+            auto& request{peer->m_headers_segment_request};
+            if (request && current_time - request->time > HEADERS_RESPONSE_TIME) {
+                LogPrint(BCLog::NET, "Timeout fetching headers segment %u of headers sync with peer=%d from peer=%d\n", request->index, request->sync_peer, id);
+                request.reset();
+            }
+            if (!request) {
+                idle_peers.push_back(peer);
+            } else if (request->sync_peer == sync_peer.m_id) {
+                ++num_requests;
+                segments.erase(std::remove_if(segments.begin(), segments.end(),
+                                              [&](const auto& segment) { return segment.first == request->index; }),
+                               segments.end());
+            }
+        }
+    }
+
+    auto next_segment{segments.begin()};
+    for (const PeerRef& peer : idle_peers) {
+        if (num_requests >= m_opts.headers_sync_peers || next_segment == segments.end()) break;
+        const auto& [index, locator_hash] = *next_segment;
+        const bool sent{m_connman.ForNode(peer->m_id, [&](CNode* node) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) {
+            if (!node->IsFullOutboundConn() || node->fDisconnect) return false;
+            return MaybeSendGetHeaders(*node, CBlockLocator{{locator_hash}}, *peer);
+        })};
+        if (!sent) continue;
+        LogPrint(BCLog::NET, "Requesting headers segment %u of headers sync with peer=%d from peer=%d\n", index, sync_peer.m_id, peer->m_id);
+        peer->m_headers_segment_request = Peer::HeadersSegmentRequest{sync_peer.m_id, index, locator_hash, current_time};
+        ++num_requests;
+        ++next_segment;
+    }
+}
+
+bool PeerManagerImpl::MaybeProcessHeadersSegment(Peer& peer, std::vector<CBlockHeader>& headers)
+{
+    if (!peer.m_headers_segment_request) return false;
+    const auto request{*peer.m_headers_segment_request};
+
+    // An empty response means the peer doesn't have the segment. Headers not
+    // building on the requested one, e.g. a block announcement, aren't a
+    // response at all.
+    if (headers.empty()) peer.m_headers_segment_request.reset();
+    if (headers.empty() || headers.front().hashPrevBlock != request.locator) return false;
+    peer.m_headers_segment_request.reset();
+
+    if (!CheckHeadersPoW(headers, m_chainparams.GetConsensus(), peer)) return true;
+
+    bool added{false};
+    if (PeerRef sync_peer{GetPeerRef(request.sync_peer)}) {
+        LOCK(sync_peer->m_headers_sync_mutex);
+        if (sync_peer->m_headers_sync) {
+            added = sync_peer->m_headers_sync->AddFetchedSegment(request.index, std::move(headers));
+        }
+    }
+    LogPrint(BCLog::NET, "%s headers segment %u of headers sync with peer=%d from peer=%d\n",
+             added ? "Received" : "Ignoring", request.index, request.sync_peer, peer.m_id);
+    return true;
+}
+
 bool PeerManagerImpl::TryLowWorkHeadersSync(Peer& peer, CNode& pfrom, const CBlockIndex* chain_start_header, std::vector<CBlockHeader>& headers)
 {
     // Calculate the total work on this chain.
@@ -4659,6 +4816,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
         }
 
+        if (MaybeProcessHeadersSegment(*peer, headers)) return;
+
         ProcessHeadersMessage(pfrom, *peer, std::move(headers), /*via_compact_block=*/false);
 
         // Check if the headers presync progress needs to be reported to validation.
@@ -5598,6 +5757,32 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
             }
         }
 
+        //
+        // Announce a block queued by NewPoWValidBlock ahead of its connection
+        //
+        if (m_opts.fast_block_relay) {
+            LOCK(peer->m_block_inv_mutex);
+            if (!peer->m_fast_announce_block.IsNull()) {
+                const CBlockIndex* pindex = m_chainman.m_blockman.LookupBlockIndex(peer->m_fast_announce_block);
+                // Only announce if it is still a candidate and nothing
+                // (including the regular announcement) beat us to it.
+                if (pindex && !(pindex->nStatus & BLOCK_FAILED_MASK) &&
+                    !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
+                    if (peer->m_prefers_headers) {
+                        LogPrint(BCLog::NET, "%s: fast-announcing header %s to peer=%d\n", __func__,
+                                 pindex->GetBlockHash().ToString(), pto->GetId());
+                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, std::vector<CBlock>{pindex->GetBlockHeader()}));
+                    } else {
+                        LogPrint(BCLog::NET, "%s: fast-announcing inv %s to peer=%d\n", __func__,
+                                 pindex->GetBlockHash().ToString(), pto->GetId());
+                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::INV, std::vector<CInv>{CInv{MSG_BLOCK, pindex->GetBlockHash()}}));
+                    }
+                    state.pindexBestHeaderSent = pindex;
+                }
+                peer->m_fast_announce_block.SetNull();
+            }
+        }
+
         //
         // Try sending block announcements via headers
         //
@@ -5671,15 +5856,15 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", __func__,
                             vHeaders.front().GetHash().ToString(), pto->GetId());
 
-                    std::optional<CSerializedNetMsg> cached_cmpctblock_msg;
+                    std::shared_ptr<const CSerializedNetMsg> cached_cmpctblock_msg;
                     {
                         LOCK(m_most_recent_block_mutex);
                         if (m_most_recent_block_hash == pBestIndex->GetBlockHash()) {
-                            cached_cmpctblock_msg = msgMaker.Make(NetMsgType::CMPCTBLOCK, *m_most_recent_compact_block);
+                            cached_cmpctblock_msg = m_most_recent_compact_block_msg;
                         }
                     }
-                    if (cached_cmpctblock_msg.has_value()) {
-                        m_connman.PushMessage(pto, std::move(cached_cmpctblock_msg.value()));
+                    if (cached_cmpctblock_msg) {
+                        m_connman.PushMessage(pto, cached_cmpctblock_msg->Copy());
                     } else {
                         CBlock block;
                         const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(block, *pBestIndex)};
@@ -25,6 +25,10 @@ static const bool DEFAULT_PEERBLOOMFILTERS = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
 static const int DISCOURAGEMENT_THRESHOLD{100};
+/** Whether low-bandwidth peers are announced new blocks before they are fully validated */
+static const bool DEFAULT_FAST_BLOCK_RELAY{false};
+/** Default for -headerssyncpeers, number of other outbound peers that segments of a low-work headers sync are fetched from in parallel */
+static const uint32_t DEFAULT_HEADERS_SYNC_PEERS{0};
 /** Maximum number of outstanding CMPCTBLOCK requests for the same block. */
 static const unsigned int MAX_CMPCTBLOCKS_INFLIGHT_PER_BLOCK = 3;
 
@@ -58,6 +62,12 @@ public:
         uint32_t max_extra_txs{DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN};
         //! Whether all P2P messages are captured to disk
         bool capture_messages{false};
+        //! Whether to announce PoW-valid blocks to low-bandwidth peers, and
+        //! serve them compact blocks, before the block has been connected
+        bool fast_block_relay{DEFAULT_FAST_BLOCK_RELAY};
+        //! Number of other outbound peers to fetch segments of a low-work
+        //! headers sync from, once the sync has reached its work target
+        uint32_t headers_sync_peers{DEFAULT_HEADERS_SYNC_PEERS};
         //! Whether or not the internal RNG behaves deterministically (this is
         //! a test-only option).
         bool deterministic_rng{false};
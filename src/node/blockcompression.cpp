@@ -0,0 +1,279 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockcompression.h>
+
+#include <logging.h>
+#include <util/fs_helpers.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+
+namespace node {
+namespace {
+//! Magic bytes and format version at the start of compressed block files
+constexpr std::array<std::byte, 4> COMPRESSED_FILE_MAGIC{std::byte{'b'}, std::byte{'l'}, std::byte{'z'}, std::byte{1}};
+//! Size of the header: magic, frame size, uncompressed size and frame index offset
+constexpr uint64_t COMPRESSED_FILE_HEADER_SIZE{4 + 4 + 8 + 8};
+constexpr uint32_t MIN_FRAME_SIZE{1 << 12};
+constexpr uint32_t MAX_FRAME_SIZE{1 << 24};
+//! Block files are at most 128 MiB, refuse to read indexes of much larger files
+constexpr uint64_t MAX_UNCOMPRESSED_SIZE{uint64_t{1} << 32};
+
+constexpr size_t MIN_MATCH{4};
+constexpr size_t MAX_OFFSET{0xffff};
+constexpr int HASH_BITS{14};
+
+uint32_t ReadWord(const std::byte* p)
+{
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+void WriteLength(std::vector<std::byte>& out, size_t length)
+{
+    for (; length >= 255; length -= 255) out.push_back(std::byte{255});
+    out.push_back(std::byte(length));
+}
+
+//! Append a sequence of literals, followed by a match unless match_length is 0.
+void WriteSequence(std::vector<std::byte>& out, Span<const std::byte> literals, size_t offset, size_t match_length)
+{
+    const size_t match_code{match_length ? match_length - MIN_MATCH : 0};
+    out.push_back(std::byte(std::min<size_t>(literals.size(), 15) << 4 | std::min<size_t>(match_code, 15)));
+    if (literals.size() >= 15) WriteLength(out, literals.size() - 15);
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match_length == 0) return;
+    out.push_back(std::byte(offset & 0xff));
+    out.push_back(std::byte(offset >> 8));
+    if (match_code >= 15) WriteLength(out, match_code - 15);
+}
+
+bool ReadLength(Span<const std::byte>& in, size_t& length)
+{
+    while (true) {
+        if (in.empty()) return false;
+        const auto byte{std::to_integer<size_t>(in[0])};
+        in = in.subspan(1);
+        length += byte;
+        if (byte != 255) return true;
+    }
+}
+
+uint64_t FrameSize(uint64_t size, uint32_t frame_size, size_t frame)
+{
+    return std::min<uint64_t>(frame_size, size - frame * uint64_t{frame_size});
+}
+} // namespace
+
+std::optional<std::vector<std::byte>> CompressFrame(Span<const std::byte> in)
+{
+    std::vector<std::byte> out;
+    out.reserve(in.size());
+    std::vector<uint32_t> table(size_t{1} << HASH_BITS);
+    size_t anchor{0};
+    size_t pos{0};
+    while (pos + MIN_MATCH <= in.size()) {
+        if (out.size() >= in.size()) return std::nullopt;
+        const uint32_t word{ReadWord(in.data() + pos)};
+        const uint32_t hash{(word * 2654435761U) >> (32 - HASH_BITS)};
+        const size_t candidate{table[hash]};
+        table[hash] = pos;
+        if (candidate < pos && pos - candidate <= MAX_OFFSET && ReadWord(in.data() + candidate) == word) {
+            size_t length{MIN_MATCH};
+            while (pos + length < in.size() && in[candidate + length] == in[pos + length]) ++length;
+            WriteSequence(out, in.subspan(anchor, pos - anchor), pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        } else {
+            // Skip faster through data that doesn't compress.
+            pos += 1 + ((pos - anchor) >> 6);
+        }
+    }
+    WriteSequence(out, in.subspan(anchor), 0, 0);
+    if (out.size() >= in.size()) return std::nullopt;
+    return out;
+}
+
+bool DecompressFrame(Span<const std::byte> in, Span<std::byte> out)
+{
+    size_t written{0};
+    while (!in.empty()) {
+        const auto token{std::to_integer<uint8_t>(in[0])};
+        in = in.subspan(1);
+
+        size_t literals{size_t{token} >> 4};
+        if (literals == 15 && !ReadLength(in, literals)) return false;
+        if (literals > in.size() || literals > out.size() - written) return false;
+        std::copy_n(in.begin(), literals, out.begin() + written);
+        in = in.subspan(literals);
+        written += literals;
+        // The last sequence has no match.
+        if (in.empty()) break;
+
+        if (in.size() < 2) return false;
+        const size_t offset{std::to_integer<size_t>(in[0]) | std::to_integer<size_t>(in[1]) << 8};
+        in = in.subspan(2);
+        size_t length{size_t{token} & 15};
+        if (length == 15 && !ReadLength(in, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > written || length > out.size() - written) return false;
+        // The match may overlap the bytes it produces.
+        for (size_t i = 0; i < length; ++i, ++written) out[written] = out[written - offset];
+    }
+    return written == out.size();
+}
+
+bool CompressBlockFile(const fs::path& in_path, const fs::path& out_path, size_t frame_size)
+{
+    if (frame_size < MIN_FRAME_SIZE || frame_size > MAX_FRAME_SIZE) return false;
+    const fs::path tmp_path{out_path + ".tmp"};
+    try {
+        AutoFile in{fsbridge::fopen(in_path, "rb")};
+        if (in.IsNull()) return error("%s: failed to open %s", __func__, fs::PathToString(in_path));
+        const uint64_t size{fs::file_size(in_path)};
+        if (size > MAX_UNCOMPRESSED_SIZE) return error("%s: %s is too large", __func__, fs::PathToString(in_path));
+
+        AutoFile out{fsbridge::fopen(tmp_path, "wb")};
+        if (out.IsNull()) return error("%s: failed to create %s", __func__, fs::PathToString(tmp_path));
+        out << COMPRESSED_FILE_MAGIC << uint32_t(frame_size) << size << uint64_t{0};
+
+        std::vector<uint64_t> offsets;
+        uint64_t offset{COMPRESSED_FILE_HEADER_SIZE};
+        std::vector<std::byte> frame;
+        for (uint64_t pos = 0; pos < size; pos += frame_size) {
+            frame.resize(FrameSize(size, frame_size, offsets.size()));
+            in.read(frame);
+            offsets.push_back(offset);
+            // Frames that don't compress are stored as is.
+            const auto compressed{CompressFrame(frame)};
+            const Span<const std::byte> data{compressed ? Span<const std::byte>{*compressed} : Span<const std::byte>{frame}};
+            out.write(data);
+            offset += data.size();
+        }
+        for (const uint64_t frame_offset : offsets) out << frame_offset;
+
+        if (std::fseek(out.Get(), COMPRESSED_FILE_HEADER_SIZE - 8, SEEK_SET) != 0) {
+            return error("%s: failed to seek in %s", __func__, fs::PathToString(tmp_path));
+        }
+        out << offset;
+        if (!FileCommit(out.Get()) || out.fclose() != 0) {
+            return error("%s: failed to commit %s", __func__, fs::PathToString(tmp_path));
+        }
+    } catch (const std::exception& e) {
+        fs::remove(tmp_path);
+        return error("%s: failed to compress %s: %s", __func__, fs::PathToString(in_path), e.what());
+    }
+    if (!RenameOver(tmp_path, out_path)) {
+        fs::remove(tmp_path);
+        return error("%s: failed to rename %s", __func__, fs::PathToString(tmp_path));
+    }
+    DirectoryCommit(out_path.parent_path());
+    return true;
+}
+
+bool DecompressBlockFile(const fs::path& in_path, const fs::path& out_path)
+{
+    const fs::path tmp_path{out_path + ".tmp"};
+    try {
+        auto in{CompressedBlockFile::Open(in_path)};
+        if (!in) return false;
+        AutoFile out{fsbridge::fopen(tmp_path, "wb")};
+        if (out.IsNull()) return error("%s: failed to create %s", __func__, fs::PathToString(tmp_path));
+        std::vector<std::byte> data;
+        for (uint64_t pos = 0; pos < in->Size(); pos += DEFAULT_BLOCK_COMPRESSION_FRAME_SIZE) {
+            data.resize(std::min<uint64_t>(DEFAULT_BLOCK_COMPRESSION_FRAME_SIZE, in->Size() - pos));
+            if (!in->Read(pos, data)) {
+                fs::remove(tmp_path);
+                return error("%s: failed to read %s", __func__, fs::PathToString(in_path));
+            }
+            out.write(data);
+        }
+        if (!FileCommit(out.Get()) || out.fclose() != 0) {
+            return error("%s: failed to commit %s", __func__, fs::PathToString(tmp_path));
+        }
+    } catch (const std::exception& e) {
+        fs::remove(tmp_path);
+        return error("%s: failed to decompress %s: %s", __func__, fs::PathToString(in_path), e.what());
+    }
+    if (!RenameOver(tmp_path, out_path)) {
+        fs::remove(tmp_path);
+        return error("%s: failed to rename %s", __func__, fs::PathToString(tmp_path));
+    }
+    DirectoryCommit(out_path.parent_path());
+    return true;
+}
+
+std::unique_ptr<CompressedBlockFile> CompressedBlockFile::Open(const fs::path& path)
+{
+    std::FILE* file{fsbridge::fopen(path, "rb")};
+    if (!file) return nullptr;
+    std::unique_ptr<CompressedBlockFile> result{new CompressedBlockFile{file}};
+    try {
+        std::array<std::byte, 4> magic;
+        uint64_t index_offset;
+        result->m_file >> magic >> result->m_frame_size >> result->m_size >> index_offset;
+        if (magic != COMPRESSED_FILE_MAGIC || result->m_frame_size < MIN_FRAME_SIZE || result->m_frame_size > MAX_FRAME_SIZE ||
+            result->m_size > MAX_UNCOMPRESSED_SIZE || index_offset < COMPRESSED_FILE_HEADER_SIZE) {
+            LogPrintf("%s: invalid header in %s\n", __func__, fs::PathToString(path));
+            return nullptr;
+        }
+        const size_t frames((result->m_size + result->m_frame_size - 1) / result->m_frame_size);
+        if (std::fseek(result->m_file.Get(), index_offset, SEEK_SET) != 0) {
+            LogPrintf("%s: failed to seek in %s\n", __func__, fs::PathToString(path));
+            return nullptr;
+        }
+        result->m_frame_offsets.resize(frames);
+        for (uint64_t& offset : result->m_frame_offsets) result->m_file >> offset;
+        result->m_frame_offsets.push_back(index_offset);
+        for (size_t frame = 0; frame < frames; ++frame) {
+            const uint64_t begin{result->m_frame_offsets[frame]}, end{result->m_frame_offsets[frame + 1]};
+            if (begin < COMPRESSED_FILE_HEADER_SIZE || end < begin || end - begin > FrameSize(result->m_size, result->m_frame_size, frame)) {
+                LogPrintf("%s: invalid frame index in %s\n", __func__, fs::PathToString(path));
+                return nullptr;
+            }
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to read %s: %s\n", __func__, fs::PathToString(path), e.what());
+        return nullptr;
+    }
+    return result;
+}
+
+bool CompressedBlockFile::Read(uint64_t pos, Span<std::byte> data)
+{
+    if (pos > m_size || data.size() > m_size - pos) return false;
+    std::vector<std::byte> compressed;
+    while (!data.empty()) {
+        const size_t frame(pos / m_frame_size);
+        if (m_cached_frame != frame) {
+            m_cached_frame.reset();
+            const uint64_t begin{m_frame_offsets[frame]}, end{m_frame_offsets[frame + 1]};
+            m_frame_data.resize(FrameSize(m_size, m_frame_size, frame));
+            try {
+                if (std::fseek(m_file.Get(), begin, SEEK_SET) != 0) return false;
+                if (end - begin == m_frame_data.size()) {
+                    m_file.read(m_frame_data);
+                } else {
+                    compressed.resize(end - begin);
+                    m_file.read(compressed);
+                    if (!DecompressFrame(compressed, m_frame_data)) return false;
+                }
+            } catch (const std::exception&) {
+                return false;
+            }
+            m_cached_frame = frame;
+        }
+        const size_t frame_pos(pos - frame * uint64_t{m_frame_size});
+        const size_t count{std::min(data.size(), m_frame_data.size() - frame_pos)};
+        std::copy_n(m_frame_data.begin() + frame_pos, count, data.begin());
+        data = data.subspan(count);
+        pos += count;
+    }
+    return true;
+}
+} // namespace node
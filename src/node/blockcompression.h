@@ -0,0 +1,82 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKCOMPRESSION_H
+#define BITCOIN_NODE_BLOCKCOMPRESSION_H
+
+#include <span.h>
+#include <streams.h>
+#include <util/fs.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace node {
+//! Uncompressed size of the frames of compressed block files
+static constexpr size_t DEFAULT_BLOCK_COMPRESSION_FRAME_SIZE{256 << 10};
+//! -blockcompression default
+static constexpr bool DEFAULT_BLOCK_COMPRESSION{false};
+
+/**
+ * Compress a frame with a simple LZ77 scheme: sequences of literal bytes
+ * followed by a copy of at least 4 bytes from up to 64 KiB back.
+ *
+ * @returns the compressed frame, or std::nullopt if it isn't smaller than the
+ *          input.
+ */
+std::optional<std::vector<std::byte>> CompressFrame(Span<const std::byte> in);
+
+/**
+ * Decompress a frame compressed by CompressFrame.
+ *
+ * @returns false if the frame is malformed or doesn't decompress to exactly
+ *          out.size() bytes.
+ */
+[[nodiscard]] bool DecompressFrame(Span<const std::byte> in, Span<std::byte> out);
+
+/**
+ * Compress the contents of a block file into a compressed block file.
+ *
+ * The file is cut into frames of frame_size uncompressed bytes which are
+ * compressed independently, and followed by the offsets of the frames, so
+ * that any range of the block file can be read by decompressing the frames
+ * covering it. The output is written to a temporary file that is committed
+ * to disk and renamed to out_path once complete.
+ */
+[[nodiscard]] bool CompressBlockFile(const fs::path& in_path, const fs::path& out_path, size_t frame_size = DEFAULT_BLOCK_COMPRESSION_FRAME_SIZE);
+
+/** Decompress a compressed block file back into a block file, the same way. */
+[[nodiscard]] bool DecompressBlockFile(const fs::path& in_path, const fs::path& out_path);
+
+/** Random access to the uncompressed contents of a compressed block file. */
+class CompressedBlockFile
+{
+    AutoFile m_file;
+    uint32_t m_frame_size{0};
+    uint64_t m_size{0};
+    //! Offset of each frame in the file, followed by the offset of the frame index
+    std::vector<uint64_t> m_frame_offsets;
+    //! The last frame read, most reads of a block are in the same frame
+    std::optional<size_t> m_cached_frame;
+    std::vector<std::byte> m_frame_data;
+
+    explicit CompressedBlockFile(std::FILE* file) : m_file{file} {}
+
+public:
+    /** Open a compressed block file and read its frame index, return nullptr on failure. */
+    static std::unique_ptr<CompressedBlockFile> Open(const fs::path& path);
+
+    /** Size of the uncompressed contents. */
+    uint64_t Size() const { return m_size; }
+
+    /** Read data.size() bytes of the uncompressed contents starting at pos. */
+    [[nodiscard]] bool Read(uint64_t pos, Span<std::byte> data);
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKCOMPRESSION_H
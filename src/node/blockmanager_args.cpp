@@ -12,6 +12,7 @@
 #include <validation.h>
 
 #include <cstdint>
+#include <utility>
 
 namespace node {
 util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Options& opts)
@@ -32,6 +33,17 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
     opts.prune_target = nPruneTarget;
 
     if (auto value{args.GetBoolArg("-fastprune")}) opts.fast_prune = *value;
+    if (auto value{args.GetBoolArg("-blockcompression")}) opts.compress_block_files = *value;
+    if (auto value{args.GetBoolArg("-blockasyncflush")}) opts.async_flush = *value;
+
+    for (const auto& [arg, chunk_size] : {std::pair{"-blockfilechunksize", &opts.block_file_chunk_size}, std::pair{"-undofilechunksize", &opts.undo_file_chunk_size}}) {
+        if (auto value{args.GetIntArg(arg)}) {
+            if (*value < 1 || *value > int64_t{MAX_BLOCKFILE_SIZE >> 20}) {
+                return util::Error{strprintf(Untranslated("Invalid %s value: %d (must be between 1 and %d MiB)"), arg, *value, MAX_BLOCKFILE_SIZE >> 20)};
+            }
+            *chunk_size = uint32_t(*value) << 20;
+        }
+    }
 
     return {};
 }
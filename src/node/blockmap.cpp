@@ -0,0 +1,68 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockmap.h>
+
+#include <memusage.h>
+#include <util/check.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace node {
+size_t BlockMap::FindSlot(const uint256& hash) const
+{
+    const size_t mask{m_table.size() - 1};
+    for (size_t i = m_hasher(hash) & mask;; i = (i + 1) & mask) {
+        const Slot slot{m_table[i]};
+        if (!slot || Entry(slot - 1).first == hash) return i;
+    }
+}
+
+void BlockMap::Rehash(size_t table_size)
+{
+    m_table.assign(table_size, 0);
+    const size_t mask{table_size - 1};
+    for (size_t pos = 0; pos < m_size; ++pos) {
+        size_t i{m_hasher(Entry(pos).first) & mask};
+        while (m_table[i]) i = (i + 1) & mask;
+        m_table[i] = pos + 1;
+    }
+}
+
+void BlockMap::ReserveTable(size_t count)
+{
+    Assert(count < std::numeric_limits<Slot>::max());
+    // Keep the load factor of the table at most 3/4
+    if (count * 4 <= m_table.size() * 3) return;
+    size_t table_size{std::max(MIN_TABLE_SIZE, m_table.size())};
+    while (count * 4 > table_size * 3) table_size *= 2;
+    Rehash(table_size);
+}
+
+void BlockMap::reserve(size_t count)
+{
+    ReserveTable(count);
+    m_chunks.reserve((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+void BlockMap::clear()
+{
+    for (size_t pos = 0; pos < m_size; ++pos) {
+        Entry(pos).~value_type();
+    }
+    for (value_type* chunk : m_chunks) {
+        std::allocator<value_type>{}.deallocate(chunk, CHUNK_SIZE);
+    }
+    m_chunks.clear();
+    m_table.clear();
+    m_size = 0;
+}
+
+size_t BlockMap::DynamicMemoryUsage() const
+{
+    return m_chunks.size() * memusage::MallocUsage(CHUNK_SIZE * sizeof(value_type)) +
+           memusage::DynamicUsage(m_chunks) + memusage::DynamicUsage(m_table);
+}
+} // namespace node
@@ -0,0 +1,149 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKMAP_H
+#define BITCOIN_NODE_BLOCKMAP_H
+
+#include <chain.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace node {
+/**
+ * Map of block hashes to their CBlockIndex, for the block index.
+ *
+ * Entries are allocated in insertion order from an arena of fixed-size
+ * chunks, which keeps their addresses stable (validation code takes pointers
+ * to them) without a heap allocation per entry, and keeps blocks received
+ * together, as during headers sync, close in memory. The hash table is an
+ * open-addressed array of 32-bit arena positions.
+ *
+ * Implements the subset of the std::unordered_map interface used for the
+ * block index. Entries can't be erased individually, and iteration is in
+ * insertion order.
+ */
+class BlockMap
+{
+public:
+    using key_type = uint256;
+    using mapped_type = CBlockIndex;
+    using value_type = std::pair<const uint256, CBlockIndex>;
+    using size_type = size_t;
+
+private:
+    //! Number of entries allocated at a time
+    static constexpr size_t CHUNK_SIZE{1 << 12};
+    static constexpr size_t MIN_TABLE_SIZE{1 << 10};
+    //! Position of an entry in the arena plus one, zero for empty slots
+    using Slot = uint32_t;
+
+    std::vector<value_type*> m_chunks;
+    size_t m_size{0};
+    std::vector<Slot> m_table;
+    BlockHasher m_hasher;
+
+    value_type& Entry(size_t pos) const { return m_chunks[pos / CHUNK_SIZE][pos % CHUNK_SIZE]; }
+    /** Slot of the entry with this hash, or the empty slot where it would be inserted. */
+    size_t FindSlot(const uint256& hash) const;
+    void Rehash(size_t table_size);
+    void ReserveTable(size_t count);
+
+    template <typename Value>
+    class Iterator
+    {
+        friend class BlockMap;
+        template <typename>
+        friend class Iterator;
+        const BlockMap* m_map{nullptr};
+        size_t m_pos{0};
+        Iterator(const BlockMap* map, size_t pos) : m_map{map}, m_pos{pos} {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator() = default;
+        //! Allow conversion of iterator to const_iterator
+        template <typename Other, typename = std::enable_if_t<std::is_same_v<Value, const Other>>>
+        Iterator(const Iterator<Other>& other) : m_map{other.m_map}, m_pos{other.m_pos} {}
+
+        reference operator*() const { return m_map->Entry(m_pos); }
+        pointer operator->() const { return &m_map->Entry(m_pos); }
+        Iterator& operator++()
+        {
+            ++m_pos;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator it{*this};
+            ++m_pos;
+            return it;
+        }
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_pos == b.m_pos; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_pos != b.m_pos; }
+    };
+
+public:
+    using iterator = Iterator<value_type>;
+    using const_iterator = Iterator<const value_type>;
+
+    BlockMap() = default;
+    ~BlockMap() { clear(); }
+    BlockMap(const BlockMap&) = delete;
+    BlockMap& operator=(const BlockMap&) = delete;
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_size}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear();
+    /** Make room for count entries without rehashing. */
+    void reserve(size_t count);
+
+    iterator find(const uint256& hash)
+    {
+        const Slot slot{m_table.empty() ? Slot{0} : m_table[FindSlot(hash)]};
+        return slot ? iterator{this, slot - size_t{1}} : end();
+    }
+    const_iterator find(const uint256& hash) const { return const_cast<BlockMap*>(this)->find(hash); }
+    size_t count(const uint256& hash) const { return find(hash) != end(); }
+
+    /** Insert an entry constructed from args if there is none for hash. */
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const uint256& hash, Args&&... args)
+    {
+        ReserveTable(m_size + 1);
+        Slot& slot{m_table[FindSlot(hash)]};
+        if (slot) return {iterator{this, slot - size_t{1}}, false};
+        if (m_size == m_chunks.size() * CHUNK_SIZE) {
+            m_chunks.push_back(std::allocator<value_type>{}.allocate(CHUNK_SIZE));
+        }
+        new (m_chunks[m_size / CHUNK_SIZE] + m_size % CHUNK_SIZE) value_type(std::piecewise_construct, std::forward_as_tuple(hash), std::forward_as_tuple(std::forward<Args>(args)...));
+        slot = ++m_size;
+        return {iterator{this, m_size - 1}, true};
+    }
+
+    /** Memory allocated by the map, not counting what entries may point to. */
+    size_t DynamicMemoryUsage() const;
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKMAP_H
@@ -0,0 +1,108 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockprefetch.h>
+
+#include <chain.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <util/thread.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace node {
+BlockPrefetcher::BlockPrefetcher(const BlockManager& blockman, size_t depth)
+    : m_blockman{blockman}, m_depth{depth} {}
+
+BlockPrefetcher::~BlockPrefetcher()
+{
+    Stop();
+}
+
+void BlockPrefetcher::Prefetch(const std::vector<const CBlockIndex*>& blocks)
+{
+    AssertLockHeld(::cs_main);
+    if (m_depth == 0) return;
+    {
+        LOCK(m_mutex);
+        if (m_stop) return;
+        std::deque<Entry> queue;
+        for (const CBlockIndex* pindex : blocks) {
+            if (queue.size() == m_depth) break;
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA)) break;
+            const auto it{std::find_if(m_queue.begin(), m_queue.end(), [&](const Entry& entry) { return entry.hash == pindex->GetBlockHash(); })};
+            if (it != m_queue.end()) {
+                queue.push_back(std::move(*it));
+            } else {
+                queue.push_back({pindex->GetBlockHash(), pindex->GetBlockPos()});
+            }
+        }
+        m_queue = std::move(queue);
+    }
+    m_cond.notify_all();
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&util::TraceThread, "blkprefetch", [this] { ThreadPrefetch(); });
+    }
+}
+
+std::shared_ptr<const CBlock> BlockPrefetcher::Take(const CBlockIndex& index)
+{
+    WAIT_LOCK(m_mutex, lock);
+    const auto find{[&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return std::find_if(m_queue.begin(), m_queue.end(), [&](const Entry& entry) { return entry.hash == index.GetBlockHash(); });
+    }};
+    auto it{find()};
+    while (it != m_queue.end() && it->state != State::DONE) {
+        m_cond.wait(lock);
+        it = find();
+    }
+    if (it == m_queue.end()) return nullptr;
+    // Blocks before this one were skipped and won't be connected next
+    std::shared_ptr<const CBlock> block{std::move(it->block)};
+    m_queue.erase(m_queue.begin(), it + 1);
+    return block;
+}
+
+void BlockPrefetcher::Stop()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void BlockPrefetcher::ThreadPrefetch()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        const auto pending{[&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return std::find_if(m_queue.begin(), m_queue.end(), [](const Entry& entry) { return entry.state == State::PENDING; });
+        }};
+        m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || pending() != m_queue.end(); });
+        if (m_stop) return;
+
+        auto it{pending()};
+        it->state = State::READING;
+        const uint256 hash{it->hash};
+        const FlatFilePos pos{it->pos};
+        std::shared_ptr<CBlock> block;
+        {
+            REVERSE_LOCK(lock);
+            block = std::make_shared<CBlock>();
+            if (!m_blockman.ReadBlockFromDisk(*block, pos) || block->GetHash() != hash) block.reset();
+        }
+        // The queue may have changed while the block was read
+        it = std::find_if(m_queue.begin(), m_queue.end(), [&](const Entry& entry) { return entry.hash == hash; });
+        if (it != m_queue.end() && it->state == State::READING) {
+            it->state = State::DONE;
+            it->block = std::move(block);
+        }
+        m_cond.notify_all();
+    }
+}
+} // namespace node
@@ -0,0 +1,83 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKPREFETCH_H
+#define BITCOIN_NODE_BLOCKPREFETCH_H
+
+#include <flatfile.h>
+#include <kernel/cs_main.h>
+#include <sync.h>
+#include <threadsafety.h>
+#include <uint256.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+namespace node {
+class BlockManager;
+
+/**
+ * Reads blocks from disk on a background thread ahead of when they are
+ * connected, so that connecting a run of blocks that are already on disk, as
+ * during -reindex-chainstate or after a block download, doesn't stall on
+ * reading and deserializing each block.
+ */
+class BlockPrefetcher
+{
+public:
+    /** Read ahead up to depth blocks, or none if depth is zero. */
+    BlockPrefetcher(const BlockManager& blockman, size_t depth);
+    ~BlockPrefetcher();
+
+    /**
+     * Set the blocks to read ahead, in the order they will be connected.
+     * Blocks already read or being read that are still wanted are kept.
+     */
+    void Prefetch(const std::vector<const CBlockIndex*>& blocks) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /**
+     * Take a block that is read ahead, waiting for it to be read. Blocks
+     * before it are dropped. Returns nullptr if the block isn't read ahead or
+     * couldn't be read, in which case the caller reads it.
+     */
+    std::shared_ptr<const CBlock> Take(const CBlockIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Stop the background thread and drop the blocks read ahead. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    enum class State {
+        PENDING,
+        READING,
+        DONE,
+    };
+    struct Entry {
+        uint256 hash;
+        FlatFilePos pos;
+        State state{State::PENDING};
+        std::shared_ptr<const CBlock> block;
+    };
+
+    const BlockManager& m_blockman;
+    const size_t m_depth;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    //! Blocks to read ahead, in the order they will be connected
+    std::deque<Entry> m_queue GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+
+    void ThreadPrefetch() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKPREFETCH_H
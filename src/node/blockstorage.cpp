@@ -7,6 +7,7 @@
 #include <chain.h>
 #include <clientversion.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -14,20 +15,31 @@
 #include <kernel/chainparams.h>
 #include <kernel/messagestartchars.h>
 #include <logging.h>
+#include <node/blockcompression.h>
 #include <pow.h>
+#include <random.h>
 #include <reverse_iterator.h>
 #include <signet.h>
+#include <span.h>
 #include <streams.h>
 #include <sync.h>
 #include <undo.h>
 #include <util/batchpriority.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
+#include <util/parallel.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <array>
 #include <map>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 
 namespace kernel {
@@ -36,11 +48,19 @@ static constexpr uint8_t DB_BLOCK_INDEX{'b'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
+static constexpr uint8_t DB_BLOCK_INDEX_SNAPSHOT{'s'};
 // Keys used in previous version that might still be found in the DB:
 // BlockTreeDB::DB_TXINDEX_BLOCK{'T'};
 // BlockTreeDB::DB_TXINDEX{'t'}
 // BlockTreeDB::ReadFlag("txindex")
 
+//! Maximum number of threads checking the proof of work of block index entries on load
+static constexpr int MAX_BLOCK_INDEX_LOAD_THREADS{8};
+//! Number of block index entries read from the database before they are checked and inserted
+static constexpr size_t BLOCK_INDEX_LOAD_CHUNK_SIZE{1 << 16};
+//! Number of block index entries checked by a thread at a time
+static constexpr size_t BLOCK_INDEX_LOAD_BATCH_SIZE{1 << 12};
+
 bool BlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo& info)
 {
     return Read(std::make_pair(DB_BLOCK_FILES, nFile), info);
@@ -65,6 +85,20 @@ bool BlockTreeDB::ReadLastBlockFile(int& nFile)
     return Read(DB_LAST_BLOCK, nFile);
 }
 
+bool BlockTreeDB::WriteBlockIndexSnapshotId(std::optional<uint64_t> id)
+{
+    if (id) {
+        return Write(DB_BLOCK_INDEX_SNAPSHOT, *id, /*fSync=*/true);
+    } else {
+        return Erase(DB_BLOCK_INDEX_SNAPSHOT, /*fSync=*/true);
+    }
+}
+
+bool BlockTreeDB::ReadBlockIndexSnapshotId(uint64_t& id)
+{
+    return Read(DB_BLOCK_INDEX_SNAPSHOT, id);
+}
+
 bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo)
 {
     CDBBatch batch(*this);
@@ -93,44 +127,78 @@ bool BlockTreeDB::ReadFlag(const std::string& name, bool& fValue)
     return true;
 }
 
+static void CopyDiskBlockIndex(CBlockIndex& index, const CDiskBlockIndex& diskindex)
+{
+    index.nHeight        = diskindex.nHeight;
+    index.nFile          = diskindex.nFile;
+    index.nDataPos       = diskindex.nDataPos;
+    index.nUndoPos       = diskindex.nUndoPos;
+    index.nVersion       = diskindex.nVersion;
+    index.hashMerkleRoot = diskindex.hashMerkleRoot;
+    index.nTime          = diskindex.nTime;
+    index.nBits          = diskindex.nBits;
+    index.nNonce         = diskindex.nNonce;
+    index.nStatus        = diskindex.nStatus;
+    index.nTx            = diskindex.nTx;
+}
+
 bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
 {
     AssertLockHeld(::cs_main);
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
-    // Load m_block_index
-    while (pcursor->Valid()) {
-        if (interrupt) return false;
-        std::pair<uint8_t, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.ConstructBlockHash());
-                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
-
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
-                }
+    // Entries are read a chunk at a time, and the hashes and proof of work
+    // of a chunk are checked on several threads while it is inserted.
+    const int num_threads{std::clamp<int>(std::thread::hardware_concurrency(), 1, MAX_BLOCK_INDEX_LOAD_THREADS)};
+    std::vector<CDiskBlockIndex> entries;
+    entries.reserve(BLOCK_INDEX_LOAD_CHUNK_SIZE);
+    bool done{false};
 
-                pcursor->Next();
-            } else {
+    // Load m_block_index
+    while (!done) {
+        entries.clear();
+        while (entries.size() < BLOCK_INDEX_LOAD_CHUNK_SIZE) {
+            if (interrupt) return false;
+            std::pair<uint8_t, uint256> key;
+            if (!pcursor->Valid() || !pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
+                done = true;
+                break;
+            }
+            if (!pcursor->GetValue(entries.emplace_back())) {
                 return error("%s: failed to read value", __func__);
             }
-        } else {
-            break;
+            pcursor->Next();
+        }
+
+        const size_t batch_count{(entries.size() + BLOCK_INDEX_LOAD_BATCH_SIZE - 1) / BLOCK_INDEX_LOAD_BATCH_SIZE};
+        size_t next_entry{0};
+        try {
+            util::ParallelForOrdered(
+                "loadblkindex", batch_count, num_threads,
+                [&](size_t batch) {
+                    const size_t end{std::min(entries.size(), (batch + 1) * BLOCK_INDEX_LOAD_BATCH_SIZE)};
+                    std::vector<uint256> hashes;
+                    hashes.reserve(BLOCK_INDEX_LOAD_BATCH_SIZE);
+                    for (size_t i = batch * BLOCK_INDEX_LOAD_BATCH_SIZE; i < end; ++i) {
+                        const uint256& hash{hashes.emplace_back(entries[i].ConstructBlockHash())};
+                        if (!CheckProofOfWork(hash, entries[i].nBits, consensusParams)) {
+                            throw std::runtime_error(strprintf("CheckProofOfWork failed: %s", hash.ToString()));
+                        }
+                    }
+                    return hashes;
+                },
+                [&](std::vector<uint256> hashes) {
+                    for (const uint256& hash : hashes) {
+                        const CDiskBlockIndex& diskindex{entries[next_entry++]};
+                        // Construct block index object
+                        CBlockIndex* pindexNew = insertBlockIndex(hash);
+                        pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+                        CopyDiskBlockIndex(*pindexNew, diskindex);
+                    }
+                });
+        } catch (const std::runtime_error& e) {
+            return error("%s: %s", __func__, e.what());
         }
     }
 
@@ -141,6 +209,13 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
 namespace node {
 std::atomic_bool fReindex(false);
 
+//! Magic bytes and format version at the start of block index snapshot files
+static constexpr std::array<uint8_t, 4> BLOCK_INDEX_SNAPSHOT_MAGIC{'b', 'i', 'd', 'x'};
+static constexpr uint32_t BLOCK_INDEX_SNAPSHOT_VERSION{1};
+//! Lower bound of the serialized size of a block index snapshot entry, the hash and header
+static constexpr size_t BLOCK_INDEX_SNAPSHOT_MIN_ENTRY_SIZE{32 + 80};
+static constexpr uint64_t BLOCK_INDEX_SNAPSHOT_INTERRUPT_INTERVAL{1 << 16};
+
 bool CBlockIndexWorkComparator::operator()(const CBlockIndex* pa, const CBlockIndex* pb) const
 {
     // First sort by most total work, ...
@@ -312,7 +387,7 @@ void BlockManager::FindFilesToPrune(
     // We don't check to prune until after we've allocated new space for files
     // So we should leave a buffer under our target to account for another allocation
     // before the next pruning.
-    uint64_t nBuffer = BLOCKFILE_CHUNK_SIZE + UNDOFILE_CHUNK_SIZE;
+    uint64_t nBuffer = m_opts.block_file_chunk_size.value_or(BLOCKFILE_CHUNK_SIZE) + m_opts.undo_file_chunk_size.value_or(UNDOFILE_CHUNK_SIZE);
     uint64_t nBytesToPrune;
     int count = 0;
 
@@ -381,7 +456,8 @@ CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
 
 bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockhash)
 {
-    if (!m_block_tree_db->LoadBlockIndexGuts(
+    std::optional<std::vector<CBlockIndex*>> sorted_by_height{LoadBlockIndexSnapshot()};
+    if (!sorted_by_height && !m_block_tree_db->LoadBlockIndexGuts(
             GetConsensus(), [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, m_interrupt)) {
         return false;
     }
@@ -411,9 +487,14 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
     Assert(m_snapshot_height.has_value() == snapshot_blockhash.has_value());
 
     // Calculate nChainWork
-    std::vector<CBlockIndex*> vSortedByHeight{GetAllBlockIndices()};
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-              CBlockIndexHeightOnlyComparator());
+    std::vector<CBlockIndex*> vSortedByHeight;
+    if (sorted_by_height) {
+        vSortedByHeight = std::move(*sorted_by_height);
+    } else {
+        vSortedByHeight = GetAllBlockIndices();
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
+                  CBlockIndexHeightOnlyComparator());
+    }
 
     CBlockIndex* previous_index{nullptr};
     for (CBlockIndex* pindex : vSortedByHeight) {
@@ -457,6 +538,160 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
     return true;
 }
 
+std::optional<std::vector<CBlockIndex*>> BlockManager::LoadBlockIndexSnapshot()
+{
+    AssertLockHeld(cs_main);
+    const fs::path path{BlockIndexSnapshotPath()};
+    if (!fs::exists(path)) return std::nullopt;
+    const auto start{SteadyClock::now()};
+
+    // The snapshot is only valid for the database state it was written with.
+    uint64_t expected_id;
+    const bool have_id{m_block_tree_db->ReadBlockIndexSnapshotId(expected_id)};
+    if (have_id && !m_block_tree_db->WriteBlockIndexSnapshotId(std::nullopt)) {
+        return std::nullopt;
+    }
+    std::vector<std::byte> data;
+    {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        std::error_code ec;
+        const auto size{fs::file_size(path, ec)};
+        if (have_id && !file.IsNull() && !ec) {
+            try {
+                data.resize(size);
+                file >> Span{data};
+            } catch (const std::exception& e) {
+                LogPrintf("Failed to read block index snapshot: %s\n", e.what());
+                data.clear();
+            }
+        }
+    }
+    std::error_code ec;
+    fs::remove(path, ec);
+    if (!have_id || data.size() < uint256::size()) {
+        LogPrintf("Ignoring block index snapshot that doesn't match the block index database\n");
+        return std::nullopt;
+    }
+
+    const auto fail{[&](const std::string& reason) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+        LogPrintf("Ignoring block index snapshot: %s\n", reason);
+        m_block_index.clear();
+        return std::nullopt;
+    }};
+
+    const auto content{Span{data}.first(data.size() - uint256::size())};
+    uint256 checksum;
+    SpanReader{CLIENT_VERSION, MakeUCharSpan(Span{data}.last(uint256::size()))} >> checksum;
+    if ((HashWriter{} << content).GetHash() != checksum) return fail("checksum mismatch");
+
+    std::vector<CBlockIndex*> sorted_by_height;
+    try {
+        SpanReader reader{CLIENT_VERSION, MakeUCharSpan(content)};
+        std::array<uint8_t, 4> magic;
+        uint32_t version;
+        uint64_t id;
+        int last_file;
+        CBlockFileInfo last_file_info;
+        uint64_t count;
+        reader >> magic >> version >> id >> last_file >> last_file_info >> count;
+        if (magic != BLOCK_INDEX_SNAPSHOT_MAGIC || version != BLOCK_INDEX_SNAPSHOT_VERSION) return fail("unknown format");
+        if (id != expected_id) return fail("doesn't match the block index database");
+
+        // Blocks stored since the snapshot was written change the last block file.
+        int db_last_file;
+        CBlockFileInfo db_last_file_info;
+        if (!m_block_tree_db->ReadLastBlockFile(db_last_file) || db_last_file != last_file ||
+            !m_block_tree_db->ReadBlockFileInfo(last_file, db_last_file_info) ||
+            db_last_file_info.nBlocks != last_file_info.nBlocks || db_last_file_info.nSize != last_file_info.nSize ||
+            db_last_file_info.nUndoSize != last_file_info.nUndoSize || db_last_file_info.nHeightLast != last_file_info.nHeightLast) {
+            return fail("doesn't match the block files");
+        }
+        if (count > content.size() / BLOCK_INDEX_SNAPSHOT_MIN_ENTRY_SIZE) return fail("invalid entry count");
+
+        m_block_index.reserve(count);
+        sorted_by_height.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            if (i % BLOCK_INDEX_SNAPSHOT_INTERRUPT_INTERVAL == 0 && m_interrupt) return fail("interrupted");
+            uint256 hash;
+            CDiskBlockIndex diskindex;
+            reader >> hash >> diskindex;
+            CBlockIndex* pindex{InsertBlockIndex(hash)};
+            pindex->pprev = InsertBlockIndex(diskindex.hashPrev);
+            kernel::CopyDiskBlockIndex(*pindex, diskindex);
+            if (!sorted_by_height.empty() && pindex->nHeight < sorted_by_height.back()->nHeight) return fail("not ordered by height");
+            sorted_by_height.push_back(pindex);
+        }
+        if (!reader.empty()) return fail("unexpected data");
+    } catch (const std::ios_base::failure& e) {
+        return fail(e.what());
+    }
+    // Entries referenced as parents but missing, or duplicated
+    if (sorted_by_height.size() != m_block_index.size()) return fail("inconsistent entries");
+
+    LogPrintf("Loaded %d block index entries from snapshot in %dms\n", sorted_by_height.size(),
+              Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+    return sorted_by_height;
+}
+
+bool BlockManager::WriteBlockIndexSnapshot()
+{
+    AssertLockHeld(::cs_main);
+    if (!m_block_tree_db || !m_block_index_loaded || !m_dirty_blockindex.empty() || !m_dirty_fileinfo.empty()) {
+        return false;
+    }
+    const auto start{SteadyClock::now()};
+
+    int last_file;
+    CBlockFileInfo last_file_info;
+    if (!m_block_tree_db->ReadLastBlockFile(last_file) ||
+        !m_block_tree_db->ReadBlockFileInfo(last_file, last_file_info)) {
+        return false;
+    }
+
+    std::vector<const CBlockIndex*> sorted_by_height;
+    sorted_by_height.reserve(m_block_index.size());
+    for (const auto& [_, block_index] : m_block_index) {
+        sorted_by_height.push_back(&block_index);
+    }
+    std::sort(sorted_by_height.begin(), sorted_by_height.end(), CBlockIndexHeightOnlyComparator());
+
+    const uint64_t id{GetRand<uint64_t>()};
+    const fs::path path{BlockIndexSnapshotPath()};
+    const fs::path tmp_path{path + ".tmp"};
+    try {
+        AutoFile file{fsbridge::fopen(tmp_path, "wb")};
+        if (file.IsNull()) {
+            return error("%s: Failed to open %s", __func__, fs::PathToString(tmp_path));
+        }
+        HashedSourceWriter writer{file};
+        writer << BLOCK_INDEX_SNAPSHOT_MAGIC << BLOCK_INDEX_SNAPSHOT_VERSION << id << last_file << last_file_info
+               << uint64_t{sorted_by_height.size()};
+        for (const CBlockIndex* pindex : sorted_by_height) {
+            writer << pindex->GetBlockHash() << CDiskBlockIndex{pindex};
+        }
+        file << writer.GetHash();
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        if (file.fclose() != 0) {
+            throw std::runtime_error("fclose failed");
+        }
+    } catch (const std::exception& e) {
+        std::error_code ec;
+        fs::remove(tmp_path, ec);
+        return error("%s: Failed to write block index snapshot: %s", __func__, e.what());
+    }
+    if (!RenameOver(tmp_path, path)) {
+        return error("%s: Failed to rename %s", __func__, fs::PathToString(tmp_path));
+    }
+    if (!m_block_tree_db->WriteBlockIndexSnapshotId(id)) {
+        return error("%s: Failed to write block index snapshot id", __func__);
+    }
+    LogPrintf("Wrote %d block index entries to snapshot in %dms\n", sorted_by_height.size(),
+              Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+    return true;
+}
+
 bool BlockManager::WriteBlockIndexDB()
 {
     AssertLockHeld(::cs_main);
@@ -513,7 +748,7 @@ bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_block
     }
     for (std::set<int>::iterator it = setBlkDataFiles.begin(); it != setBlkDataFiles.end(); it++) {
         FlatFilePos pos(*it, 0);
-        if (OpenBlockFile(pos, true).IsNull()) {
+        if (!IsBlockFileCompressed(*it) && OpenBlockFile(pos, true).IsNull()) {
             return false;
         }
     }
@@ -612,11 +847,11 @@ bool BlockManager::CheckBlockDataAvailability(const CBlockIndex& upper_block, co
 // works correctly.
 void BlockManager::CleanupBlockRevFiles() const
 {
-    std::map<std::string, fs::path> mapBlockFiles;
+    std::multimap<std::string, fs::path> mapBlockFiles;
 
-    // Glob all blk?????.dat and rev?????.dat files from the blocks directory.
-    // Remove the rev files immediately and insert the blk file paths into an
-    // ordered map keyed by block file index.
+    // Glob all blk?????.dat, blz?????.dat and rev?????.dat files from the
+    // blocks directory. Remove the rev files immediately and insert the blk
+    // and blz file paths into an ordered map keyed by block file index.
     LogPrintf("Removing unusable blk?????.dat and rev?????.dat files for -reindex with -prune\n");
     for (fs::directory_iterator it(m_opts.blocks_dir); it != fs::directory_iterator(); it++) {
         const std::string path = fs::PathToString(it->path().filename());
@@ -624,8 +859,8 @@ void BlockManager::CleanupBlockRevFiles() const
             path.length() == 12 &&
             path.substr(8,4) == ".dat")
         {
-            if (path.substr(0, 3) == "blk") {
-                mapBlockFiles[path.substr(3, 5)] = it->path();
+            if (path.substr(0, 3) == "blk" || path.substr(0, 3) == "blz") {
+                mapBlockFiles.emplace(path.substr(3, 5), it->path());
             } else if (path.substr(0, 3) == "rev") {
                 remove(it->path());
             }
@@ -638,10 +873,13 @@ void BlockManager::CleanupBlockRevFiles() const
     // start removing block files.
     int nContigCounter = 0;
     for (const std::pair<const std::string, fs::path>& item : mapBlockFiles) {
-        if (LocaleIndependentAtoi<int>(item.first) == nContigCounter) {
+        const int file_number{LocaleIndependentAtoi<int>(item.first)};
+        if (file_number == nContigCounter) {
             nContigCounter++;
             continue;
         }
+        // A block file and its compressed file may both remain after a crash
+        if (file_number == nContigCounter - 1) continue;
         remove(item.second);
     }
 }
@@ -661,23 +899,22 @@ bool BlockManager::UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos
         return error("%s: OpenUndoFile failed", __func__);
     }
 
-    // Write index header
-    unsigned int nSize = GetSerializeSize(blockundo, CLIENT_VERSION);
-    fileout << GetParams().MessageStart() << nSize;
-
-    // Write undo data
     long fileOutPos = ftell(fileout.Get());
     if (fileOutPos < 0) {
         return error("%s: ftell failed", __func__);
     }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
+    pos.nPos = (unsigned int)fileOutPos + BLOCK_SERIALIZATION_HEADER_SIZE;
 
-    // calculate & write checksum
+    // Serialize the index header, undo data and checksum of the undo data
+    // into the write buffer, and write them at once
+    LOCK(m_write_buffer_mutex);
+    SerializeRecord(blockundo);
     HashWriter hasher{};
     hasher << hashBlock;
-    hasher << blockundo;
-    fileout << hasher.GetHash();
+    hasher.write(MakeByteSpan(m_write_buffer).subspan(BLOCK_SERIALIZATION_HEADER_SIZE));
+    CVectorWriter{CLIENT_VERSION, m_write_buffer, m_write_buffer.size()} << hasher.GetHash();
+    fileout.write(MakeByteSpan(m_write_buffer));
+    if (m_opts.async_flush) FileWriteback(fileout.Get(), fileOutPos, m_write_buffer.size());
 
     return true;
 }
@@ -685,7 +922,11 @@ bool BlockManager::UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos
 bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const
 {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
+    return UndoReadFromDisk(blockundo, pos, index.pprev->GetBlockHash());
+}
 
+bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_hash) const
+{
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
@@ -700,7 +941,7 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& in
     uint256 hashChecksum;
     HashVerifier verifier{filein}; // Use HashVerifier as reserializing may lose data, c.f. commit d342424301013ec47dc146a4beb49d5c9319d80a
     try {
-        verifier << index.pprev->GetBlockHash();
+        verifier << prev_hash;
         verifier >> blockundo;
         filein >> hashChecksum;
     } catch (const std::exception& e) {
@@ -715,17 +956,13 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& in
     return true;
 }
 
-bool BlockManager::FlushUndoFile(int block_file, bool finalize)
+bool BlockManager::FlushUndoFile(int block_file, bool finalize, bool background)
 {
     FlatFilePos undo_pos_old(block_file, m_blockfile_info[block_file].nUndoSize);
-    if (!UndoFileSeq().Flush(undo_pos_old, finalize)) {
-        m_opts.notifications.flushError("Flushing undo file to disk failed. This is likely the result of an I/O error.");
-        return false;
-    }
-    return true;
+    return FlushFile({/*undo=*/true, undo_pos_old, finalize}, background);
 }
 
-bool BlockManager::FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo)
+bool BlockManager::FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo, bool background)
 {
     bool success = true;
     LOCK(cs_LastBlockFile);
@@ -740,20 +977,68 @@ bool BlockManager::FlushBlockFile(int blockfile_num, bool fFinalize, bool finali
     assert(static_cast<int>(m_blockfile_info.size()) > blockfile_num);
 
     FlatFilePos block_pos_old(blockfile_num, m_blockfile_info[blockfile_num].nSize);
-    if (!BlockFileSeq().Flush(block_pos_old, fFinalize)) {
-        m_opts.notifications.flushError("Flushing block file to disk failed. This is likely the result of an I/O error.");
+    if (!FlushFile({/*undo=*/false, block_pos_old, fFinalize}, background)) {
         success = false;
     }
     // we do not always flush the undo file, as the chain tip may be lagging behind the incoming blocks,
     // e.g. during IBD or a sync after a node going offline
     if (!fFinalize || finalize_undo) {
-        if (!FlushUndoFile(blockfile_num, finalize_undo)) {
+        if (!FlushUndoFile(blockfile_num, finalize_undo, background)) {
             success = false;
         }
     }
     return success;
 }
 
+bool BlockManager::FlushFile(const FileFlush& flush, bool background)
+{
+    if (background && m_opts.async_flush) {
+        {
+            LOCK(m_flush_mutex);
+            m_flush_queue.push_back(flush);
+            if (!m_thread_flush.joinable()) {
+                m_thread_flush = std::thread(&util::TraceThread, "blkflush", [this] { ThreadFlushFiles(); });
+            }
+        }
+        m_flush_cv.notify_all();
+        return true;
+    }
+    if (!(flush.undo ? UndoFileSeq() : BlockFileSeq()).Flush(flush.pos, flush.finalize)) {
+        m_opts.notifications.flushError(flush.undo ? "Flushing undo file to disk failed. This is likely the result of an I/O error." :
+                                                     "Flushing block file to disk failed. This is likely the result of an I/O error.");
+        return false;
+    }
+    return true;
+}
+
+void BlockManager::ThreadFlushFiles()
+{
+    WAIT_LOCK(m_flush_mutex, lock);
+    while (true) {
+        m_flush_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_flush_mutex) { return m_stop_flush || !m_flush_queue.empty(); });
+        // Queued flushes are done before stopping
+        if (m_flush_queue.empty()) return;
+        const FileFlush flush{m_flush_queue.front()};
+        bool success;
+        {
+            REVERSE_LOCK(lock);
+            success = FlushFile(flush, /*background=*/false);
+        }
+        if (!success) {
+            LogPrintLevel(BCLog::BLOCKSTORAGE, BCLog::Level::Warning, "Failed to flush %s file %05i (finalize=%i)\n",
+                          flush.undo ? "undo" : "block", flush.pos.nFile, flush.finalize);
+        }
+        m_flush_queue.pop_front();
+        m_flush_cv.notify_all();
+    }
+}
+
+void BlockManager::SyncFileFlushes()
+{
+    WAIT_LOCK(m_flush_mutex, lock);
+    m_flush_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_flush_mutex) { return m_flush_queue.empty(); });
+}
+
 BlockfileType BlockManager::BlockfileTypeForHeight(int height)
 {
     if (!m_snapshot_height) {
@@ -764,6 +1049,8 @@ BlockfileType BlockManager::BlockfileTypeForHeight(int height)
 
 bool BlockManager::FlushChainstateBlockFile(int tip_height)
 {
+    // Files that are done being written to may still be flushed in the background
+    SyncFileFlushes();
     LOCK(cs_LastBlockFile);
     auto& cursor = m_blockfile_cursors[BlockfileTypeForHeight(tip_height)];
     // If the cursor does not exist, it means an assumeutxo snapshot is loaded,
@@ -787,12 +1074,17 @@ uint64_t BlockManager::CalculateCurrentUsage()
     return retval;
 }
 
-void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
+void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
+    // A file flushed in the background after being unlinked would be created again
+    SyncFileFlushes();
     std::error_code ec;
+    LOCK(m_compressed_files_mutex);
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
-        const bool removed_blockfile{fs::remove(BlockFileSeq().FileName(pos), ec)};
+        m_compressed_files.erase(*it);
+        const bool removed_compressed_file{fs::remove(CompressedBlockFileSeq().FileName(pos), ec)};
+        const bool removed_blockfile{fs::remove(BlockFileSeq().FileName(pos), ec) || removed_compressed_file};
         const bool removed_undofile{fs::remove(UndoFileSeq().FileName(pos), ec)};
         if (removed_blockfile || removed_undofile) {
             LogPrint(BCLog::BLOCKSTORAGE, "Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -802,12 +1094,17 @@ void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
 
 FlatFileSeq BlockManager::BlockFileSeq() const
 {
-    return FlatFileSeq(m_opts.blocks_dir, "blk", m_opts.fast_prune ? 0x4000 /* 16kb */ : BLOCKFILE_CHUNK_SIZE);
+    return FlatFileSeq(m_opts.blocks_dir, "blk", m_opts.fast_prune ? 0x4000 /* 16kb */ : m_opts.block_file_chunk_size.value_or(BLOCKFILE_CHUNK_SIZE));
 }
 
 FlatFileSeq BlockManager::UndoFileSeq() const
 {
-    return FlatFileSeq(m_opts.blocks_dir, "rev", UNDOFILE_CHUNK_SIZE);
+    return FlatFileSeq(m_opts.blocks_dir, "rev", m_opts.undo_file_chunk_size.value_or(UNDOFILE_CHUNK_SIZE));
+}
+
+FlatFileSeq BlockManager::CompressedBlockFileSeq() const
+{
+    return FlatFileSeq(m_opts.blocks_dir, "blz", BLOCKFILE_CHUNK_SIZE);
 }
 
 CAutoFile BlockManager::OpenBlockFile(const FlatFilePos& pos, bool fReadOnly) const
@@ -893,11 +1190,15 @@ bool BlockManager::FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigne
         // data may be inconsistent after a crash if the flush is called during
         // a reindex. A flush error might also leave some of the data files
         // untrimmed.
-        if (!FlushBlockFile(last_blockfile, !fKnown, finalize_undo)) {
+        if (!FlushBlockFile(last_blockfile, !fKnown, finalize_undo, /*background=*/true)) {
             LogPrintLevel(BCLog::BLOCKSTORAGE, BCLog::Level::Warning,
                           "Failed to flush previous block file %05i (finalize=%i, finalize_undo=%i) before opening new block file %05i\n",
                           last_blockfile, !fKnown, finalize_undo, nFile);
         }
+        if (!fKnown && m_opts.compress_block_files) {
+            WITH_LOCK(m_compression_mutex, m_compression_pending = true);
+            m_compression_cv.notify_all();
+        }
         // No undo data yet in the new file, so reset our undo-height tracking.
         m_blockfile_cursors[chain_type] = BlockfileCursor{nFile};
     }
@@ -947,6 +1248,18 @@ bool BlockManager::FindUndoPos(BlockValidationState& state, int nFile, FlatFileP
     return true;
 }
 
+template <typename T>
+void BlockManager::SerializeRecord(const T& data) const
+{
+    AssertLockHeld(m_write_buffer_mutex);
+    // The buffer keeps its capacity, so that it is only allocated for the
+    // first records and the largest ones. The size in the header is filled
+    // in once the data is serialized, rather than computed beforehand.
+    m_write_buffer.clear();
+    CVectorWriter{CLIENT_VERSION, m_write_buffer, 0} << GetParams().MessageStart() << uint32_t{0} << data;
+    WriteLE32(m_write_buffer.data() + std::tuple_size_v<MessageStartChars>, m_write_buffer.size() - BLOCK_SERIALIZATION_HEADER_SIZE);
+}
+
 bool BlockManager::WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const
 {
     // Open history file to append
@@ -955,17 +1268,18 @@ bool BlockManager::WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const
         return error("WriteBlockToDisk: OpenBlockFile failed");
     }
 
-    // Write index header
-    unsigned int nSize = GetSerializeSize(block, fileout.GetVersion());
-    fileout << GetParams().MessageStart() << nSize;
-
-    // Write block
     long fileOutPos = ftell(fileout.Get());
     if (fileOutPos < 0) {
         return error("WriteBlockToDisk: ftell failed");
     }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
+    pos.nPos = (unsigned int)fileOutPos + BLOCK_SERIALIZATION_HEADER_SIZE;
+
+    // Serialize the index header and block into the write buffer, and write
+    // them at once
+    LOCK(m_write_buffer_mutex);
+    SerializeRecord(block);
+    fileout.write(MakeByteSpan(m_write_buffer));
+    if (m_opts.async_flush) FileWriteback(fileout.Get(), fileOutPos, m_write_buffer.size());
 
     return true;
 }
@@ -996,7 +1310,7 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
             // the caller would assume the undo data not to be written, when in
             // fact it is. Note though, that a failed flush might leave the data
             // file untrimmed.
-            if (!FlushUndoFile(_pos.nFile, true)) {
+            if (!FlushUndoFile(_pos.nFile, /*finalize=*/true, /*background=*/true)) {
                 LogPrintLevel(BCLog::BLOCKSTORAGE, BCLog::Level::Warning, "Failed to flush undo file %05i\n", _pos.nFile);
             }
         } else if (_pos.nFile == cursor.file_num && block.nHeight > cursor.undo_height) {
@@ -1015,17 +1329,31 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) cons
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein{OpenBlockFile(pos, true)};
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-    }
+    if (IsBlockFileCompressed(pos.nFile)) {
+        std::vector<uint8_t> block_data;
+        if (!ReadRawBlockFromCompressedFile(block_data, pos)) {
+            return false;
+        }
+        try {
+            SpanReader{CLIENT_VERSION, block_data} >> block;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein{OpenBlockFile(pos, true)};
+        if (filein.IsNull()) {
+            // The block file may have been compressed since it was checked.
+            if (IsBlockFileCompressed(pos.nFile)) return ReadBlockFromDisk(block, pos);
+            return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+        }
 
-    // Read block
-    try {
-        filein >> block;
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        // Read block
+        try {
+            filein >> block;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
     }
 
     // Check the header
@@ -1057,10 +1385,16 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) co
 
 bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const
 {
+    if (IsBlockFileCompressed(pos.nFile)) {
+        return ReadRawBlockFromCompressedFile(block, pos);
+    }
+
     FlatFilePos hpos = pos;
     hpos.nPos -= 8; // Seek back 8 bytes for meta header
     CAutoFile filein{OpenBlockFile(hpos, true)};
     if (filein.IsNull()) {
+        // The block file may have been compressed since it was checked.
+        if (IsBlockFileCompressed(pos.nFile)) return ReadRawBlockFromCompressedFile(block, pos);
         return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
     }
 
@@ -1090,6 +1424,196 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+bool BlockManager::ReadRawBlockFromCompressedFile(std::vector<uint8_t>& block, const FlatFilePos& pos) const
+{
+    const auto file{CompressedBlockFile::Open(CompressedBlockFileSeq().FileName(pos))};
+    if (!file) {
+        return error("%s: Opening compressed block file failed for %s", __func__, pos.ToString());
+    }
+    if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+        return error("%s: Invalid block position %s", __func__, pos.ToString());
+    }
+
+    std::array<std::byte, BLOCK_SERIALIZATION_HEADER_SIZE> header;
+    if (!file->Read(pos.nPos - BLOCK_SERIALIZATION_HEADER_SIZE, header)) {
+        return error("%s: Read from compressed block file failed for %s", __func__, pos.ToString());
+    }
+
+    MessageStartChars blk_start;
+    unsigned int blk_size;
+    SpanReader{CLIENT_VERSION, MakeUCharSpan(header)} >> blk_start >> blk_size;
+
+    if (blk_start != GetParams().MessageStart()) {
+        return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                     HexStr(blk_start),
+                     HexStr(GetParams().MessageStart()));
+    }
+
+    if (blk_size > MAX_SIZE) {
+        return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
+                     blk_size, MAX_SIZE);
+    }
+
+    block.resize(blk_size); // Zeroing of memory is intentional here
+    if (!file->Read(pos.nPos, MakeWritableByteSpan(block))) {
+        return error("%s: Read from compressed block file failed for %s", __func__, pos.ToString());
+    }
+    return true;
+}
+
+bool BlockManager::IsBlockFileCompressed(int file) const
+{
+    LOCK(m_compressed_files_mutex);
+    return m_compressed_files.count(file) > 0;
+}
+
+void BlockManager::ScanCompressedBlockFiles()
+{
+    std::error_code ec;
+    LOCK(m_compressed_files_mutex);
+    m_compressed_files.clear();
+    for (fs::directory_iterator it(m_opts.blocks_dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        const std::string path = fs::PathToString(it->path().filename());
+        if (path.length() < 12 || path.substr(0, 3) != "blz") continue;
+        if (path.substr(8) == ".dat.tmp") {
+            // Left over from an interrupted compression or restore
+            fs::remove(it->path(), ec);
+            continue;
+        }
+        if (path.length() != 12 || path.substr(8, 4) != ".dat") continue;
+        const auto file{ToIntegral<int>(path.substr(3, 5))};
+        if (!file) continue;
+        m_compressed_files.insert(*file);
+    }
+    for (const int file : m_compressed_files) {
+        // The block file is only removed once the compressed file is complete
+        const fs::path block_path{BlockFileSeq().FileName(FlatFilePos(file, 0))};
+        fs::remove(block_path + ".tmp", ec);
+        if (fs::remove(block_path, ec)) {
+            LogPrint(BCLog::BLOCKSTORAGE, "Removed block file %05i which was already compressed\n", file);
+        }
+    }
+    if (!m_compressed_files.empty()) {
+        LogPrintf("Found %d compressed block files\n", m_compressed_files.size());
+    }
+}
+
+bool BlockManager::RestoreBlockFile(int file)
+{
+    const FlatFilePos pos(file, 0);
+    const fs::path compressed_path{CompressedBlockFileSeq().FileName(pos)};
+    if (!DecompressBlockFile(compressed_path, BlockFileSeq().FileName(pos))) {
+        return error("%s: Decompressing block file %05i failed", __func__, file);
+    }
+    WITH_LOCK(m_compressed_files_mutex, m_compressed_files.erase(file));
+    std::error_code ec;
+    fs::remove(compressed_path, ec);
+    return true;
+}
+
+std::vector<int> BlockManager::FindBlockFilesToCompress()
+{
+    std::vector<int> files;
+    if (LoadingBlocks()) return files;
+    // Finalized block files are only compressed once they are truncated
+    SyncFileFlushes();
+
+    LOCK(cs_LastBlockFile);
+    for (int file = 0; file < static_cast<int>(m_blockfile_info.size()); ++file) {
+        if (m_blockfile_info[file].nSize == 0) continue;
+        // Files still being written to are never compressed
+        const bool in_use{std::any_of(m_blockfile_cursors.begin(), m_blockfile_cursors.end(),
+                                      [&](const auto& cursor) { return cursor && cursor->file_num == file; })};
+        if (in_use || IsBlockFileCompressed(file)) continue;
+        files.push_back(file);
+    }
+    return files;
+}
+
+bool BlockManager::CompressOneBlockFile(int file)
+{
+    const FlatFilePos pos(file, 0);
+    const fs::path compressed_path{CompressedBlockFileSeq().FileName(pos)};
+    const auto start{SteadyClock::now()};
+    if (!CompressBlockFile(BlockFileSeq().FileName(pos), compressed_path)) {
+        return false;
+    }
+
+    std::error_code ec;
+    unsigned int size;
+    {
+        LOCK(cs_LastBlockFile);
+        if (static_cast<size_t>(file) >= m_blockfile_info.size() || m_blockfile_info[file].nSize == 0) {
+            // The file was pruned in the meantime
+            fs::remove(compressed_path, ec);
+            return true;
+        }
+        size = m_blockfile_info[file].nSize;
+        WITH_LOCK(m_compressed_files_mutex, m_compressed_files.insert(file));
+    }
+    // Readers check for the compressed file when the block file is gone
+    fs::remove(BlockFileSeq().FileName(pos), ec);
+
+    LogPrint(BCLog::BLOCKSTORAGE, "Compressed block file %05i from %u to %u bytes in %dms\n", file,
+             size, fs::file_size(compressed_path, ec),
+             Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+    return true;
+}
+
+void BlockManager::ThreadCompressBlockFiles()
+{
+    std::set<int> failed_files;
+    WAIT_LOCK(m_compression_mutex, lock);
+    while (!m_stop_compression) {
+        m_compression_pending = false;
+        std::vector<int> files;
+        {
+            REVERSE_LOCK(lock);
+            files = FindBlockFilesToCompress();
+        }
+        for (const int file : files) {
+            if (m_stop_compression) break;
+            if (failed_files.count(file)) continue;
+            REVERSE_LOCK(lock);
+            if (!CompressOneBlockFile(file)) {
+                LogPrintf("Failed to compress block file %05i, leaving it uncompressed\n", file);
+                failed_files.insert(file);
+            }
+        }
+        m_compression_cv.wait_for(lock, BLOCK_COMPRESSION_INTERVAL, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_compression_mutex) {
+            return m_stop_compression || m_compression_pending;
+        });
+    }
+}
+
+void BlockManager::StartBlockFileCompression()
+{
+    if (!m_opts.compress_block_files || m_thread_compression.joinable()) return;
+    WITH_LOCK(m_compression_mutex, m_stop_compression = false);
+    m_thread_compression = std::thread(&util::TraceThread, "blkcompress", [this] { ThreadCompressBlockFiles(); });
+}
+
+void BlockManager::StopBlockFileCompression()
+{
+    WITH_LOCK(m_compression_mutex, m_stop_compression = true);
+    m_compression_cv.notify_all();
+    if (m_thread_compression.joinable()) m_thread_compression.join();
+}
+
+BlockManager::~BlockManager()
+{
+    StopBlockFileCompression();
+
+    std::thread thread_flush;
+    {
+        LOCK(m_flush_mutex);
+        m_stop_flush = true;
+        thread_flush = std::move(m_thread_flush);
+    }
+    m_flush_cv.notify_all();
+    if (thread_flush.joinable()) thread_flush.join();
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp)
 {
     unsigned int nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
@@ -1148,6 +1672,9 @@ void ImportBlocks(ChainstateManager& chainman, std::vector<fs::path> vImportFile
             std::multimap<uint256, FlatFilePos> blocks_with_unknown_parent;
             while (true) {
                 FlatFilePos pos(nFile, 0);
+                if (chainman.m_blockman.IsBlockFileCompressed(nFile) && !chainman.m_blockman.RestoreBlockFile(nFile)) {
+                    break; // This error is logged in RestoreBlockFile
+                }
                 if (!fs::exists(chainman.m_blockman.GetBlockPosFilename(pos))) {
                     break; // No block files left to reindex
                 }
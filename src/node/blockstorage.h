@@ -13,18 +13,23 @@
 #include <kernel/chainparams.h>
 #include <kernel/cs_main.h>
 #include <kernel/messagestartchars.h>
+#include <node/blockmap.h>
 #include <sync.h>
 #include <util/fs.h>
 #include <util/hasher.h>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -54,6 +59,9 @@ public:
     bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo& info);
     bool ReadLastBlockFile(int& nFile);
+    /** Write the id of the block index snapshot matching the database, or erase it. */
+    bool WriteBlockIndexSnapshotId(std::optional<uint64_t> id);
+    bool ReadBlockIndexSnapshotId(uint64_t& id);
     bool WriteReindexing(bool fReindexing);
     void ReadReindexing(bool& fReindexing);
     bool WriteFlag(const std::string& name, bool fValue);
@@ -76,13 +84,10 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = std::tuple_size_v<MessageStartChars> + sizeof(unsigned int);
 
-extern std::atomic_bool fReindex;
+/** How often finalized block files are looked for to be compressed, besides when a block file is finalized */
+static constexpr auto BLOCK_COMPRESSION_INTERVAL{std::chrono::minutes{10}};
 
-// Because validation code takes pointers to the map's CBlockIndex objects, if
-// we ever switch to another associative container, we need to either use a
-// container that has stable addressing (true of all std associative
-// containers), or make the key a `std::unique_ptr<CBlockIndex>`
-using BlockMap = std::unordered_map<uint256, CBlockIndex, BlockHasher>;
+extern std::atomic_bool fReindex;
 
 struct CBlockIndexWorkComparator {
     bool operator()(const CBlockIndex* pa, const CBlockIndex* pb) const;
@@ -149,23 +154,54 @@ private:
     bool LoadBlockIndex(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-    /** Return false if block file or undo file flushing fails. */
-    [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo);
+    /** Block index snapshot file written at shutdown, see WriteBlockIndexSnapshot(). */
+    fs::path BlockIndexSnapshotPath() const { return m_opts.blocks_dir / "blockindex.dat"; }
+
+    /**
+     * Load the block index from the snapshot file written at the last
+     * shutdown, if it matches the block tree database. The snapshot is
+     * consumed: it is removed, and its id erased from the database, so that
+     * later changes to the database aren't shadowed by it.
+     *
+     * @returns the loaded entries ordered by height, or std::nullopt if there
+     *          is no usable snapshot, in which case m_block_index is left empty.
+     */
+    std::optional<std::vector<CBlockIndex*>> LoadBlockIndexSnapshot() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Return false if block file or undo file flushing fails. With background,
+     * the flush is queued if BlockManagerOpts::async_flush is set, see
+     * FlushFile().
+     */
+    [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo, bool background = false) EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
 
     /** Return false if undo file flushing fails. */
-    [[nodiscard]] bool FlushUndoFile(int block_file, bool finalize = false);
+    [[nodiscard]] bool FlushUndoFile(int block_file, bool finalize = false, bool background = false) EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
 
-    [[nodiscard]] bool FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigned int nHeight, uint64_t nTime, bool fKnown);
-    [[nodiscard]] bool FlushChainstateBlockFile(int tip_height);
+    [[nodiscard]] bool FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigned int nHeight, uint64_t nTime, bool fKnown) EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
+    [[nodiscard]] bool FlushChainstateBlockFile(int tip_height) EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
     bool FindUndoPos(BlockValidationState& state, int nFile, FlatFilePos& pos, unsigned int nAddSize);
 
     FlatFileSeq BlockFileSeq() const;
     FlatFileSeq UndoFileSeq() const;
+    /** Compressed replacements of finalized block files (blz?????.dat) */
+    FlatFileSeq CompressedBlockFileSeq() const;
 
     CAutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
-    bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const;
-    bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock) const;
+    bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_write_buffer_mutex);
+    bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock) const EXCLUSIVE_LOCKS_REQUIRED(!m_write_buffer_mutex);
+
+    /**
+     * Buffer that a block or undo record is serialized into before being
+     * written to disk with a single write, reused across records.
+     */
+    mutable Mutex m_write_buffer_mutex;
+    mutable std::vector<unsigned char> m_write_buffer GUARDED_BY(m_write_buffer_mutex);
+
+    /** Serialize the index header (network magic and size) followed by data into m_write_buffer. */
+    template <typename T>
+    void SerializeRecord(const T& data) const EXCLUSIVE_LOCKS_REQUIRED(m_write_buffer_mutex);
 
     /* Calculate the block/rev files to delete based on height specified by user with RPC command pruneblockchain */
     void FindFilesToPruneManual(
@@ -246,6 +282,55 @@ private:
 
     BlockfileType BlockfileTypeForHeight(int height);
 
+    /**
+     * Block files that were replaced by a compressed file. A file is added
+     * once its compressed file is complete, before the block file is removed,
+     * so readers that find neither the block file nor its number here can
+     * report the block as missing.
+     */
+    mutable Mutex m_compressed_files_mutex;
+    std::set<int> m_compressed_files GUARDED_BY(m_compressed_files_mutex);
+
+    Mutex m_compression_mutex;
+    std::condition_variable m_compression_cv;
+    bool m_compression_pending GUARDED_BY(m_compression_mutex){false};
+    bool m_stop_compression GUARDED_BY(m_compression_mutex){false};
+    std::thread m_thread_compression;
+
+    /** Finalized block files that haven't been compressed yet. */
+    std::vector<int> FindBlockFilesToCompress() EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex, !m_flush_mutex);
+    /** Replace a finalized block file by a compressed file. */
+    bool CompressOneBlockFile(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
+    void ThreadCompressBlockFiles() EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex, !m_compression_mutex, !m_flush_mutex);
+    /** Read the raw block at pos from the compressed replacement of its block file. */
+    bool ReadRawBlockFromCompressedFile(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
+
+    /**
+     * A flush of a block or undo file, up to pos. Files are flushed on a
+     * background thread once they are done being written to, so that
+     * validation doesn't wait for their fsync. Queued flushes are done in
+     * order, and before the block index is written, pruned files are
+     * unlinked or block files are compressed, see SyncFileFlushes().
+     */
+    struct FileFlush {
+        bool undo;
+        FlatFilePos pos;
+        bool finalize;
+    };
+    Mutex m_flush_mutex;
+    std::condition_variable m_flush_cv;
+    //! Flushes waiting to be done, the front one is being done
+    std::deque<FileFlush> m_flush_queue GUARDED_BY(m_flush_mutex);
+    bool m_stop_flush GUARDED_BY(m_flush_mutex){false};
+    //! Started by the first queued flush
+    std::thread m_thread_flush GUARDED_BY(m_flush_mutex);
+
+    /** Flush a file, or queue the flush if background and BlockManagerOpts::async_flush are set. */
+    bool FlushFile(const FileFlush& flush, bool background) EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
+    void ThreadFlushFiles() EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
+    /** Wait for the file flushes queued so far to be done. */
+    void SyncFileFlushes() EXCLUSIVE_LOCKS_REQUIRED(!m_flush_mutex);
+
     const kernel::BlockManagerOpts m_opts;
 
 public:
@@ -255,6 +340,7 @@ public:
         : m_prune_mode{opts.prune_target > 0},
           m_opts{std::move(opts)},
           m_interrupt{interrupt} {};
+    ~BlockManager();
 
     const util::SignalInterrupt& m_interrupt;
     std::atomic<bool> m_importing{false};
@@ -285,10 +371,21 @@ public:
 
     std::unique_ptr<BlockTreeDB> m_block_tree_db GUARDED_BY(::cs_main);
 
+    //! Whether m_block_index holds the whole block tree database, so a snapshot of it can be written
+    bool m_block_index_loaded GUARDED_BY(::cs_main){false};
+
     bool WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    /**
+     * Write the block index, ordered by height, to a snapshot file that is
+     * loaded instead of the block tree database on the next start, which
+     * avoids hashing every header again. Called on clean shutdown, once the
+     * block index has been flushed; does nothing if it hasn't been.
+     */
+    bool WriteBlockIndexSnapshot() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     /**
      * Remove any pruned block & undo files that are still on disk.
      * This could happen on some systems if the file was still being read while unlinked,
@@ -310,10 +407,10 @@ public:
     CBlockFileInfo* GetBlockFileInfo(size_t n);
 
     bool WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValidationState& state, CBlockIndex& block)
-        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_write_buffer_mutex, !m_flush_mutex);
 
     /** Store block on disk. If dbp is not nullptr, then it provides the known position of the block within a block file on disk. */
-    FlatFilePos SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp);
+    FlatFilePos SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp) EXCLUSIVE_LOCKS_REQUIRED(!m_write_buffer_mutex, !m_flush_mutex);
 
     /** Whether running in -prune mode. */
     [[nodiscard]] bool IsPruneMode() const { return m_prune_mode; }
@@ -352,19 +449,38 @@ public:
     /** Open a block file (blk?????.dat) */
     CAutoFile OpenBlockFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
+    /** Find the block files that were replaced by compressed files, and finish or undo interrupted (de)compressions. */
+    void ScanCompressedBlockFiles() EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
+
+    /** Whether a block file was replaced by a compressed file. */
+    bool IsBlockFileCompressed(int file) const EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
+
+    /** Decompress a compressed block file back into its block file, e.g. to reindex it. */
+    bool RestoreBlockFile(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
+
+    /**
+     * Start compressing finalized block files in the background, if enabled
+     * by BlockManagerOpts::compress_block_files. Reads of blocks in compressed
+     * files decompress only the frames that contain them.
+     */
+    void StartBlockFileCompression() EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex, !m_compression_mutex);
+    void StopBlockFileCompression() EXCLUSIVE_LOCKS_REQUIRED(!m_compression_mutex);
+
     /** Translation to a filesystem path */
     fs::path GetBlockPosFilename(const FlatFilePos& pos) const;
 
     /**
      *  Actually unlink the specified files
      */
-    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const;
+    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex, !m_flush_mutex);
 
     /** Functions for disk access for blocks */
-    bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const;
-    bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
-    bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
+    bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
+    bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
+    bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_compressed_files_mutex);
 
+    /** Read the undo data at pos of the block whose parent is prev_hash. */
+    bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_hash) const;
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
     void CleanupBlockRevFiles() const;
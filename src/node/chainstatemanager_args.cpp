@@ -37,6 +37,20 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
 
     if (auto value{args.GetIntArg("-maxtipage")}) opts.max_tip_age = std::chrono::seconds{*value};
 
+    if (auto value{args.GetIntArg("-backgroundvalidationlatency")}) {
+        if (*value <= 0) {
+            return util::Error{strprintf(Untranslated("Invalid -backgroundvalidationlatency value: %d (must be positive)"), *value)};
+        }
+        opts.background_validation_latency = std::chrono::milliseconds{*value};
+    }
+
+    if (auto value{args.GetIntArg("-blockprefetch")}) {
+        if (*value < 0) {
+            return util::Error{strprintf(Untranslated("Invalid -blockprefetch value: %d (must not be negative)"), *value)};
+        }
+        opts.block_prefetch = *value;
+    }
+
     ReadDatabaseArgs(args, opts.block_tree_db);
     ReadDatabaseArgs(args, opts.coins_db);
     ReadCoinsViewArgs(args, opts.coins_view);
@@ -7,6 +7,9 @@
 #include <common/args.h>
 #include <dbwrapper.h>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace node {
 void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
 {
@@ -14,5 +17,10 @@ void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
     // databases), but it'd be easy to parse database-specific options by adding
     // a database_type string or enum parameter to this function.
     if (auto value = args.GetBoolArg("-forcecompactdb")) options.force_compact = *value;
+    if (auto value = args.GetIntArg("-dbwritebuffersize")) options.write_buffer_size = std::max<int64_t>(*value, 0);
+    if (auto value = args.GetIntArg("-dbmaxfilesize")) options.max_file_size = std::max<int64_t>(*value, 0);
+    if (auto value = args.GetIntArg("-dbblocksize")) options.block_size = std::max<int64_t>(*value, 0);
+    if (auto value = args.GetIntArg("-dbbloombits")) options.bloom_filter_bits = std::clamp<int64_t>(*value, 0, 64);
+    if (auto value = args.GetBoolArg("-dbasyncwrite")) options.async_write = *value;
 }
 } // namespace node
@@ -23,6 +23,12 @@ void ApplyArgsManOptions(const ArgsManager& argsman, PeerManager::Options& optio
     if (auto value{argsman.GetBoolArg("-capturemessages")}) options.capture_messages = *value;
 
     if (auto value{argsman.GetBoolArg("-blocksonly")}) options.ignore_incoming_txs = *value;
+
+    if (auto value{argsman.GetBoolArg("-fastblockrelay")}) options.fast_block_relay = *value;
+
+    if (auto value{argsman.GetIntArg("-headerssyncpeers")}) {
+        options.headers_sync_peers = uint32_t(std::clamp<int64_t>(*value, 0, MAX_OUTBOUND_FULL_RELAY_CONNECTIONS));
+    }
 }
 
 } // namespace node
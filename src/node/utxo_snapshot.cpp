@@ -4,19 +4,30 @@
 
 #include <node/utxo_snapshot.h>
 
+#include <coins.h>
+#include <consensus/amount.h>
 #include <logging.h>
+#include <primitives/transaction.h>
+#include <random.h>
 #include <streams.h>
 #include <sync.h>
 #include <tinyformat.h>
 #include <txdb.h>
 #include <uint256.h>
 #include <util/fs.h>
+#include <util/signalinterrupt.h>
+#include <util/thread.h>
 #include <validation.h>
 
+#include <atomic>
 #include <cassert>
 #include <cstdio>
+#include <exception>
+#include <limits>
 #include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace node {
 
@@ -81,6 +92,151 @@ std::optional<uint256> ReadSnapshotBaseBlockhash(fs::path chaindir)
     return base_blockhash;
 }
 
+int SnapshotThreads()
+{
+    return std::clamp<int>(std::thread::hardware_concurrency(), 1, MAX_SNAPSHOT_THREADS);
+}
+
+DataStream SerializeSnapshotPartitions(CCoinsViewCursor& cursor, const std::function<void()>& interruption_point)
+{
+    DataStream partitions{};
+    DataStream partition{};
+    uint32_t partition_coins{0};
+    const auto write_partition{[&] {
+        partitions << SnapshotPartitionHeader{partition_coins, static_cast<uint32_t>(partition.size())};
+        partitions.write(MakeByteSpan(partition));
+        partition.clear();
+        partition_coins = 0;
+    }};
+
+    COutPoint key;
+    Coin coin;
+    unsigned int iter{0};
+    for (; cursor.Valid(); cursor.Next()) {
+        if (iter++ % 5000 == 0 && interruption_point) interruption_point();
+        if (cursor.GetKey(key) && cursor.GetValue(coin)) {
+            partition << key << coin;
+            if (++partition_coins == SNAPSHOT_PARTITION_COINS || partition.size() >= SNAPSHOT_PARTITION_SIZE) {
+                write_partition();
+            }
+        }
+    }
+    if (partition_coins > 0) write_partition();
+    return partitions;
+}
+
+bool LoadSnapshotPartitions(CCoinsViewDB& coins_db, AutoFile& coins_file, const SnapshotMetadata& metadata,
+                            int base_height, size_t cache_size, int num_threads, const util::SignalInterrupt& interrupt)
+{
+    assert(metadata.m_partitioned);
+    Mutex file_mutex;
+    uint64_t coins_left{metadata.m_coins_count};
+    std::atomic<uint64_t> coins_processed{0};
+    std::atomic<bool> failed{false};
+
+    // The threads flush their coins under a placeholder best block, as the
+    // coins don't reflect any block until they are all loaded. It must be the
+    // same for all threads, which may be in the middle of flushing at once.
+    const uint256 loading_blockhash{GetRandHash()};
+    const size_t thread_cache_size{cache_size / num_threads};
+
+    const auto load_partitions{[&] {
+        CCoinsViewCache coins_cache{&coins_db};
+        coins_cache.SetBestBlock(loading_blockhash);
+        std::vector<unsigned char> data;
+        while (!failed) {
+            SnapshotPartitionHeader header;
+            uint64_t coins_before;
+            {
+                LOCK(file_mutex);
+                if (coins_left == 0) break;
+                coins_before = metadata.m_coins_count - coins_left;
+                try {
+                    coins_file >> header;
+                    if (header.coins_count > coins_left) {
+                        LogPrintf("[snapshot] bad snapshot - coins left over after deserializing %d coins\n",
+                                  metadata.m_coins_count);
+                        failed = true;
+                        break;
+                    }
+                    if (header.coins_count == 0 || header.size > MAX_SNAPSHOT_PARTITION_SIZE) {
+                        LogPrintf("[snapshot] bad snapshot partition header after deserializing %d coins\n",
+                                  coins_before);
+                        failed = true;
+                        break;
+                    }
+                    data.resize(header.size);
+                    coins_file.read(MakeWritableByteSpan(data));
+                } catch (const std::ios_base::failure&) {
+                    LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                              coins_before);
+                    failed = true;
+                    break;
+                }
+                coins_left -= header.coins_count;
+            }
+
+            SpanReader stream{/*version=*/0, data};
+            COutPoint outpoint;
+            Coin coin;
+            for (uint32_t i = 0; i < header.coins_count && !failed; ++i) {
+                try {
+                    stream >> outpoint;
+                    stream >> coin;
+                } catch (const std::ios_base::failure&) {
+                    LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                              coins_before + i);
+                    failed = true;
+                    break;
+                }
+                if (coin.nHeight > base_height ||
+                    outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+                ) {
+                    LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
+                              coins_before + i);
+                    failed = true;
+                    break;
+                }
+                if (!MoneyRange(coin.out.nValue)) {
+                    LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - bad tx out value\n",
+                              coins_before + i);
+                    failed = true;
+                    break;
+                }
+                coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
+            }
+            if (failed) break;
+            if (!stream.empty()) {
+                LogPrintf("[snapshot] bad snapshot - trailing data in partition after deserializing %d coins\n",
+                          coins_before + header.coins_count);
+                failed = true;
+                break;
+            }
+
+            const uint64_t processed{coins_processed += header.coins_count};
+            if (processed / 1000000 != (processed - header.coins_count) / 1000000) {
+                LogPrintf("[snapshot] %d coins loaded (%.2f%%)\n",
+                          processed, static_cast<float>(processed) * 100 / static_cast<float>(metadata.m_coins_count));
+            }
+            if (interrupt) {
+                failed = true;
+                break;
+            }
+            if (coins_cache.DynamicMemoryUsage() >= thread_cache_size && !coins_cache.Flush()) {
+                failed = true;
+            }
+        }
+        if (!failed && !coins_cache.Flush()) failed = true;
+    }};
+
+    std::vector<std::thread> threads;
+    for (int n = 0; n < num_threads; ++n) {
+        threads.emplace_back(&util::TraceThread, strprintf("snapshot.%i", n), load_partitions);
+    }
+    for (std::thread& thread : threads) thread.join();
+    return !failed;
+}
+
 std::optional<fs::path> FindSnapshotChainstateDir(const fs::path& data_dir)
 {
     fs::path possible_dir =
@@ -8,17 +8,48 @@
 
 #include <kernel/cs_main.h>
 #include <serialize.h>
+#include <span.h>
+#include <streams.h>
 #include <sync.h>
+#include <tinyformat.h>
 #include <uint256.h>
 #include <util/fs.h>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <functional>
+#include <ios>
 #include <optional>
 #include <string_view>
 
+class CCoinsViewCursor;
+class CCoinsViewDB;
 class Chainstate;
+namespace util {
+class SignalInterrupt;
+} // namespace util
 
 namespace node {
+//! Magic bytes at the start of a partitioned snapshot. Snapshots in the
+//! legacy format start with the base blockhash instead.
+static constexpr std::array<uint8_t, 5> SNAPSHOT_MAGIC_BYTES{'u', 't', 'x', 'o', 0xff};
+
+//! Version of the partitioned snapshot format.
+static constexpr uint16_t SNAPSHOT_VERSION{2};
+
+//! The coins of a partitioned snapshot are split in partitions of at most
+//! this many coins, or of about SNAPSHOT_PARTITION_SIZE bytes.
+static constexpr uint32_t SNAPSHOT_PARTITION_COINS{1 << 16};
+static constexpr uint32_t SNAPSHOT_PARTITION_SIZE{4 << 20};
+
+//! A partition is closed once it reaches SNAPSHOT_PARTITION_SIZE, so it can
+//! only exceed it by the size of a coin.
+static constexpr uint32_t MAX_SNAPSHOT_PARTITION_SIZE{2 * SNAPSHOT_PARTITION_SIZE};
+
+//! Maximum number of threads writing, loading or hashing a snapshot.
+static constexpr int MAX_SNAPSHOT_THREADS{8};
+
 //! Metadata describing a serialized version of a UTXO set from which an
 //! assumeutxo Chainstate can be constructed.
 class SnapshotMetadata
@@ -32,16 +63,75 @@ public:
     //! during snapshot load to estimate progress of UTXO set reconstruction.
     uint64_t m_coins_count = 0;
 
+    //! Whether the coins are split in partitions that can be loaded in
+    //! parallel, or serialized one after the other in the legacy format.
+    bool m_partitioned = false;
+
     SnapshotMetadata() { }
     SnapshotMetadata(
         const uint256& base_blockhash,
-        uint64_t coins_count) :
+        uint64_t coins_count,
+        bool partitioned = false) :
             m_base_blockhash(base_blockhash),
-            m_coins_count(coins_count) { }
+            m_coins_count(coins_count),
+            m_partitioned(partitioned) { }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        if (m_partitioned) s << SNAPSHOT_MAGIC_BYTES << SNAPSHOT_VERSION;
+        s << m_base_blockhash << m_coins_count;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        std::array<uint8_t, SNAPSHOT_MAGIC_BYTES.size()> magic;
+        s >> magic;
+        m_partitioned = magic == SNAPSHOT_MAGIC_BYTES;
+        if (m_partitioned) {
+            uint16_t version;
+            s >> version;
+            if (version != SNAPSHOT_VERSION) {
+                throw std::ios_base::failure(strprintf("Unsupported snapshot version %d", version));
+            }
+            s >> m_base_blockhash;
+        } else {
+            // The bytes read are the start of the base blockhash of a legacy snapshot.
+            std::copy(magic.begin(), magic.end(), m_base_blockhash.begin());
+            s.read(MakeWritableByteSpan(Span{m_base_blockhash.begin() + magic.size(), m_base_blockhash.end()}));
+        }
+        s >> m_coins_count;
+    }
+};
+
+//! Header of a partition of a snapshot: a run of coins from a range of
+//! outpoints, which can be deserialized independently of the other partitions.
+struct SnapshotPartitionHeader {
+    uint32_t coins_count{0};
+    uint32_t size{0};
 
-    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count); }
+    SERIALIZE_METHODS(SnapshotPartitionHeader, obj) { READWRITE(obj.coins_count, obj.size); }
 };
 
+//! Number of threads to write, load and hash a snapshot with.
+int SnapshotThreads();
+
+//! Serialize the coins of a cursor into snapshot partitions, each preceded by
+//! its header.
+DataStream SerializeSnapshotPartitions(CCoinsViewCursor& cursor, const std::function<void()>& interruption_point);
+
+//! Load the coins of a partitioned snapshot into a coins database. Threads
+//! take turns reading the next partition from the file, and check and add
+//! its coins to their own coins cache, which they flush to the database when
+//! it grows past cache_size / num_threads. The best block of the database is
+//! left to the caller to set.
+//!
+//! @returns false, after logging why, if the snapshot is invalid or loading
+//!          was interrupted.
+bool LoadSnapshotPartitions(CCoinsViewDB& coins_db, AutoFile& coins_file, const SnapshotMetadata& metadata,
+                            int base_height, size_t cache_size, int num_threads, const util::SignalInterrupt& interrupt);
+
 //! The file in the snapshot chainstate dir which stores the base blockhash. This is
 //! needed to reconstruct snapshot chainstates on init.
 //!
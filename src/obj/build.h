@@ -0,0 +1 @@
+#define BUILD_GIT_COMMIT "1658fcbbc339-dirty"
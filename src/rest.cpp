@@ -11,6 +11,7 @@
 #include <core_io.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/scriptindex.h>
 #include <index/txindex.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
@@ -573,6 +574,62 @@ static bool rest_block_filter(const std::any& context, HTTPRequest* req, const s
     }
 }
 
+static bool rest_script_history(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req)) return false;
+
+    std::string script_hex;
+    const RESTResponseFormat rf = ParseDataFormat(script_hex, strURIPart);
+    if (rf != RESTResponseFormat::JSON) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+
+    if (!g_scriptindex) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Script index is not enabled (-scriptindex)");
+    }
+    if (!IsHex(script_hex)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid script: " + script_hex);
+    }
+    const std::vector<unsigned char> script_data{ParseHex(script_hex)};
+    const CScript script(script_data.begin(), script_data.end());
+
+    std::string raw_count;
+    std::optional<std::string> raw_cursor;
+    try {
+        raw_count = req->GetQueryParameter("count").value_or("100");
+        raw_cursor = req->GetQueryParameter("cursor");
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+    const auto count{ToIntegral<size_t>(raw_count)};
+    if (!count || *count < 1 || *count > MAX_SCRIPTINDEX_RESULTS) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Output count is invalid or out of acceptable range (1-%u): %s", MAX_SCRIPTINDEX_RESULTS, raw_count));
+    }
+    ScriptOutputPos start;
+    if (raw_cursor) {
+        const auto cursor{ParseScriptHistoryCursor(*raw_cursor)};
+        if (!cursor) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid cursor: " + *raw_cursor);
+        }
+        start = *cursor;
+    }
+
+    if (!g_scriptindex->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Script history is still in the process of being indexed.");
+    }
+
+    std::vector<ScriptOutput> outputs;
+    std::optional<ScriptOutputPos> next;
+    if (!g_scriptindex->FindScriptOutputs(script, start, *count, outputs, next)) {
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Unable to read the script history");
+    }
+
+    std::string strJSON = ScriptHistoryToJSON(script, outputs, next).write() + "\n";
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, strJSON);
+    return true;
+}
+
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
 RPCHelpMan getblockchaininfo();
 
@@ -1010,6 +1067,7 @@ static const struct {
       {"/rest/block/", rest_block_extended},
       {"/rest/blockfilter/", rest_block_filter},
       {"/rest/blockfilterheaders/", rest_filter_header},
+      {"/rest/scripthistory/", rest_script_history},
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/", rest_mempool},
       {"/rest/headers/", rest_headers},
@@ -20,6 +20,7 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/scriptindex.h>
 #include <kernel/coinstats.h>
 #include <logging/timer.h>
 #include <net.h>
@@ -41,6 +42,7 @@
 #include <univalue.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/parallel.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
 #include <validation.h>
@@ -836,7 +838,7 @@ CoinStatsHashType ParseHashType(const std::string& hash_type_input)
  *
  * @param[in] index_requested Signals if the coinstatsindex should be used (when available).
  */
-static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsView* view, node::BlockManager& blockman,
+static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsViewDB* view, node::BlockManager& blockman,
                                                        kernel::CoinStatsHashType hash_type,
                                                        const std::function<void()>& interruption_point = {},
                                                        const CBlockIndex* pindex = nullptr,
@@ -858,7 +860,7 @@ static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsView* view, node::B
     // best block.
     CHECK_NONFATAL(!pindex || pindex->GetBlockHash() == view->GetBestBlock());
 
-    return kernel::ComputeUTXOStats(hash_type, view, blockman, interruption_point);
+    return kernel::ComputeUTXOStats(hash_type, view, blockman, interruption_point, node::SnapshotThreads());
 }
 
 static RPCHelpMan gettxoutsetinfo()
@@ -927,7 +929,7 @@ static RPCHelpMan gettxoutsetinfo()
     Chainstate& active_chainstate = chainman.ActiveChainstate();
     active_chainstate.ForceFlushStateToDisk();
 
-    CCoinsView* coins_view;
+    CCoinsViewDB* coins_view;
     BlockManager* blockman;
     {
         LOCK(::cs_main);
@@ -2565,6 +2567,117 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+std::optional<ScriptOutputPos> ParseScriptHistoryCursor(const std::string& cursor)
+{
+    const std::vector<std::string> parts{SplitString(cursor, '-')};
+    if (parts.size() != 3) return std::nullopt;
+    const auto height{ToIntegral<int>(parts[0])};
+    const auto tx_index{ToIntegral<uint32_t>(parts[1])};
+    const auto vout{ToIntegral<uint32_t>(parts[2])};
+    if (!height || *height < 0 || !tx_index || !vout) return std::nullopt;
+    return ScriptOutputPos{*height, *tx_index, *vout};
+}
+
+UniValue ScriptHistoryToJSON(const CScript& script, const std::vector<ScriptOutput>& outputs, const std::optional<ScriptOutputPos>& next)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("scriptPubKey", HexStr(script));
+    UniValue outputs_json(UniValue::VARR);
+    for (const ScriptOutput& output : outputs) {
+        UniValue output_json(UniValue::VOBJ);
+        output_json.pushKV("txid", output.txid.GetHex());
+        output_json.pushKV("vout", uint64_t{output.pos.vout});
+        output_json.pushKV("height", output.pos.height);
+        output_json.pushKV("amount", ValueFromAmount(output.amount));
+        if (output.spend) {
+            UniValue spend_json(UniValue::VOBJ);
+            spend_json.pushKV("txid", output.spend->txid.GetHex());
+            spend_json.pushKV("vin", uint64_t{output.spend->vin});
+            spend_json.pushKV("height", output.spend->height);
+            output_json.pushKV("spent", spend_json);
+        }
+        outputs_json.push_back(output_json);
+    }
+    ret.pushKV("outputs", outputs_json);
+    if (next) {
+        ret.pushKV("next_cursor", strprintf("%d-%u-%u", next->height, next->tx_index, next->vout));
+    }
+    return ret;
+}
+
+static RPCHelpMan getscripthistory()
+{
+    return RPCHelpMan{"getscripthistory",
+                "\nReturns the outputs paying to a scriptPubKey in the active chain, in chain order, with the inputs spending them.\n"
+                "Requires -scriptindex. Results are paginated: pass the returned next_cursor to get the following page.\n",
+                {
+                    {"scriptpubkey", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The hex-encoded scriptPubKey"},
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{100}, strprintf("The maximum number of outputs to return (1-%u)", MAX_SCRIPTINDEX_RESULTS)},
+                    {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The next_cursor returned with the previous page"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "scriptPubKey", "The scriptPubKey"},
+                        {RPCResult::Type::ARR, "outputs", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                                {RPCResult::Type::NUM, "vout", "The output number"},
+                                {RPCResult::Type::NUM, "height", "The height of the block of the transaction"},
+                                {RPCResult::Type::STR_AMOUNT, "amount", "The amount in " + CURRENCY_UNIT},
+                                {RPCResult::Type::OBJ, "spent", /*optional=*/true, "The input spending the output, if it is spent",
+                                {
+                                    {RPCResult::Type::STR_HEX, "txid", "The spending transaction id"},
+                                    {RPCResult::Type::NUM, "vin", "The input number"},
+                                    {RPCResult::Type::NUM, "height", "The height of the block of the spending transaction"},
+                                }},
+                            }},
+                        }},
+                        {RPCResult::Type::STR, "next_cursor", /*optional=*/true, "The cursor of the next page, if there are more outputs"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getscripthistory", "\"0014751e76e8199196d454941c45d1b3a323f1433bd6\"") +
+                    HelpExampleCli("getscripthistory", "\"0014751e76e8199196d454941c45d1b3a323f1433bd6\" 100 \"800000-12-1\"") +
+                    HelpExampleRpc("getscripthistory", "\"0014751e76e8199196d454941c45d1b3a323f1433bd6\", 100")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_scriptindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Requires -scriptindex");
+    }
+    const std::vector<unsigned char> script_data{ParseHexV(request.params[0], "scriptpubkey")};
+    const CScript script(script_data.begin(), script_data.end());
+
+    const int count{request.params[1].isNull() ? 100 : request.params[1].getInt<int>()};
+    if (count < 1 || static_cast<size_t>(count) > MAX_SCRIPTINDEX_RESULTS) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 1 and %u", MAX_SCRIPTINDEX_RESULTS));
+    }
+    ScriptOutputPos start;
+    if (!request.params[2].isNull()) {
+        const auto cursor{ParseScriptHistoryCursor(request.params[2].get_str())};
+        if (!cursor) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        start = *cursor;
+    }
+
+    if (!g_scriptindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to get data because scriptindex is still syncing. Current height: %d",
+                                                     g_scriptindex->GetSummary().best_block_height));
+    }
+
+    std::vector<ScriptOutput> outputs;
+    std::optional<ScriptOutputPos> next;
+    if (!g_scriptindex->FindScriptOutputs(script, start, count, outputs, next)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the script history");
+    }
+    return ScriptHistoryToJSON(script, outputs, next);
+},
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2631,9 +2744,11 @@ UniValue CreateUTXOSnapshot(
     Chainstate& chainstate,
     AutoFile& afile,
     const fs::path& path,
-    const fs::path& temppath)
+    const fs::path& temppath,
+    bool partitioned)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::vector<std::unique_ptr<CCoinsViewCursor>> partition_cursors;
     std::optional<CCoinsStats> maybe_stats;
     const CBlockIndex* tip;
 
@@ -2659,7 +2774,11 @@ UniValue CreateUTXOSnapshot(
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
         }
 
-        pcursor = chainstate.CoinsDB().Cursor();
+        if (partitioned) {
+            partition_cursors = chainstate.CoinsDB().PartitionCursors();
+        } else {
+            pcursor = chainstate.CoinsDB().Cursor();
+        }
         tip = CHECK_NONFATAL(chainstate.m_blockman.LookupBlockIndex(maybe_stats->hashBlock));
     }
 
@@ -2667,23 +2786,32 @@ UniValue CreateUTXOSnapshot(
         tip->nHeight, tip->GetBlockHash().ToString(),
         fs::PathToString(path), fs::PathToString(temppath)));
 
-    SnapshotMetadata metadata{tip->GetBlockHash(), maybe_stats->coins_count};
+    SnapshotMetadata metadata{tip->GetBlockHash(), maybe_stats->coins_count, partitioned};
 
     afile << metadata;
 
-    COutPoint key;
-    Coin coin;
-    unsigned int iter{0};
+    if (partitioned) {
+        // Ranges of outpoints are serialized on several threads, and written
+        // in order so that the snapshot doesn't depend on the thread timings.
+        util::ParallelForOrdered(
+            "snapshot", partition_cursors.size(), node::SnapshotThreads(),
+            [&](size_t i) { return node::SerializeSnapshotPartitions(*partition_cursors[i], node.rpc_interruption_point); },
+            [&](DataStream&& partitions) { afile.write(MakeByteSpan(partitions)); });
+    } else {
+        COutPoint key;
+        Coin coin;
+        unsigned int iter{0};
+
+        while (pcursor->Valid()) {
+            if (iter % 5000 == 0) node.rpc_interruption_point();
+            ++iter;
+            if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+                afile << key;
+                afile << coin;
+            }
 
-    while (pcursor->Valid()) {
-        if (iter % 5000 == 0) node.rpc_interruption_point();
-        ++iter;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            afile << key;
-            afile << coin;
+            pcursor->Next();
         }
-
-        pcursor->Next();
     }
 
     afile.fclose();
@@ -2809,6 +2937,14 @@ const std::vector<RPCResult> RPCHelpForChainstate{
     {RPCResult::Type::NUM, "coins_db_cache_bytes", "size of the coinsdb cache"},
     {RPCResult::Type::NUM, "coins_tip_cache_bytes", "size of the coinstip cache"},
     {RPCResult::Type::BOOL, "validated", "whether the chainstate is fully validated. True if all blocks in the chainstate were validated, false if the chain is based on a snapshot and the snapshot has not yet been validated."},
+    {RPCResult::Type::OBJ, "background_validation", /*optional=*/true, "progress of the validation of the chain up to the snapshot, for the chainstate validating it in the background",
+    {
+        {RPCResult::Type::NUM, "blocks_per_second", "blocks connected per second since background validation started"},
+        {RPCResult::Type::NUM, "inputs_per_second", "transaction inputs connected per second since background validation started"},
+        {RPCResult::Type::NUM, "cache_hit_rate", "share of the coins looked up that were found in the coins cache"},
+        {RPCResult::Type::NUM, "duty_cycle", "share of the time background validation is allowed to run, see -backgroundvalidationlatency"},
+        {RPCResult::Type::NUM, "tip_latency", "time in milliseconds the last new block took to connect to the active chainstate"},
+    }},
 };
 
 static RPCHelpMan getchainstates()
@@ -2834,7 +2970,7 @@ return RPCHelpMan{
 
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
 
-    auto make_chain_data = [&](const Chainstate& cs, bool validated) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    auto make_chain_data = [&](Chainstate& cs, bool validated) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
         UniValue data(UniValue::VOBJ);
         if (!cs.m_chain.Tip()) {
@@ -2853,6 +2989,19 @@ return RPCHelpMan{
             data.pushKV("snapshot_blockhash", cs.m_from_snapshot_blockhash->ToString());
         }
         data.pushKV("validated", validated);
+        if (chainman.BackgroundSyncInProgress() && &cs != &chainman.ActiveChainstate()) {
+            const BackgroundValidationStats& stats{chainman.GetBackgroundValidationStats()};
+            const BackgroundValidationScheduler& scheduler{chainman.GetBackgroundValidationScheduler()};
+            const double seconds{stats.start ? Ticks<SecondsDouble>(SteadyClock::now() - *stats.start) : 0.0};
+            const uint64_t lookups{cs.CoinsTip().GetCacheHits() + cs.CoinsTip().GetCacheMisses()};
+            UniValue background(UniValue::VOBJ);
+            background.pushKV("blocks_per_second", seconds > 0 ? stats.blocks / seconds : 0.0);
+            background.pushKV("inputs_per_second", seconds > 0 ? stats.inputs / seconds : 0.0);
+            background.pushKV("cache_hit_rate", lookups > 0 ? double(cs.CoinsTip().GetCacheHits()) / lookups : 0.0);
+            background.pushKV("duty_cycle", scheduler.GetDutyCycle());
+            background.pushKV("tip_latency", count_milliseconds(scheduler.GetTipLatency()));
+            data.pushKV("background_validation", std::move(background));
+        }
         return data;
     };
 
@@ -2893,6 +3042,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &scantxoutset},
         {"blockchain", &scanblocks},
         {"blockchain", &getblockfilter},
+        {"blockchain", &getscripthistory},
         {"blockchain", &dumptxoutset},
         {"blockchain", &loadtxoutset},
         {"blockchain", &getchainstates},
@@ -13,13 +13,18 @@
 #include <validation.h>
 
 #include <any>
+#include <optional>
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 class CBlock;
 class CBlockIndex;
 class Chainstate;
+class CScript;
 class UniValue;
+struct ScriptOutput;
+struct ScriptOutputPos;
 namespace node {
 struct NodeContext;
 } // namespace node
@@ -46,8 +51,16 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
 /** Used by getblockstats to get feerates at different percentiles by weight  */
 void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight);
 
+/** Parse a position in the script history, as returned in the "next_cursor" field of a page of outputs */
+std::optional<ScriptOutputPos> ParseScriptHistoryCursor(const std::string& cursor);
+
+/** Page of the outputs of a script history to JSON */
+UniValue ScriptHistoryToJSON(const CScript& script, const std::vector<ScriptOutput>& outputs, const std::optional<ScriptOutputPos>& next);
+
 /**
  * Helper to create UTXO snapshots given a chainstate and a file handle.
+ * @param partitioned whether to write the coins in partitions that can be
+ *                    loaded in parallel, or in the legacy format.
  * @return a UniValue map containing metadata about the snapshot.
  */
 UniValue CreateUTXOSnapshot(
@@ -55,6 +68,7 @@ UniValue CreateUTXOSnapshot(
     Chainstate& chainstate,
     AutoFile& afile,
     const fs::path& path,
-    const fs::path& tmppath);
+    const fs::path& tmppath,
+    bool partitioned = true);
 
 #endif // BITCOIN_RPC_BLOCKCHAIN_H
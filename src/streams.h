@@ -15,6 +15,7 @@
 #include <assert.h>
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <ios>
 #include <limits>
 #include <optional>
@@ -32,7 +33,27 @@ inline void Xor(Span<std::byte> write, Span<const std::byte> key, size_t key_off
     }
     key_offset %= key.size();
 
-    for (size_t i = 0, j = key_offset; i != write.size(); i++) {
+    size_t i{0};
+    if (sizeof(uint64_t) % key.size() == 0) {
+        // The database and block file keys are 8 bytes long, XOR 8 bytes at a
+        // time with the key repeated into a word starting at key_offset. The
+        // compiler vectorizes this loop, which matters for every value and
+        // block read or written.
+        std::byte key_bytes[sizeof(uint64_t)];
+        for (size_t k = 0; k < sizeof(key_bytes); ++k) {
+            key_bytes[k] = key[(key_offset + k) % key.size()];
+        }
+        uint64_t key_word;
+        std::memcpy(&key_word, key_bytes, sizeof(key_word));
+        for (; i + sizeof(uint64_t) <= write.size(); i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, write.data() + i, sizeof(word));
+            word ^= key_word;
+            std::memcpy(write.data() + i, &word, sizeof(word));
+        }
+    }
+
+    for (size_t j = (key_offset + i) % key.size(); i != write.size(); i++) {
         write[i] ^= key[j++];
 
         // This potentially acts on very many bytes of data, so it's
@@ -182,6 +203,14 @@ public:
         memcpy(dst.data(), m_data.data(), dst.size());
         m_data = m_data.subspan(dst.size());
     }
+
+    void ignore(size_t num_ignore)
+    {
+        if (num_ignore > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(num_ignore);
+    }
 };
 
 /** Double ended buffer combining vector and stream-like interfaces.
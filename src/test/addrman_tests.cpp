@@ -1117,4 +1117,96 @@ BOOST_AUTO_TEST_CASE(addrman_size)
     BOOST_CHECK_EQUAL(addrman->Size(/*net=*/std::nullopt, /*in_new=*/false), 1U);
 }
 
+/** All entries of both tables, in a form that doesn't depend on internal ids. */
+static auto AddrmanContents(const AddrMan& addrman)
+{
+    std::vector<std::tuple<bool, int, int, int, std::string, uint64_t, int64_t, int64_t, int>> contents;
+    for (const bool tried : {false, true}) {
+        for (const auto& [info, pos] : addrman.GetEntries(tried)) {
+            contents.emplace_back(pos.tried, pos.bucket, pos.position, pos.multiplicity, info.ToStringAddrPort(),
+                                  uint64_t{info.nServices}, TicksSinceEpoch<std::chrono::seconds>(info.nTime),
+                                  TicksSinceEpoch<std::chrono::seconds>(info.m_last_success), info.nAttempts);
+        }
+    }
+    std::sort(contents.begin(), contents.end());
+    return contents;
+}
+
+BOOST_AUTO_TEST_CASE(addrman_journal)
+{
+    const auto ratio{GetCheckRatio(m_node)};
+    AddrMan addrman{EMPTY_NETGROUPMAN, DETERMINISTIC, ratio};
+    auto time{Now<NodeSeconds>()};
+
+    // Fill a few buckets, from sources in different groups so that addresses
+    // get added to more than one new bucket.
+    std::vector<CAddress> addrs;
+    for (int i = 0; i < 200; ++i) {
+        addrs.emplace_back(ResolveService(strprintf("250.%i.%i.1", i % 4, i), 8333), NODE_NONE);
+        addrs.back().nTime = time;
+    }
+    for (int source = 0; source < 8; ++source) {
+        addrman.Add(addrs, ResolveIP(strprintf("252.%i.1.1", source)));
+    }
+    for (int i = 0; i < 20; ++i) {
+        addrman.Good(addrs[i], time);
+    }
+
+    // The replica starts out from the full serialization.
+    DataStream base{};
+    base << addrman;
+    AddrMan replica{EMPTY_NETGROUPMAN, DETERMINISTIC, ratio};
+    base >> replica;
+    BOOST_CHECK(AddrmanContents(replica) == AddrmanContents(addrman));
+
+    // Nothing changed yet.
+    DataStream record{};
+    BOOST_CHECK_EQUAL(addrman.SerializeJournal(record), 0U);
+    replica.UnserializeJournal(record);
+    BOOST_CHECK(AddrmanContents(replica) == AddrmanContents(addrman));
+
+    // Change entries in every way: new addresses, moves to tried (with
+    // collisions and evictions), failed attempts, updated services and times.
+    time += 1h;
+    std::vector<CAddress> more_addrs;
+    for (int i = 0; i < 200; ++i) {
+        more_addrs.emplace_back(ResolveService(strprintf("250.%i.%i.2", i % 4, i), 8333), NODE_NONE);
+        more_addrs.back().nTime = time;
+    }
+    addrman.Add(more_addrs, ResolveIP("252.9.1.1"));
+    for (int i = 20; i < 120; ++i) {
+        addrman.Good(addrs[i], time);
+        addrman.Good(more_addrs[i], time);
+    }
+    addrman.ResolveCollisions();
+    for (int i = 120; i < 140; ++i) {
+        addrman.Attempt(addrs[i], /*fCountFailure=*/true, time);
+    }
+    addrman.SetServices(addrs[150], NODE_NETWORK);
+    addrman.Connected(addrs[160], time);
+    BOOST_CHECK(addrman.SerializeJournal(record) > 0);
+    replica.UnserializeJournal(record);
+    BOOST_CHECK(AddrmanContents(replica) == AddrmanContents(addrman));
+
+    // Records written after a full serialization only contain later changes.
+    base << addrman;
+    AddrMan replica2{EMPTY_NETGROUPMAN, DETERMINISTIC, ratio};
+    base >> replica2;
+    const auto existing{addrman.GetAddr(/*max_addresses=*/1, /*max_pct=*/0, /*network=*/std::nullopt)};
+    BOOST_REQUIRE_EQUAL(existing.size(), 1U);
+    addrman.SetServices(existing[0], NODE_NETWORK_LIMITED);
+    BOOST_CHECK_EQUAL(addrman.SerializeJournal(record), 1U);
+    DataStream record_copy{record};
+    replica.UnserializeJournal(record);
+    replica2.UnserializeJournal(record_copy);
+    BOOST_CHECK(AddrmanContents(replica) == AddrmanContents(addrman));
+    BOOST_CHECK(AddrmanContents(replica2) == AddrmanContents(addrman));
+
+    // A truncated record is rejected.
+    addrman.Attempt(addrs[170], /*fCountFailure=*/true, time);
+    BOOST_CHECK(addrman.SerializeJournal(record) > 0);
+    record.resize(record.size() - 1);
+    BOOST_CHECK_THROW(replica.UnserializeJournal(record), std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
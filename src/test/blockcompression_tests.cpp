@@ -0,0 +1,231 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <node/blockcompression.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/solver.h>
+#include <streams.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/fs_helpers.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using node::CompressBlockFile;
+using node::CompressedBlockFile;
+using node::CompressFrame;
+using node::DecompressBlockFile;
+using node::DecompressFrame;
+using node::MAX_BLOCKFILE_SIZE;
+
+namespace {
+/** Data that compresses somewhat, like block data: random bytes with repeated runs. */
+std::vector<std::byte> CompressibleData(size_t size)
+{
+    std::vector<std::byte> data;
+    data.reserve(size);
+    while (data.size() < size) {
+        if (!data.empty() && g_insecure_rand_ctx.randbool()) {
+            const size_t start{g_insecure_rand_ctx.randrange(data.size())};
+            const size_t length{std::min<size_t>(4 + g_insecure_rand_ctx.randrange(300), data.size() - start)};
+            for (size_t i = 0; i < length; ++i) data.push_back(data[start + i]);
+        } else {
+            const auto bytes{g_insecure_rand_ctx.randbytes<std::byte>(1 + g_insecure_rand_ctx.randrange(64))};
+            data.insert(data.end(), bytes.begin(), bytes.end());
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+void WriteFile(const fs::path& path, Span<const std::byte> data)
+{
+    AutoFile file{fsbridge::fopen(path, "wb")};
+    file << data;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(blockcompression_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(frame_roundtrip)
+{
+    for (const size_t size : {0, 1, 4, 17, 1000, 65536, 300000}) {
+        const auto data{CompressibleData(size)};
+        const auto compressed{CompressFrame(data)};
+        if (size >= 1000) BOOST_REQUIRE(compressed);
+        if (!compressed) continue;
+        BOOST_CHECK_LT(compressed->size(), data.size());
+        std::vector<std::byte> out(size);
+        BOOST_CHECK(DecompressFrame(*compressed, out));
+        BOOST_CHECK(out == data);
+
+        // The decompressed size must match exactly
+        std::vector<std::byte> longer(size + 1);
+        BOOST_CHECK(!DecompressFrame(*compressed, longer));
+        if (size > 0) {
+            std::vector<std::byte> shorter(size - 1);
+            BOOST_CHECK(!DecompressFrame(*compressed, shorter));
+        }
+    }
+
+    // Random data doesn't compress
+    BOOST_CHECK(!CompressFrame(g_insecure_rand_ctx.randbytes<std::byte>(10000)));
+
+    // Runs of a single byte compress well
+    const std::vector<std::byte> zeros(100000);
+    const auto compressed{CompressFrame(zeros)};
+    BOOST_REQUIRE(compressed);
+    BOOST_CHECK_LT(compressed->size(), 1000U);
+    std::vector<std::byte> out(zeros.size(), std::byte{1});
+    BOOST_CHECK(DecompressFrame(*compressed, out));
+    BOOST_CHECK(out == zeros);
+}
+
+BOOST_AUTO_TEST_CASE(frame_corrupted)
+{
+    const auto data{CompressibleData(20000)};
+    const auto compressed{CompressFrame(data)};
+    BOOST_REQUIRE(compressed);
+    std::vector<std::byte> out(data.size());
+
+    // Truncated frames are rejected
+    for (size_t size = 0; size < compressed->size(); size += 1 + compressed->size() / 100) {
+        BOOST_CHECK(!DecompressFrame(Span{*compressed}.first(size), out));
+    }
+
+    // Corrupted frames never read or write out of bounds, and are rejected
+    // unless the corruption happens to keep the frame well-formed
+    for (int i = 0; i < 1000; ++i) {
+        auto corrupted{*compressed};
+        corrupted[g_insecure_rand_ctx.randrange(corrupted.size())] ^= std::byte(1 + g_insecure_rand_ctx.randrange(255));
+        if (DecompressFrame(corrupted, out)) BOOST_CHECK_EQUAL(out.size(), data.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(file_random_access)
+{
+    const fs::path dir{m_args.GetDataDirBase()};
+    const fs::path block_path{dir / "blk00000.dat"};
+    const fs::path compressed_path{dir / "blz00000.dat"};
+    const fs::path restored_path{dir / "restored.dat"};
+
+    // Compressible data followed by incompressible data, so that there are
+    // frames of both kinds
+    auto data{CompressibleData(100000)};
+    const auto random{g_insecure_rand_ctx.randbytes<std::byte>(30000)};
+    data.insert(data.end(), random.begin(), random.end());
+    WriteFile(block_path, data);
+
+    BOOST_REQUIRE(CompressBlockFile(block_path, compressed_path, /*frame_size=*/4096));
+    BOOST_CHECK(!fs::exists(compressed_path + ".tmp"));
+    BOOST_CHECK_LT(fs::file_size(compressed_path), data.size());
+
+    auto file{CompressedBlockFile::Open(compressed_path)};
+    BOOST_REQUIRE(file);
+    BOOST_CHECK_EQUAL(file->Size(), data.size());
+    for (int i = 0; i < 200; ++i) {
+        const uint64_t pos{g_insecure_rand_ctx.randrange(data.size())};
+        std::vector<std::byte> out(g_insecure_rand_ctx.randrange(std::min<uint64_t>(20000, data.size() - pos) + 1));
+        BOOST_REQUIRE(file->Read(pos, out));
+        BOOST_CHECK(std::equal(out.begin(), out.end(), data.begin() + pos));
+    }
+    // Reads past the end fail
+    std::vector<std::byte> out(2);
+    BOOST_CHECK(!file->Read(data.size() - 1, out));
+    BOOST_CHECK(!file->Read(data.size() + 1, Span{out}.first(0)));
+
+    BOOST_REQUIRE(DecompressBlockFile(compressed_path, restored_path));
+    std::vector<std::byte> restored(data.size());
+    AutoFile{fsbridge::fopen(restored_path, "rb")} >> Span{restored};
+    BOOST_CHECK(restored == data);
+
+    // Truncated or corrupted files are rejected
+    file.reset();
+    std::vector<std::byte> compressed(fs::file_size(compressed_path));
+    AutoFile{fsbridge::fopen(compressed_path, "rb")} >> Span{compressed};
+    WriteFile(compressed_path, Span{compressed}.first(compressed.size() - 1));
+    BOOST_CHECK(!CompressedBlockFile::Open(compressed_path));
+    compressed[0] ^= std::byte{1};
+    WriteFile(compressed_path, compressed);
+    BOOST_CHECK(!CompressedBlockFile::Open(compressed_path));
+    BOOST_CHECK(!DecompressBlockFile(compressed_path, restored_path));
+}
+
+BOOST_AUTO_TEST_CASE(empty_file)
+{
+    const fs::path dir{m_args.GetDataDirBase()};
+    WriteFile(dir / "empty.dat", {});
+    BOOST_REQUIRE(CompressBlockFile(dir / "empty.dat", dir / "empty.blz"));
+    const auto file{CompressedBlockFile::Open(dir / "empty.blz")};
+    BOOST_REQUIRE(file);
+    BOOST_CHECK_EQUAL(file->Size(), 0U);
+    BOOST_CHECK(file->Read(0, {}));
+}
+
+struct BlockCompressionSetup : public TestChain100Setup {
+    BlockCompressionSetup() : TestChain100Setup{ChainType::REGTEST, {"-blockcompression"}} {}
+};
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_compress_block_file, BlockCompressionSetup)
+{
+    auto& chainman{*Assert(m_node.chainman)};
+    auto& blockman{chainman.m_blockman};
+
+    // Cap the last block file size, and mine a new block in a new block file.
+    const CBlockIndex* old_tip{WITH_LOCK(::cs_main, return chainman.ActiveChain().Tip())};
+    const int file_number{WITH_LOCK(::cs_main, return old_tip->GetBlockPos().nFile)};
+    WITH_LOCK(::cs_main, blockman.GetBlockFileInfo(file_number)->nSize = MAX_BLOCKFILE_SIZE);
+    CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    const CBlockIndex* new_tip{WITH_LOCK(::cs_main, return chainman.ActiveChain().Tip())};
+    BOOST_CHECK_NE(WITH_LOCK(::cs_main, return new_tip->GetBlockPos().nFile), file_number);
+
+    CBlock expected_block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(expected_block, *old_tip));
+    std::vector<uint8_t> expected_raw;
+    BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(expected_raw, WITH_LOCK(::cs_main, return old_tip->GetBlockPos())));
+
+    blockman.StartBlockFileCompression();
+    for (int i = 0; i < 1000 && !blockman.IsBlockFileCompressed(file_number); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    blockman.StopBlockFileCompression();
+    BOOST_REQUIRE(blockman.IsBlockFileCompressed(file_number));
+    const FlatFilePos pos(file_number, 0);
+    BOOST_CHECK(!fs::exists(blockman.GetBlockPosFilename(pos)));
+    // The file being written to is not compressed
+    BOOST_CHECK(!blockman.IsBlockFileCompressed(WITH_LOCK(::cs_main, return new_tip->GetBlockPos().nFile)));
+
+    // Blocks are read from the compressed file
+    CBlock block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, *old_tip));
+    BOOST_CHECK_EQUAL(block.GetHash(), expected_block.GetHash());
+    const CBlockIndex* genesis{WITH_LOCK(::cs_main, return chainman.ActiveChain().Genesis())};
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, *genesis));
+    BOOST_CHECK_EQUAL(block.GetHash(), genesis->GetBlockHash());
+    std::vector<uint8_t> raw;
+    BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw, WITH_LOCK(::cs_main, return old_tip->GetBlockPos())));
+    BOOST_CHECK(raw == expected_raw);
+
+    // The compressed file is found again on startup, and a leftover block
+    // file is removed
+    WriteFile(blockman.GetBlockPosFilename(pos), {});
+    blockman.ScanCompressedBlockFiles();
+    BOOST_CHECK(blockman.IsBlockFileCompressed(file_number));
+    BOOST_CHECK(!fs::exists(blockman.GetBlockPosFilename(pos)));
+
+    // Restoring the block file, e.g. for reindexing
+    BOOST_REQUIRE(blockman.RestoreBlockFile(file_number));
+    BOOST_CHECK(!blockman.IsBlockFileCompressed(file_number));
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, *old_tip));
+    BOOST_CHECK_EQUAL(block.GetHash(), expected_block.GetHash());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -270,6 +270,53 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_served_ranges, BuildChainTestingSetup)
+{
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    std::vector<BlockFilter> expected_filters;
+    std::vector<uint256> expected_headers;
+    uint256 last_header;
+    for (int height = 0; height <= tip->nHeight; ++height) {
+        BlockFilter filter;
+        BOOST_REQUIRE(ComputeFilter(BlockFilterType::BASIC, *tip->GetAncestor(height), filter, m_node.chainman->m_blockman));
+        last_header = filter.ComputeHeader(last_header);
+        expected_filters.push_back(std::move(filter));
+        expected_headers.push_back(last_header);
+    }
+
+    const auto check_lookups{[&](BlockFilterIndex& filter_index) {
+        // Ranges are read from the filter files first, then from the cache of served filters.
+        for (int i = 0; i < 2; ++i) {
+            std::vector<BlockFilter> filters;
+            BOOST_CHECK(filter_index.LookupFilterRange(0, tip, filters));
+            BOOST_REQUIRE_EQUAL(filters.size(), expected_filters.size());
+            for (size_t height = 0; height < filters.size(); ++height) {
+                BOOST_CHECK(filters[height].GetEncodedFilter() == expected_filters[height].GetEncodedFilter());
+            }
+        }
+        for (int height = 0; height <= tip->nHeight; ++height) {
+            uint256 header;
+            BOOST_CHECK(filter_index.LookupFilterHeader(tip->GetAncestor(height), header));
+            BOOST_CHECK_EQUAL(header, expected_headers[height]);
+        }
+    }};
+
+    {
+        BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, false, true);
+        BOOST_REQUIRE(filter_index.Init());
+        BOOST_REQUIRE(filter_index.StartBackgroundSync());
+        IndexWaitSynced(filter_index);
+        check_lookups(filter_index);
+        filter_index.Stop();
+    }
+
+    // The filter headers are loaded again when the index is restarted.
+    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, false, false);
+    BOOST_REQUIRE(filter_index.Init());
+    check_lookups(filter_index);
+    filter_index.Stop();
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
@@ -9,6 +9,7 @@
 #include <node/kernel_notifications.h>
 #include <script/solver.h>
 #include <primitives/block.h>
+#include <undo.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
@@ -201,4 +202,94 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_undo_write_read, TestChain100Setup)
+{
+    BlockManager& blockman{m_node.chainman->m_blockman};
+    LOCK(::cs_main);
+    CBlockIndex& index{*m_node.chainman->ActiveTip()};
+
+    // Undo data written after larger undo data isn't mixed up with it, as
+    // the write buffer is reused
+    for (const int coins : {100, 3}) {
+        CBlockUndo blockundo;
+        for (int i = 0; i < coins; ++i) {
+            blockundo.vtxundo.emplace_back().vprevout.emplace_back(CTxOut{i, CScript() << i}, /*nHeightIn=*/i, /*fCoinBaseIn=*/false);
+        }
+        index.nUndoPos = 0;
+        index.nStatus &= ~BLOCK_HAVE_UNDO;
+        BlockValidationState state;
+        BOOST_REQUIRE(blockman.WriteUndoDataForBlock(blockundo, state, index));
+
+        CBlockUndo read_undo;
+        BOOST_REQUIRE(blockman.UndoReadFromDisk(read_undo, index));
+        BOOST_REQUIRE_EQUAL(read_undo.vtxundo.size(), coins);
+        for (int i = 0; i < coins; ++i) {
+            BOOST_CHECK(read_undo.vtxundo[i].vprevout.at(0).out == blockundo.vtxundo[i].vprevout[0].out);
+            BOOST_CHECK_EQUAL(read_undo.vtxundo[i].vprevout[0].nHeight, i);
+        }
+
+        // The checksum covers the hash of the previous block
+        ASSERT_DEBUG_LOG("Checksum mismatch");
+        BOOST_CHECK(!blockman.UndoReadFromDisk(read_undo, index.GetUndoPos(), index.GetBlockHash()));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_block_index_snapshot, TestChain100Setup)
+{
+    auto& chainman{*Assert(m_node.chainman)};
+    LOCK(::cs_main);
+    chainman.ActiveChainstate().ForceFlushStateToDisk();
+    BOOST_REQUIRE(chainman.m_blockman.WriteBlockIndexSnapshot());
+    const fs::path snapshot_path{m_args.GetBlocksDirPath() / "blockindex.dat"};
+    BOOST_CHECK(fs::exists(snapshot_path));
+
+    KernelNotifications notifications{m_node.exit_status};
+    const BlockManager::Options blockman_opts{
+        .chainparams = chainman.GetParams(),
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+    };
+
+    const auto check_block_index{[&](const BlockManager& blockman) {
+        BOOST_CHECK_EQUAL(blockman.m_block_index.size(), chainman.m_blockman.m_block_index.size());
+        for (const auto& [hash, expected] : chainman.m_blockman.m_block_index) {
+            const CBlockIndex* pindex{blockman.LookupBlockIndex(hash)};
+            BOOST_REQUIRE(pindex);
+            BOOST_CHECK_EQUAL(pindex->nHeight, expected.nHeight);
+            BOOST_CHECK_EQUAL(pindex->nStatus, expected.nStatus);
+            BOOST_CHECK_EQUAL(pindex->nDataPos, expected.nDataPos);
+            BOOST_CHECK(pindex->nChainWork == expected.nChainWork);
+            BOOST_CHECK_EQUAL(pindex->nChainTx, expected.nChainTx);
+            BOOST_CHECK_EQUAL(pindex->pprev ? pindex->pprev->GetBlockHash() : uint256{}, expected.pprev ? expected.pprev->GetBlockHash() : uint256{});
+        }
+    }};
+
+    // Load the block index from the snapshot, and then from the database
+    // once the snapshot has been used.
+    for (const bool from_snapshot : {true, false}) {
+        BlockManager blockman{m_node.kernel->interrupt, blockman_opts};
+        blockman.m_block_tree_db = std::move(chainman.m_blockman.m_block_tree_db);
+        {
+            ASSERT_DEBUG_LOG(from_snapshot ? "block index entries from snapshot" : "LoadBlockIndexDB");
+            BOOST_CHECK(blockman.LoadBlockIndexDB(/*snapshot_blockhash=*/std::nullopt));
+        }
+        chainman.m_blockman.m_block_tree_db = std::move(blockman.m_block_tree_db);
+        BOOST_CHECK(!fs::exists(snapshot_path));
+        check_block_index(blockman);
+    }
+
+    // A snapshot that doesn't match the database is ignored
+    BOOST_REQUIRE(chainman.m_blockman.WriteBlockIndexSnapshot());
+    CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    chainman.ActiveChainstate().ForceFlushStateToDisk();
+    BlockManager blockman{m_node.kernel->interrupt, blockman_opts};
+    blockman.m_block_tree_db = std::move(chainman.m_blockman.m_block_tree_db);
+    {
+        ASSERT_DEBUG_LOG("Ignoring block index snapshot");
+        BOOST_CHECK(blockman.LoadBlockIndexDB(/*snapshot_blockhash=*/std::nullopt));
+    }
+    chainman.m_blockman.m_block_tree_db = std::move(blockman.m_block_tree_db);
+    check_block_index(blockman);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <memusage.h>
+#include <node/blockmap.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using node::BlockMap;
+
+BOOST_FIXTURE_TEST_SUITE(blockmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(insert_find)
+{
+    BlockMap map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(uint256::ONE) == map.end());
+    BOOST_CHECK_EQUAL(map.count(uint256::ONE), 0U);
+    BOOST_CHECK(map.begin() == map.end());
+
+    // Insert enough entries to span several chunks and rehashes, checking
+    // that entries don't move.
+    std::vector<uint256> hashes;
+    std::vector<const CBlockIndex*> entries;
+    for (int i = 0; i < 20000; ++i) {
+        CBlockHeader header;
+        header.nTime = i;
+        const auto [it, inserted]{map.try_emplace(g_insecure_rand_ctx.rand256(), header)};
+        BOOST_REQUIRE(inserted);
+        hashes.push_back(it->first);
+        entries.push_back(&it->second);
+    }
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+    BOOST_CHECK(!map.empty());
+
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        const auto it{map.find(hashes[i])};
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK(it->first == hashes[i]);
+        BOOST_CHECK_EQUAL(&it->second, entries[i]);
+        BOOST_CHECK_EQUAL(it->second.nTime, i);
+        BOOST_CHECK_EQUAL(map.count(hashes[i]), 1U);
+    }
+    BOOST_CHECK(map.find(g_insecure_rand_ctx.rand256()) == map.end());
+
+    // Inserting an existing hash returns the existing entry
+    const auto [it, inserted]{map.try_emplace(hashes[42])};
+    BOOST_CHECK(!inserted);
+    BOOST_CHECK_EQUAL(&it->second, entries[42]);
+    BOOST_CHECK_EQUAL(it->second.nTime, 42U);
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+
+    // Iteration is in insertion order
+    size_t i{0};
+    for (const auto& [hash, index] : map) {
+        BOOST_CHECK(hash == hashes[i]);
+        BOOST_CHECK_EQUAL(&index, entries[i]);
+        ++i;
+    }
+    BOOST_CHECK_EQUAL(i, hashes.size());
+    BOOST_CHECK_GT(map.DynamicMemoryUsage(), hashes.size() * sizeof(BlockMap::value_type));
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(hashes[0]) == map.end());
+    BOOST_CHECK(map.try_emplace(hashes[0]).second);
+    BOOST_CHECK_EQUAL(map.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(reserve)
+{
+    BlockMap map;
+    map.reserve(10000);
+    const size_t usage{map.DynamicMemoryUsage()};
+    for (int i = 0; i < 10000; ++i) {
+        BOOST_CHECK(map.try_emplace(g_insecure_rand_ctx.rand256()).second);
+    }
+    // The hash table wasn't resized
+    BOOST_CHECK_EQUAL(map.DynamicMemoryUsage() - usage, (10000 + 4095) / 4096 * memusage::MallocUsage(4096 * sizeof(BlockMap::value_type)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <node/blockprefetch.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using node::BlockPrefetcher;
+
+BOOST_FIXTURE_TEST_SUITE(blockprefetch_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(prefetch_take)
+{
+    const node::BlockManager& blockman{m_node.chainman->m_blockman};
+    BlockPrefetcher prefetcher{blockman, /*depth=*/4};
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(::cs_main);
+        for (int height = 10; height < 20; ++height) {
+            blocks.push_back(m_node.chainman->ActiveChain()[height]);
+        }
+        prefetcher.Prefetch(blocks);
+    }
+
+    // Blocks are returned in order, up to the prefetch depth
+    for (int i = 0; i < 4; ++i) {
+        const auto block{prefetcher.Take(*blocks[i])};
+        BOOST_REQUIRE(block);
+        BOOST_CHECK(block->GetHash() == blocks[i]->GetBlockHash());
+    }
+    BOOST_CHECK(!prefetcher.Take(*blocks[4]));
+
+    // Prefetching again keeps wanted blocks, and taking a block skips the
+    // blocks before it
+    WITH_LOCK(::cs_main, prefetcher.Prefetch({blocks.begin() + 5, blocks.end()}));
+    const auto block{prefetcher.Take(*blocks[7])};
+    BOOST_REQUIRE(block);
+    BOOST_CHECK(block->GetHash() == blocks[7]->GetBlockHash());
+    BOOST_CHECK(!prefetcher.Take(*blocks[5]));
+    BOOST_CHECK(prefetcher.Take(*blocks[8]));
+
+    // Nothing is read once stopped, or when the depth is zero
+    prefetcher.Stop();
+    WITH_LOCK(::cs_main, prefetcher.Prefetch(blocks));
+    BOOST_CHECK(!prefetcher.Take(*blocks[0]));
+
+    BlockPrefetcher disabled{blockman, /*depth=*/0};
+    WITH_LOCK(::cs_main, disabled.Prefetch(blocks));
+    BOOST_CHECK(!disabled.Take(*blocks[0]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
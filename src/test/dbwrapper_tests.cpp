@@ -160,6 +160,49 @@ BOOST_AUTO_TEST_CASE(dbwrapper_batch)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_batch_async)
+{
+    for (const bool async_write : {false, true}) {
+        fs::path ph = m_args.GetDataDirBase() / (async_write ? "dbwrapper_batch_async_true" : "dbwrapper_batch_async_false");
+        DBOptions options{.async_write = async_write};
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = true, .options = options});
+
+        // Queue more batches than fit in the queue, each overwriting some of
+        // the keys of the previous one.
+        std::vector<uint256> values(100);
+        CDBBatch batch(dbw);
+        for (uint32_t n = 0; n < 10; ++n) {
+            for (uint32_t key = n * 5; key < values.size(); ++key) {
+                values[key] = InsecureRand256();
+                batch.Write(key, values[key]);
+            }
+            batch.Erase(uint32_t{1000});
+            if (n % 3 == 0) batch.Write(uint32_t{1000}, n);
+            dbw.WriteBatchAsync(batch);
+            BOOST_CHECK_EQUAL(batch.SizeEstimate(), 0U);
+        }
+
+        // Reads observe all the queued batches.
+        uint256 res;
+        for (uint32_t key = 0; key < values.size(); ++key) {
+            BOOST_CHECK(dbw.Read(key, res));
+            BOOST_CHECK_EQUAL(res, values[key]);
+        }
+        uint32_t res_uint_32;
+        BOOST_CHECK(dbw.Read(uint32_t{1000}, res_uint_32));
+        BOOST_CHECK_EQUAL(res_uint_32, 9U);
+
+        // A synchronous write is ordered after the queued batches.
+        batch.Write(uint32_t{0}, uint256::ONE);
+        dbw.WriteBatchAsync(batch);
+        batch.Write(uint32_t{0}, uint256::ZERO);
+        BOOST_CHECK(dbw.WriteBatch(batch));
+        dbw.SyncPendingWrites();
+        BOOST_CHECK(dbw.Read(uint32_t{0}, res));
+        BOOST_CHECK_EQUAL(res, uint256::ZERO);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
     // Perform tests both obfuscated and non-obfuscated.
@@ -143,4 +143,66 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(result.success);
 }
 
+// In this test, we check that segments of the chain fetched from other peers
+// during REDOWNLOAD are validated in order with the headers from our peer.
+BOOST_AUTO_TEST_CASE(headers_sync_state_fetched_segments)
+{
+    std::vector<CBlockHeader> chain;
+
+    const int target_blocks = 15000;
+    arith_uint256 chain_work = target_blocks*2;
+
+    GenerateHeaders(chain, target_blocks-1, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nVersion, Params().GenesisBlock().nTime,
+            ArithToUint256(0), Params().GenesisBlock().nBits);
+
+    const CBlockIndex* chain_start = WITH_LOCK(::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(Params().GenesisBlock().GetHash()));
+    HeadersSyncState hss(0, Params().GetConsensus(), chain_start, chain_work);
+    BOOST_CHECK(hss.GetSegmentsToFetch().empty());
+    (void)hss.ProcessNextHeaders(chain, true);
+    BOOST_CHECK(hss.GetState() == HeadersSyncState::State::REDOWNLOAD);
+
+    // Segment 0 is redownloaded from our peer, and the last segment isn't
+    // full, leaving segments 1 to 6 to be fetched from other peers.
+    const auto segments{hss.GetSegmentsToFetch()};
+    BOOST_REQUIRE_EQUAL(segments.size(), 6U);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        BOOST_CHECK_EQUAL(segments[i].first, i + 1);
+        BOOST_CHECK(segments[i].second == chain[(i + 1) * HEADERS_SYNC_SEGMENT_SIZE - 1].GetHash());
+    }
+
+    auto segment = [&](size_t index) {
+        return std::vector<CBlockHeader>(chain.begin() + index * HEADERS_SYNC_SEGMENT_SIZE,
+                                         chain.begin() + (index + 1) * HEADERS_SYNC_SEGMENT_SIZE);
+    };
+    // Segments that aren't the requested one are rejected.
+    BOOST_CHECK(!hss.AddFetchedSegment(0, segment(0)));
+    BOOST_CHECK(!hss.AddFetchedSegment(1, segment(2)));
+    BOOST_CHECK(!hss.AddFetchedSegment(7, std::vector<CBlockHeader>(chain.begin() + 14000, chain.end())));
+    BOOST_CHECK(hss.AddFetchedSegment(1, segment(1)));
+    BOOST_CHECK(hss.AddFetchedSegment(2, segment(2)));
+    BOOST_CHECK(hss.AddFetchedSegment(4, segment(4)));
+    BOOST_CHECK_EQUAL(hss.GetSegmentsToFetch().size(), 3U);
+
+    // Redownloading segment 0 from our peer continues with the fetched
+    // segments 1 and 2, up to the missing segment 3.
+    auto result = hss.ProcessNextHeaders(segment(0), true);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(result.request_more);
+    BOOST_CHECK(result.pow_validated_headers.empty());
+    BOOST_CHECK(hss.NextHeadersRequestLocator().vHave.front() == chain[3 * HEADERS_SYNC_SEGMENT_SIZE - 1].GetHash());
+    BOOST_CHECK(!hss.AddFetchedSegment(2, segment(2)));
+
+    // The rest of the chain (including segment 4 again) is returned in full
+    // and in order.
+    result = hss.ProcessNextHeaders(std::vector<CBlockHeader>(chain.begin() + 3 * HEADERS_SYNC_SEGMENT_SIZE, chain.end()), true);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(!result.request_more);
+    BOOST_REQUIRE_EQUAL(result.pow_validated_headers.size(), chain.size());
+    for (size_t i = 0; i < chain.size(); ++i) {
+        BOOST_CHECK(result.pow_validated_headers[i].GetHash() == chain[i].GetHash());
+    }
+    BOOST_CHECK(hss.GetState() == HeadersSyncState::State::FINAL);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <chain.h>
+#include <consensus/validation.h>
+#include <index/scriptindex.h>
+#include <interfaces/chain.h>
+#include <script/script.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(scriptindex_tests)
+
+static std::vector<ScriptOutput> FindAllOutputs(const ScriptIndex& index, const CScript& script, size_t page_size)
+{
+    std::vector<ScriptOutput> all_outputs;
+    std::optional<ScriptOutputPos> next{ScriptOutputPos{}};
+    while (next) {
+        std::vector<ScriptOutput> outputs;
+        const ScriptOutputPos start{*next};
+        BOOST_REQUIRE(index.FindScriptOutputs(script, start, page_size, outputs, next));
+        BOOST_CHECK(outputs.size() == page_size || !next);
+        all_outputs.insert(all_outputs.end(), outputs.begin(), outputs.end());
+    }
+    return all_outputs;
+}
+
+BOOST_FIXTURE_TEST_CASE(scriptindex_history, TestChain100Setup)
+{
+    ScriptIndex scriptindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(scriptindex.Init());
+    BOOST_REQUIRE(scriptindex.StartBackgroundSync());
+    IndexWaitSynced(scriptindex);
+
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+
+    // All the outputs built by the setup are found, in chain order, whatever the page size.
+    for (size_t page_size : {size_t{1}, size_t{30}, size_t{100}, MAX_SCRIPTINDEX_RESULTS}) {
+        const auto outputs{FindAllOutputs(scriptindex, coinbase_script, page_size)};
+        BOOST_REQUIRE_EQUAL(outputs.size(), m_coinbase_txns.size());
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            BOOST_CHECK_EQUAL(outputs[i].pos.height, static_cast<int>(i) + 1);
+            BOOST_CHECK_EQUAL(outputs[i].txid, m_coinbase_txns[i]->GetHash());
+            BOOST_CHECK_EQUAL(outputs[i].amount, m_coinbase_txns[i]->vout[0].nValue);
+            BOOST_CHECK(!outputs[i].spend);
+        }
+    }
+
+    // Spend the first coinbase output to a new script.
+    const CScript dest_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend_tx{CreateValidMempoolTransaction(m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/1,
+                                                                     coinbaseKey, dest_script, /*output_amount=*/1 * COIN, /*submit=*/false)};
+    const CBlock block{CreateAndProcessBlock({spend_tx}, coinbase_script)};
+    BOOST_REQUIRE(scriptindex.BlockUntilSyncedToCurrentChain());
+    const int spend_height{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Height())};
+
+    auto outputs{FindAllOutputs(scriptindex, coinbase_script, 30)};
+    BOOST_REQUIRE_EQUAL(outputs.size(), m_coinbase_txns.size() + 1);
+    BOOST_REQUIRE(outputs[0].spend);
+    BOOST_CHECK_EQUAL(outputs[0].spend->txid, spend_tx.GetHash());
+    BOOST_CHECK_EQUAL(outputs[0].spend->height, spend_height);
+    BOOST_CHECK_EQUAL(outputs[0].spend->vin, 0U);
+    BOOST_CHECK(!outputs[1].spend);
+    BOOST_CHECK_EQUAL(outputs.back().txid, block.vtx[0]->GetHash());
+
+    outputs = FindAllOutputs(scriptindex, dest_script, 10);
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK_EQUAL(outputs[0].txid, spend_tx.GetHash());
+    BOOST_CHECK_EQUAL(outputs[0].pos.height, spend_height);
+    BOOST_CHECK_EQUAL(outputs[0].pos.tx_index, 1U);
+    BOOST_CHECK_EQUAL(outputs[0].amount, 1 * COIN);
+
+    // A page starting after the last output is empty.
+    std::optional<ScriptOutputPos> next;
+    BOOST_REQUIRE(scriptindex.FindScriptOutputs(dest_script, ScriptOutputPos{spend_height + 1, 0, 0}, 10, outputs, next));
+    BOOST_CHECK(outputs.empty());
+    BOOST_CHECK(!next);
+
+    // Disconnecting the block removes its outputs and spends from the history.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    BOOST_REQUIRE(scriptindex.BlockUntilSyncedToCurrentChain());
+    outputs = FindAllOutputs(scriptindex, coinbase_script, 30);
+    BOOST_REQUIRE_EQUAL(outputs.size(), m_coinbase_txns.size());
+    BOOST_CHECK(!outputs[0].spend);
+    BOOST_CHECK(FindAllOutputs(scriptindex, dest_script, 10).empty());
+
+    // It is not safe to stop and destroy the index until it finishes handling
+    // the last BlockConnected notification.
+    SyncWithValidationInterfaceQueue();
+
+    scriptindex.Interrupt();
+    scriptindex.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
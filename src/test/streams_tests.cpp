@@ -14,6 +14,27 @@ using namespace std::string_literals;
 
 BOOST_FIXTURE_TEST_SUITE(streams_tests, BasicTestingSetup)
 
+BOOST_AUTO_TEST_CASE(xor_bytes)
+{
+    // Compare with XOR-ing one byte at a time, for keys that are XOR-ed a word
+    // at a time or not, at all the offsets and with partial words at the end.
+    for (size_t key_size : {1, 2, 3, 4, 7, 8, 9, 16}) {
+        const auto key{g_insecure_rand_ctx.randbytes(key_size)};
+        for (size_t size : {0, 1, 7, 8, 9, 63, 64, 100}) {
+            for (size_t offset = 0; offset < 2 * key_size; ++offset) {
+                const auto data{g_insecure_rand_ctx.randbytes(size)};
+                std::vector<unsigned char> expected{data};
+                for (size_t i = 0; i < size; ++i) {
+                    expected[i] ^= key[(offset + i) % key_size];
+                }
+                std::vector<unsigned char> result{data};
+                util::Xor(MakeWritableByteSpan(result), MakeByteSpan(key), offset);
+                BOOST_CHECK(result == expected);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(xor_file)
 {
     fs::path xor_path{m_args.GetDataDirBase() / "test_xor.bin"};
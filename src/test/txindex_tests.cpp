@@ -3,9 +3,13 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <addresstype.h>
+#include <blockfilter.h>
 #include <chainparams.h>
+#include <index/blockfilterindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
+#include <node/blockstorage.h>
+#include <undo.h>
 #include <test/util/index.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
@@ -77,4 +81,96 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_shared_sync, TestChain100Setup)
+{
+    // Sync a txindex along with a block filter index, reading each block once
+    // for both through a coordinator.
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true);
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_REQUIRE(filter_index.Init());
+
+    auto coordinator{std::make_shared<IndexSyncCoordinator>(m_node.chainman->m_blockman)};
+    BOOST_REQUIRE(txindex.StartBackgroundSync(coordinator));
+    BOOST_REQUIRE(filter_index.StartBackgroundSync(coordinator));
+    coordinator.reset();
+    IndexWaitSynced(txindex);
+    IndexWaitSynced(filter_index);
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    const CChain& chain{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain())};
+    for (const CBlockIndex* pindex{chain.Genesis()}; pindex; pindex = chain.Next(pindex)) {
+        CBlock block;
+        CBlockUndo block_undo;
+        BOOST_REQUIRE(m_node.chainman->m_blockman.ReadBlockFromDisk(block, *pindex));
+        if (pindex->nHeight > 0) BOOST_REQUIRE(m_node.chainman->m_blockman.UndoReadFromDisk(block_undo, *pindex));
+
+        BlockFilter filter;
+        BOOST_REQUIRE(filter_index.LookupFilter(pindex, filter));
+        BOOST_CHECK(filter.GetEncodedFilter() == BlockFilter(BlockFilterType::BASIC, block, block_undo).GetEncodedFilter());
+    }
+
+    SyncWithValidationInterfaceQueue();
+    txindex.Stop();
+    filter_index.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_compact_format, TestChain100Setup)
+{
+    const fs::path compact_dir{gArgs.GetDataDirNet() / "indexes" / "compacttxindex"};
+    const auto count_segments{[&] {
+        size_t segments{0};
+        for (const auto& entry : fs::directory_iterator(compact_dir)) {
+            if (entry.path().extension() == ".dat") ++segments;
+        }
+        return segments;
+    }};
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    std::vector<CTransactionRef> txns{m_coinbase_txns};
+    {
+        // Write a segment file on every commit, so that they get merged.
+        TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, false, false, TxIndexFormat::COMPACT, /*segment_entries=*/1);
+        BOOST_REQUIRE(txindex.Init());
+        BOOST_REQUIRE(txindex.StartBackgroundSync());
+        IndexWaitSynced(txindex);
+
+        constexpr int NUM_FLUSHES{12};
+        for (int i = 0; i < NUM_FLUSHES; ++i) {
+            const CBlock& block = CreateAndProcessBlock({}, GetScriptForDestination(PKHash(coinbaseKey.GetPubKey())));
+            txns.push_back(block.vtx[0]);
+            BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+            WITH_LOCK(::cs_main, m_node.chainman->ActiveChainstate().ForceFlushStateToDisk());
+            SyncWithValidationInterfaceQueue();
+        }
+        BOOST_CHECK_GT(count_segments(), 0U);
+        BOOST_CHECK_LT(count_segments(), NUM_FLUSHES / 2);
+
+        for (const auto& txn : txns) {
+            BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+            BOOST_CHECK_EQUAL(tx_disk->GetHash(), txn->GetHash());
+        }
+        for (const auto& txn : Params().GenesisBlock().vtx) {
+            BOOST_CHECK(!txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+        }
+
+        SyncWithValidationInterfaceQueue();
+        txindex.Stop();
+    }
+
+    // The segment files are found again once the index is restarted.
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, false, false, TxIndexFormat::COMPACT, /*segment_entries=*/1);
+    BOOST_REQUIRE(txindex.Init());
+    for (const auto& txn : txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+    txindex.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #include <logging.h>
 #include <net.h>
 #include <net_processing.h>
+#include <node/blockcompression.h>
 #include <node/blockstorage.h>
 #include <node/chainstate.h>
 #include <node/context.h>
@@ -177,10 +178,12 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, const std::vecto
         .datadir = m_args.GetDataDirNet(),
         .adjusted_time_callback = GetAdjustedTime,
         .check_block_index = true,
+        .block_prefetch = static_cast<int>(m_node.args->GetIntArg("-blockprefetch", DEFAULT_BLOCK_PREFETCH)),
         .notifications = *m_node.notifications,
     };
     const BlockManager::Options blockman_opts{
         .chainparams = chainman_opts.chainparams,
+        .compress_block_files = m_node.args->GetBoolArg("-blockcompression", node::DEFAULT_BLOCK_COMPRESSION),
         .blocks_dir = m_args.GetBlocksDirPath(),
         .notifications = chainman_opts.notifications,
     };
@@ -4,8 +4,10 @@
 //
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <primitives/transaction.h>
 #include <random.h>
 #include <rpc/blockchain.h>
+#include <script/script.h>
 #include <sync.h>
 #include <test/util/chainstate.h>
 #include <test/util/coins.h>
@@ -14,6 +16,7 @@
 #include <uint256.h>
 #include <validation.h>
 
+#include <tuple>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -140,4 +143,43 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup)
     BOOST_CHECK_EQUAL(curr_tip, ::g_best_block);
 }
 
+//! Test switching to a competing chain that is longer than a batch of
+//! blocks disconnected together.
+BOOST_FIXTURE_TEST_CASE(chainstate_deep_reorg, TestChain100Setup)
+{
+    ChainstateManager& chainman = *Assert(m_node.chainman);
+    Chainstate& chainstate = chainman.ActiveChainstate();
+    constexpr int FORK_LENGTH{40};
+    const CScript script_a{CScript() << OP_TRUE};
+    const CScript script_b{CScript() << OP_2};
+
+    const auto mine_fork{[&](const CScript& script) {
+        std::vector<COutPoint> coinbases;
+        for (int i = 0; i < FORK_LENGTH; ++i) {
+            coinbases.emplace_back(CreateAndProcessBlock({}, script).vtx[0]->GetHash(), 0);
+        }
+        return coinbases;
+    }};
+    const int fork_height{WITH_LOCK(::cs_main, return chainman.ActiveHeight())};
+    const std::vector<COutPoint> coinbases_a{mine_fork(script_a)};
+    CBlockIndex* tip_a{WITH_LOCK(::cs_main, return chainman.ActiveTip())};
+    CBlockIndex* first_a{WITH_LOCK(::cs_main, return chainman.ActiveChain()[fork_height + 1])};
+
+    BlockValidationState state;
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, first_a));
+    const std::vector<COutPoint> coinbases_b{mine_fork(script_b)};
+    CBlockIndex* tip_b{WITH_LOCK(::cs_main, return chainman.ActiveTip())};
+    WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(first_a));
+
+    // Both forks have the same work, so switch back and forth between them
+    for (const auto& [tip, coinbases, spent] : {std::tuple{tip_a, coinbases_a, coinbases_b}, std::tuple{tip_b, coinbases_b, coinbases_a}}) {
+        BOOST_REQUIRE(chainstate.PreciousBlock(state, tip));
+        LOCK(::cs_main);
+        BOOST_CHECK_EQUAL(chainman.ActiveTip(), tip);
+        BOOST_CHECK_EQUAL(chainstate.CoinsTip().GetBestBlock(), tip->GetBlockHash());
+        for (const COutPoint& outpoint : coinbases) BOOST_CHECK(chainstate.CoinsTip().HaveCoin(outpoint));
+        for (const COutPoint& outpoint : spent) BOOST_CHECK(!chainstate.CoinsTip().HaveCoin(outpoint));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 //
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <kernel/coinstats.h>
 #include <kernel/disconnected_transactions.h>
 #include <node/kernel_notifications.h>
 #include <node/utxo_snapshot.h>
@@ -16,7 +17,9 @@
 #include <test/util/setup_common.h>
 #include <test/util/validation.h>
 #include <timedata.h>
+#include <txdb.h>
 #include <uint256.h>
+#include <util/signalinterrupt.h>
 #include <validation.h>
 #include <validationinterface.h>
 
@@ -28,6 +31,7 @@
 
 using node::BlockManager;
 using node::KernelNotifications;
+using node::SNAPSHOT_PARTITION_COINS;
 using node::SnapshotMetadata;
 
 BOOST_FIXTURE_TEST_SUITE(validation_chainstatemanager_tests, TestingSetup)
@@ -232,20 +236,22 @@ struct SnapshotTestSetup : TestChain100Setup {
 
                 auto_infile >> outpoint;
                 auto_infile >> coin;
-        }));
+        }, /*reset_chainstate=*/false, /*in_memory_chainstate=*/false, /*partitioned=*/false));
 
         BOOST_CHECK(!node::FindSnapshotChainstateDir(chainman.m_options.datadir));
 
-        BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
-            this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
-                // Coins count is larger than coins in file
-                metadata.m_coins_count += 1;
-        }));
-        BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
-            this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
-                // Coins count is smaller than coins in file
-                metadata.m_coins_count -= 1;
-        }));
+        for (const bool partitioned : {false, true}) {
+            BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
+                this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
+                    // Coins count is larger than coins in file
+                    metadata.m_coins_count += 1;
+            }, /*reset_chainstate=*/false, /*in_memory_chainstate=*/false, partitioned));
+            BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
+                this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
+                    // Coins count is smaller than coins in file
+                    metadata.m_coins_count -= 1;
+            }, /*reset_chainstate=*/false, /*in_memory_chainstate=*/false, partitioned));
+        }
         BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
             this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
                 // Wrong hash
@@ -775,4 +781,117 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_snapshot_completion_hash_mismatch, Sna
     }
 }
 
+BOOST_AUTO_TEST_CASE(chainstatemanager_background_validation_scheduler)
+{
+    BackgroundValidationScheduler scheduler{100ms};
+    BOOST_CHECK_EQUAL(scheduler.GetDutyCycle(), 1.0);
+    BOOST_CHECK_EQUAL(scheduler.GetTipCacheShare(), MIN_TIP_CACHE_SHARE);
+    BOOST_CHECK(scheduler.GetPause(1s) == 0s);
+
+    // Missing the target halves the duty cycle down to its minimum.
+    BOOST_CHECK(!scheduler.AddTipLatency(150ms));
+    BOOST_CHECK_EQUAL(scheduler.GetDutyCycle(), 0.5);
+    BOOST_CHECK(scheduler.GetTipLatency() == 150ms);
+    BOOST_CHECK(scheduler.GetPause(1s) == 1s);
+    for (int i = 0; i < 3; ++i) BOOST_CHECK(!scheduler.AddTipLatency(150ms));
+    BOOST_CHECK_EQUAL(scheduler.GetDutyCycle(), MIN_BACKGROUND_VALIDATION_DUTY);
+    BOOST_CHECK(scheduler.GetPause(1s) == 15s);
+
+    // Then the cache share of the tip is doubled up to its maximum.
+    double tip_cache_share{MIN_TIP_CACHE_SHARE};
+    while (tip_cache_share < MAX_TIP_CACHE_SHARE) {
+        BOOST_CHECK(scheduler.AddTipLatency(150ms));
+        tip_cache_share = std::min(tip_cache_share * 2, MAX_TIP_CACHE_SHARE);
+        BOOST_CHECK_EQUAL(scheduler.GetTipCacheShare(), tip_cache_share);
+    }
+    BOOST_CHECK(!scheduler.AddTipLatency(150ms));
+
+    // Latencies between half the target and the target don't change the schedule.
+    BOOST_CHECK(!scheduler.AddTipLatency(60ms));
+    BOOST_CHECK_EQUAL(scheduler.GetDutyCycle(), MIN_BACKGROUND_VALIDATION_DUTY);
+
+    // Meeting the target gives time back to background validation first, then cache.
+    for (int i = 0; i < 4; ++i) BOOST_CHECK(!scheduler.AddTipLatency(10ms));
+    BOOST_CHECK_EQUAL(scheduler.GetDutyCycle(), 1.0);
+    BOOST_CHECK(scheduler.AddTipLatency(10ms));
+    BOOST_CHECK_EQUAL(scheduler.GetTipCacheShare(), MAX_TIP_CACHE_SHARE / 2);
+    while (scheduler.GetTipCacheShare() > MIN_TIP_CACHE_SHARE) scheduler.AddTipLatency(10ms);
+    BOOST_CHECK(!scheduler.AddTipLatency(10ms));
+}
+
+//! Write the coins of a database to a partitioned snapshot, load it on
+//! several threads into another database, and check that they hash the same.
+BOOST_AUTO_TEST_CASE(chainstatemanager_snapshot_partitions)
+{
+    const uint256 genesis_hash{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip()->GetBlockHash())};
+    constexpr int base_height{100};
+
+    CCoinsViewDB source{{.path = "source", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    uint64_t coins_count{0};
+    {
+        CCoinsViewCache cache{&source};
+        for (uint32_t i = 0; i < 20000; ++i) {
+            const uint256 txid{InsecureRand256()};
+            for (uint32_t n = 0; n < 1 + i % 3; ++n) {
+                cache.AddCoin(COutPoint{txid, n}, Coin{CTxOut{InsecureRandMoneyAmount(), CScript() << OP_TRUE}, static_cast<int>(i % base_height), /*fCoinBaseIn=*/false}, /*possible_overwrite=*/false);
+                ++coins_count;
+            }
+        }
+        // More coins than fit in a partition, all in the first outpoint range.
+        for (uint32_t i = 0; i < SNAPSHOT_PARTITION_COINS + 10; ++i) {
+            uint256 txid{InsecureRand256()};
+            *txid.begin() = 0;
+            cache.AddCoin(COutPoint{txid, 0}, Coin{CTxOut{1, CScript() << OP_TRUE}, 1, /*fCoinBaseIn=*/false}, /*possible_overwrite=*/false);
+            ++coins_count;
+        }
+        cache.SetBestBlock(genesis_hash);
+        BOOST_REQUIRE(cache.Flush());
+    }
+
+    const fs::path snapshot_path{m_path_root / "partitions.dat"};
+    {
+        AutoFile outfile{fsbridge::fopen(snapshot_path, "wb")};
+        outfile << SnapshotMetadata{genesis_hash, coins_count, /*partitioned=*/true};
+        for (const auto& cursor : source.PartitionCursors()) {
+            outfile.write(MakeByteSpan(node::SerializeSnapshotPartitions(*cursor, {})));
+        }
+    }
+
+    const auto load{[&](CCoinsViewDB& coins_db, uint64_t metadata_coins_count) {
+        AutoFile infile{fsbridge::fopen(snapshot_path, "rb")};
+        SnapshotMetadata metadata;
+        infile >> metadata;
+        BOOST_CHECK(metadata.m_partitioned);
+        BOOST_CHECK_EQUAL(metadata.m_base_blockhash, genesis_hash);
+        metadata.m_coins_count = metadata_coins_count;
+        const util::SignalInterrupt interrupt;
+        // A small cache so that the threads flush several times.
+        return node::LoadSnapshotPartitions(coins_db, infile, metadata, base_height, /*cache_size=*/1 << 20, /*num_threads=*/4, interrupt);
+    }};
+
+    CCoinsViewDB bad_count{{.path = "bad_count", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    BOOST_CHECK(!load(bad_count, coins_count - 1));
+
+    CCoinsViewDB loaded{{.path = "loaded", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    BOOST_REQUIRE(load(loaded, coins_count));
+    {
+        CCoinsViewCache cache{&loaded};
+        cache.SetBestBlock(genesis_hash);
+        BOOST_REQUIRE(cache.Flush());
+    }
+
+    BlockManager& blockman{m_node.chainman->m_blockman};
+    for (const auto hash_type : {kernel::CoinStatsHashType::HASH_SERIALIZED, kernel::CoinStatsHashType::MUHASH}) {
+        const auto expected{kernel::ComputeUTXOStats(hash_type, static_cast<CCoinsView*>(&source), blockman)};
+        const auto stats{kernel::ComputeUTXOStats(hash_type, &loaded, blockman, {}, /*num_threads=*/4)};
+        BOOST_REQUIRE(expected && stats);
+        BOOST_CHECK_EQUAL(stats->coins_count, coins_count);
+        BOOST_CHECK_EQUAL(stats->coins_count, expected->coins_count);
+        BOOST_CHECK_EQUAL(stats->nTransactions, expected->nTransactions);
+        BOOST_CHECK_EQUAL(stats->nBogoSize, expected->nBogoSize);
+        BOOST_CHECK(stats->total_amount == expected->total_amount);
+        BOOST_CHECK_EQUAL(stats->hashSerialized, expected->hashSerialized);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
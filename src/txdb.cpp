@@ -17,6 +17,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <iterator>
+#include <optional>
 #include <utility>
 
 static constexpr uint8_t DB_COIN{'C'};
@@ -127,8 +128,10 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
         it = erase ? mapCoins.erase(it) : std::next(it);
         if (batch.SizeEstimate() > m_options.batch_write_bytes) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
-            batch.Clear();
+            // Fill the next batch while this one is written. The final batch
+            // below waits for the partial batches, so the database is
+            // consistent with hashBlock when this returns.
+            m_db->WriteBatchAsync(batch);
             if (m_options.simulate_crash_ratio) {
                 static FastRandomContext rng;
                 if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
@@ -171,8 +174,14 @@ public:
     void Next() override;
 
 private:
+    //! Cache the key at the position of the iterator, or invalidate the
+    //! cursor if it is past its last record.
+    void CacheKey();
+
     std::unique_ptr<CDBIterator> pcursor;
     std::pair<char, COutPoint> keyTmp;
+    //! First byte of the txids at which the cursor stops, if it only iterates over a range of the coins
+    std::optional<uint8_t> m_end_byte;
 
     friend class CCoinsViewDB;
 };
@@ -186,16 +195,29 @@ std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
        that restriction.  */
     i->pcursor->Seek(DB_COIN);
     // Cache key of first record
-    if (i->pcursor->Valid()) {
-        CoinEntry entry(&i->keyTmp.second);
-        i->pcursor->GetKey(entry);
-        i->keyTmp.first = entry.key;
-    } else {
-        i->keyTmp.first = 0; // Make sure Valid() and GetKey() return false
-    }
+    i->CacheKey();
     return i;
 }
 
+std::vector<std::unique_ptr<CCoinsViewCursor>> CCoinsViewDB::PartitionCursors() const
+{
+    static_assert(COINS_DB_PARTITIONS == 256, "partitions are ranges of the first byte of the txid");
+    auto iterators{m_db->NewIterators(COINS_DB_PARTITIONS)};
+    const uint256 best_block{GetBestBlock()};
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    cursors.reserve(COINS_DB_PARTITIONS);
+    for (size_t i = 0; i < COINS_DB_PARTITIONS; ++i) {
+        auto cursor{std::make_unique<CCoinsViewDBCursor>(iterators[i].release(), best_block)};
+        if (i + 1 < COINS_DB_PARTITIONS) cursor->m_end_byte = i + 1;
+        COutPoint start;
+        *start.hash.begin() = i;
+        cursor->pcursor->Seek(CoinEntry(&start));
+        cursor->CacheKey();
+        cursors.push_back(std::move(cursor));
+    }
+    return cursors;
+}
+
 bool CCoinsViewDBCursor::GetKey(COutPoint &key) const
 {
     // Return cached key
@@ -219,8 +241,13 @@ bool CCoinsViewDBCursor::Valid() const
 void CCoinsViewDBCursor::Next()
 {
     pcursor->Next();
+    CacheKey();
+}
+
+void CCoinsViewDBCursor::CacheKey()
+{
     CoinEntry entry(&keyTmp.second);
-    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
+    if (!pcursor->Valid() || !pcursor->GetKey(entry) || (m_end_byte && *keyTmp.second.hash.begin() >= *m_end_byte)) {
         keyTmp.first = 0; // Invalidate cached key after last record so that Valid() and GetKey() return false
     } else {
         keyTmp.first = entry.key;
@@ -37,8 +37,12 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxTxIndexCache = 1024;
 //! Max memory allocated to all block filter index caches combined in MiB.
 static const int64_t max_filter_index_cache = 1024;
+//! Max memory allocated to the script index cache in MiB.
+static const int64_t max_script_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Number of ranges of txids that the coins database can be iterated over in parallel
+static constexpr size_t COINS_DB_PARTITIONS{256};
 
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
@@ -66,6 +70,12 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
+    //! Get one cursor for each of the COINS_DB_PARTITIONS ranges of txids, by
+    //! their first byte, in key order. The cursors all iterate over the same
+    //! state of the database, so that they can be used on several threads
+    //! to go over the whole set of coins.
+    std::vector<std::unique_ptr<CCoinsViewCursor>> PartitionCursors() const;
+
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
     size_t EstimateSize() const override;
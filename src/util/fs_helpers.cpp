@@ -160,6 +160,15 @@ void DirectoryCommit(const fs::path& dirname)
 #endif
 }
 
+void FileWriteback(FILE* file, unsigned int offset, unsigned int length)
+{
+#if defined(__linux__) && defined(SYNC_FILE_RANGE_WRITE)
+    if (fflush(file) != 0) return;
+    // Only initiates the writeback, errors are reported by FileCommit
+    sync_file_range(fileno(file), offset, length, SYNC_FILE_RANGE_WRITE);
+#endif
+}
+
 bool TruncateFile(FILE* file, unsigned int length)
 {
 #if defined(WIN32)
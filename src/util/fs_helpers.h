@@ -25,6 +25,13 @@ bool FileCommit(FILE* file);
  */
 void DirectoryCommit(const fs::path& dirname);
 
+/**
+ * Start writing back a range of a file to disk without waiting for it, so
+ * that a later FileCommit has less left to write. Does nothing on platforms
+ * without sync_file_range().
+ */
+void FileWriteback(FILE* file, unsigned int offset, unsigned int length);
+
 bool TruncateFile(FILE* file, unsigned int length);
 int RaiseFileDescriptorLimit(int nMinFD);
 void AllocateFileRange(FILE* file, unsigned int offset, unsigned int length);
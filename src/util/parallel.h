@@ -0,0 +1,112 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_PARALLEL_H
+#define BITCOIN_UTIL_PARALLEL_H
+
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/thread.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util {
+/**
+ * Call process(i) for each i in [0, count) on up to num_threads threads, and
+ * pass the results to consume() on the calling thread, in the order of i.
+ *
+ * Threads don't run ahead of consume() by more than twice their number of
+ * items, which bounds the memory used by results waiting to be consumed.
+ * An exception thrown by process() or consume() stops the remaining work
+ * and is rethrown once the threads have exited.
+ */
+template <typename Process, typename Consume>
+void ParallelForOrdered(const std::string& thread_name, size_t count, int num_threads, Process process, Consume consume)
+{
+    using Result = std::invoke_result_t<Process&, size_t>;
+    if (num_threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) consume(process(i));
+        return;
+    }
+
+    Mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::optional<Result>> results(count);
+    const size_t max_pending{2 * static_cast<size_t>(num_threads)};
+    size_t next_process{0};
+    size_t next_consume{0};
+    bool stop{false};
+    std::exception_ptr error;
+
+    const auto fail{[&](std::exception_ptr e) EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+        if (!error) error = std::move(e);
+        stop = true;
+    }};
+
+    const auto worker{[&] {
+        while (true) {
+            size_t i;
+            {
+                WAIT_LOCK(mutex, lock);
+                cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+                    return stop || next_process == count || next_process < next_consume + max_pending;
+                });
+                if (stop || next_process == count) return;
+                i = next_process++;
+            }
+            try {
+                Result result{process(i)};
+                LOCK(mutex);
+                results[i] = std::move(result);
+            } catch (...) {
+                LOCK(mutex);
+                fail(std::current_exception());
+            }
+            cond.notify_all();
+        }
+    }};
+
+    std::vector<std::thread> threads;
+    const size_t thread_count{std::min(count, static_cast<size_t>(num_threads))};
+    for (size_t n = 0; n < thread_count; ++n) {
+        threads.emplace_back(&util::TraceThread, strprintf("%s.%i", thread_name, n), worker);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        std::optional<Result> result;
+        {
+            WAIT_LOCK(mutex, lock);
+            cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(mutex) { return stop || results[i].has_value(); });
+            if (stop) break;
+            result = std::move(results[i]);
+            results[i].reset();
+            next_consume = i + 1;
+        }
+        cond.notify_all();
+        try {
+            consume(std::move(*result));
+        } catch (...) {
+            LOCK(mutex);
+            fail(std::current_exception());
+            break;
+        }
+    }
+
+    WITH_LOCK(mutex, stop = true);
+    cond.notify_all();
+    for (std::thread& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
+}
+} // namespace util
+
+#endif // BITCOIN_UTIL_PARALLEL_H
@@ -50,9 +50,11 @@
 #include <util/fs_helpers.h>
 #include <util/hasher.h>
 #include <util/moneystr.h>
+#include <util/parallel.h>
 #include <util/rbf.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
@@ -63,10 +65,14 @@
 #include <cassert>
 #include <chrono>
 #include <deque>
+#include <map>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <unordered_set>
 #include <utility>
 
 using kernel::CCoinsStats;
@@ -102,6 +108,18 @@ const std::vector<std::string> CHECKLEVEL_DOC {
  *  noticeably interfere with the pruning mechanism.
  * */
 static constexpr int PRUNE_LOCK_BUFFER{10};
+/** Maximum number of threads deserializing and checking blocks during -reindex and -loadblock. */
+static constexpr int MAX_BLOCK_IMPORT_THREADS{8};
+/** Size of the block records read from an external block file before they are checked together. */
+static constexpr size_t BLOCK_IMPORT_BATCH_SIZE{32 << 20};
+/** Size of the out of order blocks of a block file kept in memory until their parent is loaded. */
+static constexpr size_t MAX_BLOCK_IMPORT_BUFFER_SIZE{64 << 20};
+/** Maximum number of threads reading and checking blocks in VerifyDB. */
+static constexpr int MAX_VERIFY_DB_THREADS{8};
+/** Maximum number of threads reading blocks and undo data to disconnect in a reorg. */
+static constexpr int MAX_DISCONNECT_THREADS{8};
+/** Number of blocks of a reorg disconnected together into a single view. */
+static constexpr size_t DISCONNECT_BATCH_SIZE{32};
 
 GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
@@ -1696,6 +1714,7 @@ Chainstate::Chainstate(
     : m_mempool(mempool),
       m_blockman(blockman),
       m_chainman(chainman),
+      m_block_prefetcher(blockman, static_cast<size_t>(chainman.m_options.block_prefetch)),
       m_from_snapshot_blockhash(from_snapshot_blockhash) {}
 
 const CBlockIndex* Chainstate::SnapshotBase()
@@ -2015,13 +2034,19 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
 {
     AssertLockHeld(::cs_main);
-    bool fClean = true;
 
     CBlockUndo blockUndo;
     if (!m_blockman.UndoReadFromDisk(blockUndo, *pindex)) {
         error("DisconnectBlock(): failure reading undo data");
         return DISCONNECT_FAILED;
     }
+    return DisconnectBlock(block, std::move(blockUndo), pindex, view);
+}
+
+DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, CBlockUndo blockUndo, const CBlockIndex* pindex, CCoinsViewCache& view)
+{
+    AssertLockHeld(::cs_main);
+    bool fClean = true;
 
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
         error("DisconnectBlock(): block and undo data inconsistent");
@@ -2857,6 +2882,120 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     return true;
 }
 
+/** Disconnect m_chain's tip down to pindex_fork.
+  * Blocks are disconnected in batches: the blocks and undo data of a batch are
+  * read on several threads and disconnected into a single view, which is
+  * flushed to the coins tip once. As with DisconnectTip, the mempool is left
+  * in an inconsistent state, with transactions from disconnected blocks being
+  * added to disconnectpool.
+  */
+bool Chainstate::DisconnectTips(BlockValidationState& state, const CBlockIndex* pindex_fork, DisconnectedBlockTransactions* disconnectpool)
+{
+    AssertLockHeld(cs_main);
+    if (m_mempool) AssertLockHeld(m_mempool->cs);
+
+    const int num_threads{std::clamp<int>(std::thread::hardware_concurrency(), 1, MAX_DISCONNECT_THREADS)};
+
+    //! A block to disconnect and where to read it from. Worker threads don't
+    //! take cs_main, so positions are looked up beforehand.
+    struct BlockToDisconnect {
+        CBlockIndex* pindex;
+        FlatFilePos pos;
+        FlatFilePos undo_pos;
+        uint256 prev_hash;
+    };
+    //! A block and its undo data read on a worker thread, or nullptr if they couldn't be
+    struct ReadBlock {
+        std::shared_ptr<CBlock> block;
+        CBlockUndo undo;
+    };
+    //! Stops disconnecting the batch, leaving the chain unchanged
+    struct DisconnectFailed {
+    };
+
+    while (m_chain.Tip() && m_chain.Tip() != pindex_fork) {
+        std::vector<BlockToDisconnect> blocks;
+        for (CBlockIndex* pindex{m_chain.Tip()}; pindex != pindex_fork && blocks.size() < DISCONNECT_BATCH_SIZE; pindex = pindex->pprev) {
+            assert(pindex->pprev);
+            blocks.push_back({pindex, pindex->GetBlockPos(), pindex->GetUndoPos(), pindex->pprev->GetBlockHash()});
+        }
+
+        // Apply the blocks atomically to the chain state.
+        const auto time_start{SteadyClock::now()};
+        std::vector<std::shared_ptr<const CBlock>> disconnected;
+        {
+            CCoinsViewCache view(&CoinsTip());
+            try {
+                util::ParallelForOrdered(
+                    "disconnect", blocks.size(), num_threads,
+                    [&](size_t i) {
+                        const BlockToDisconnect& to_disconnect{blocks[i]};
+                        ReadBlock read{std::make_shared<CBlock>()};
+                        if (!m_blockman.ReadBlockFromDisk(*read.block, to_disconnect.pos) || read.block->GetHash() != to_disconnect.pindex->GetBlockHash()) {
+                            error("DisconnectTips(): Failed to read block %s", to_disconnect.pindex->GetBlockHash().ToString());
+                            read.block.reset();
+                        } else if (!m_blockman.UndoReadFromDisk(read.undo, to_disconnect.undo_pos, to_disconnect.prev_hash)) {
+                            error("DisconnectTips(): Failed to read undo data of block %s", to_disconnect.pindex->GetBlockHash().ToString());
+                            read.block.reset();
+                        }
+                        return read;
+                    },
+                    [&](ReadBlock read) {
+                        const CBlockIndex* pindex{blocks[disconnected.size()].pindex};
+                        if (!read.block) throw DisconnectFailed{};
+                        assert(view.GetBestBlock() == pindex->GetBlockHash());
+                        if (DisconnectBlock(*read.block, std::move(read.undo), pindex, view) != DISCONNECT_OK) {
+                            error("DisconnectTips(): DisconnectBlock %s failed", pindex->GetBlockHash().ToString());
+                            throw DisconnectFailed{};
+                        }
+                        disconnected.push_back(std::move(read.block));
+                    });
+            } catch (const DisconnectFailed&) {
+                return false;
+            }
+            bool flushed = view.Flush();
+            assert(flushed);
+        }
+        LogPrint(BCLog::BENCH, "- Disconnect %u blocks: %.2fms\n", blocks.size(),
+                 Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            CBlockIndex* pindexDelete{blocks[i].pindex};
+            {
+                // Prune locks that began at or after the tip should be moved backward so they get a chance to reorg
+                const int max_height_first{pindexDelete->nHeight - 1};
+                for (auto& prune_lock : m_blockman.m_prune_locks) {
+                    if (prune_lock.second.height_first <= max_height_first) continue;
+
+                    prune_lock.second.height_first = max_height_first;
+                    LogPrint(BCLog::PRUNE, "%s prune lock moved back to %d\n", prune_lock.first, max_height_first);
+                }
+            }
+
+            if (disconnectpool && m_mempool) {
+                // Save transactions to re-add to mempool at end of reorg. If any entries are evicted for
+                // exceeding memory limits, remove them and their descendants from the mempool.
+                for (auto&& evicted_tx : disconnectpool->AddTransactionsFromBlock(disconnected[i]->vtx)) {
+                    m_mempool->removeRecursive(*evicted_tx, MemPoolRemovalReason::REORG);
+                }
+            }
+
+            m_chain.SetTip(*pindexDelete->pprev);
+
+            UpdateTip(pindexDelete->pprev);
+            // Let wallets know transactions went from 1-confirmed to
+            // 0-confirmed or conflicted:
+            GetMainSignals().BlockDisconnected(disconnected[i], pindexDelete);
+        }
+
+        // Write the chain state to disk, if necessary.
+        if (!FlushStateToDisk(state, FlushStateMode::IF_NEEDED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static SteadyClock::duration time_connect_total{};
 static SteadyClock::duration time_flush{};
 static SteadyClock::duration time_chainstate{};
@@ -2917,7 +3056,9 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     // Read block from disk.
     const auto time_1{SteadyClock::now()};
     std::shared_ptr<const CBlock> pthisBlock;
-    if (!pblock) {
+    if (!pblock && (pthisBlock = m_block_prefetcher.Take(*pindexNew))) {
+        LogPrint(BCLog::BENCH, "  - Using prefetched block\n");
+    } else if (!pblock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
         if (!m_blockman.ReadBlockFromDisk(*pblockNew, *pindexNew)) {
             return FatalError(m_chainman.GetNotifications(), state, "Failed to read block");
@@ -2994,6 +3135,13 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     // If we are the background validation chainstate, check to see if we are done
     // validating the snapshot (i.e. our tip has reached the snapshot's base block).
     if (this != &m_chainman.ActiveChainstate()) {
+        BackgroundValidationStats& stats{m_chainman.m_background_validation_stats};
+        if (!stats.start) stats.start = time_1;
+        ++stats.blocks;
+        for (const auto& tx : blockConnecting.vtx) {
+            if (!tx->IsCoinBase()) stats.inputs += tx->vin.size();
+        }
+
         // This call may set `m_disabled`, which is referenced immediately afterwards in
         // ActivateBestChain, so that we stop connecting blocks past the snapshot base.
         m_chainman.MaybeCompleteSnapshotValidation();
@@ -3095,8 +3243,8 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
     // Disconnect active blocks which are no longer in the best chain.
     bool fBlocksDisconnected = false;
     DisconnectedBlockTransactions disconnectpool{MAX_DISCONNECTED_TX_POOL_BYTES};
-    while (m_chain.Tip() && m_chain.Tip() != pindexFork) {
-        if (!DisconnectTip(state, &disconnectpool)) {
+    if (m_chain.Tip() && m_chain.Tip() != pindexFork) {
+        if (!DisconnectTips(state, pindexFork, &disconnectpool)) {
             // This is likely a fatal error, but keep the mempool consistent,
             // just in case. Only remove from the mempool in this case.
             MaybeUpdateMempoolForReorg(disconnectpool, false);
@@ -3127,6 +3275,14 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
         }
         nHeight = nTargetHeight;
 
+        // Read the blocks to connect ahead, except for the one we were given.
+        std::vector<const CBlockIndex*> prefetch;
+        for (const CBlockIndex* pindex : reverse_iterate(vpindexToConnect)) {
+            if (pblock && pindex == pindexMostWork) break;
+            prefetch.push_back(pindex);
+        }
+        m_block_prefetcher.Prefetch(prefetch);
+
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
             if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
@@ -3207,7 +3363,7 @@ static void LimitValidationInterfaceQueue() LOCKS_EXCLUDED(cs_main) {
     }
 }
 
-bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<const CBlock> pblock)
+bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<const CBlock> pblock, std::optional<SteadyClock::time_point> deadline)
 {
     AssertLockNotHeld(m_chainstate_mutex);
 
@@ -3347,6 +3503,8 @@ bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<
         // caused an assert() failure during interrupt in such cases as the UTXO DB flushing checks
         // that the best block hash is non-null.
         if (m_chainman.m_interrupt) break;
+
+        if (deadline && SteadyClock::now() >= *deadline) break;
     } while (pindexNewTip != pindexMostWork);
 
     m_chainman.CheckBlockIndex();
@@ -3773,9 +3931,16 @@ bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consens
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers)
 {
     arith_uint256 total_work{0};
+    // nBits only changes at difficulty adjustments, avoid recomputing the
+    // work of every header.
+    CBlockIndex dummy;
+    arith_uint256 work{0};
     for (const CBlockHeader& header : headers) {
-        CBlockIndex dummy(header);
-        total_work += GetBlockProof(dummy);
+        if (header.nBits != dummy.nBits) {
+            dummy.nBits = header.nBits;
+            work = GetBlockProof(dummy);
+        }
+        total_work += work;
     }
     return total_work;
 }
@@ -4209,16 +4374,37 @@ bool ChainstateManager::ProcessNewBlock(const std::shared_ptr<const CBlock>& blo
 
     NotifyHeaderTip(*this);
 
+    const auto time_start{SteadyClock::now()};
     BlockValidationState state; // Only used to report errors, not invalidity - ignore it
     if (!ActiveChainstate().ActivateBestChain(state, block)) {
         return error("%s: ActivateBestChain failed (%s)", __func__, state.ToString());
     }
 
-    Chainstate* bg_chain{WITH_LOCK(cs_main, return BackgroundSyncInProgress() ? m_ibd_chainstate.get() : nullptr)};
+    Chainstate* bg_chain{nullptr};
+    {
+        LOCK(cs_main);
+        if (BackgroundSyncInProgress()) {
+            bg_chain = m_ibd_chainstate.get();
+            if (ActiveTip()->GetBlockHash() == block->GetHash() &&
+                m_background_validation_scheduler.AddTipLatency(std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - time_start))) {
+                LogPrintf("[snapshot] allocating %.0f%% of the cache to the snapshot chainstate to connect new blocks within %dms\n",
+                          m_background_validation_scheduler.GetTipCacheShare() * 100, count_milliseconds(m_options.background_validation_latency));
+                MaybeRebalanceCaches();
+            }
+        }
+    }
+    if (!bg_chain) return true;
+
+    if (m_thread_background_validation.joinable()) {
+        WITH_LOCK(m_background_validation_mutex, m_background_validation_pending = true);
+        m_background_validation_cv.notify_one();
+        return true;
+    }
+
     BlockValidationState bg_state;
-    if (bg_chain && !bg_chain->ActivateBestChain(bg_state, block)) {
+    if (!bg_chain->ActivateBestChain(bg_state, block)) {
         return error("%s: [background] ActivateBestChain failed (%s)", __func__, bg_state.ToString());
-     }
+    }
 
     return true;
 }
@@ -4341,22 +4527,49 @@ VerifyDBResult CVerifyDB::VerifyDB(
     CBlockIndex* pindex;
     CBlockIndex* pindexFailure = nullptr;
     int nGoodTransactions = 0;
-    BlockValidationState state;
     int reportDone = 0;
     bool skipped_no_block_data{false};
     bool skipped_l3_checks{false};
     LogPrintf("Verification progress: 0%%\n");
 
     const bool is_snapshot_cs{chainstate.m_from_snapshot_blockhash};
-
-    for (pindex = chainstate.m_chain.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
-        const int percentageDone = std::max(1, std::min(99, (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100))));
+    const int num_threads{std::clamp<int>(std::thread::hardware_concurrency(), 1, MAX_VERIFY_DB_THREADS)};
+    const auto report_progress{[&](int percentageDone) {
         if (reportDone < percentageDone / 10) {
             // report every 10% step
             LogPrintf("Verification progress: %d%%\n", percentageDone);
             reportDone = percentageDone / 10;
         }
         m_notifications.progress(_("Verifying blocks…"), percentageDone, false);
+    }};
+
+    //! A block to verify and where to read it from. Worker threads don't take
+    //! cs_main, so positions are looked up beforehand.
+    struct BlockToVerify {
+        CBlockIndex* pindex;
+        FlatFilePos pos;
+        FlatFilePos undo_pos;
+    };
+    //! A block read and checked on a worker thread, or why it couldn't be
+    struct VerifiedBlock {
+        CBlock block;
+        std::optional<CBlockUndo> undo;
+        VerifyDBResult result{VerifyDBResult::SUCCESS};
+    };
+    //! Stops verification early, with result
+    struct VerifyDBStop {
+        VerifyDBResult result;
+    };
+    const auto read_block{[&](const BlockToVerify& to_verify, CBlock& block) {
+        if (!chainstate.m_blockman.ReadBlockFromDisk(block, to_verify.pos) || block.GetHash() != to_verify.pindex->GetBlockHash()) {
+            LogPrintf("Verification error: ReadBlockFromDisk failed at %d, hash=%s\n", to_verify.pindex->nHeight, to_verify.pindex->GetBlockHash().ToString());
+            return false;
+        }
+        return true;
+    }};
+
+    std::vector<BlockToVerify> blocks;
+    for (pindex = chainstate.m_chain.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
         if (pindex->nHeight <= chainstate.m_chain.Height() - nCheckDepth) {
             break;
         }
@@ -4367,51 +4580,74 @@ VerifyDBResult CVerifyDB::VerifyDB(
             skipped_no_block_data = true;
             break;
         }
-        CBlock block;
-        // check level 0: read from disk
-        if (!chainstate.m_blockman.ReadBlockFromDisk(block, *pindex)) {
-            LogPrintf("Verification error: ReadBlockFromDisk failed at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-            return VerifyDBResult::CORRUPTED_BLOCK_DB;
-        }
-        // check level 1: verify block validity
-        if (nCheckLevel >= 1 && !CheckBlock(block, state, consensus_params)) {
-            LogPrintf("Verification error: found bad block at %d, hash=%s (%s)\n",
-                      pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
-            return VerifyDBResult::CORRUPTED_BLOCK_DB;
-        }
-        // check level 2: verify undo validity
-        if (nCheckLevel >= 2 && pindex) {
-            CBlockUndo undo;
-            if (!pindex->GetUndoPos().IsNull()) {
-                if (!chainstate.m_blockman.UndoReadFromDisk(undo, *pindex)) {
-                    LogPrintf("Verification error: found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-                    return VerifyDBResult::CORRUPTED_BLOCK_DB;
-                }
-            }
-        }
-        // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
-        size_t curr_coins_usage = coins.DynamicMemoryUsage() + chainstate.CoinsTip().DynamicMemoryUsage();
+        blocks.push_back({pindex, pindex->GetBlockPos(), pindex->GetUndoPos()});
+    }
+    CBlockIndex* const pindex_stop{pindex};
 
-        if (nCheckLevel >= 3) {
-            if (curr_coins_usage <= chainstate.m_coinstip_cache_size_bytes) {
-                assert(coins.GetBestBlock() == pindex->GetBlockHash());
-                DisconnectResult res = chainstate.DisconnectBlock(block, pindex, coins);
-                if (res == DISCONNECT_FAILED) {
-                    LogPrintf("Verification error: irrecoverable inconsistency in block data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-                    return VerifyDBResult::CORRUPTED_BLOCK_DB;
+    // Blocks are read and checked (levels 0 to 2) on several threads, and
+    // disconnected (level 3) in order as they become available.
+    size_t next_block{0};
+    try {
+        util::ParallelForOrdered(
+            "verifydb", blocks.size(), num_threads,
+            [&](size_t i) {
+                const BlockToVerify& to_verify{blocks[i]};
+                VerifiedBlock verified;
+                // check level 0: read from disk
+                if (!read_block(to_verify, verified.block)) {
+                    verified.result = VerifyDBResult::CORRUPTED_BLOCK_DB;
+                    return verified;
                 }
-                if (res == DISCONNECT_UNCLEAN) {
-                    nGoodTransactions = 0;
-                    pindexFailure = pindex;
-                } else {
-                    nGoodTransactions += block.vtx.size();
+                // check level 1: verify block validity
+                BlockValidationState state;
+                if (nCheckLevel >= 1 && !CheckBlock(verified.block, state, consensus_params)) {
+                    LogPrintf("Verification error: found bad block at %d, hash=%s (%s)\n",
+                              to_verify.pindex->nHeight, to_verify.pindex->GetBlockHash().ToString(), state.ToString());
+                    verified.result = VerifyDBResult::CORRUPTED_BLOCK_DB;
+                    return verified;
                 }
-            } else {
-                skipped_l3_checks = true;
-            }
-        }
-        if (chainstate.m_chainman.m_interrupt) return VerifyDBResult::INTERRUPTED;
+                // check level 2: verify undo validity
+                if (nCheckLevel >= 2 && !to_verify.undo_pos.IsNull()) {
+                    if (!chainstate.m_blockman.UndoReadFromDisk(verified.undo.emplace(), to_verify.undo_pos, to_verify.pindex->pprev->GetBlockHash())) {
+                        LogPrintf("Verification error: found bad undo data at %d, hash=%s\n", to_verify.pindex->nHeight, to_verify.pindex->GetBlockHash().ToString());
+                        verified.result = VerifyDBResult::CORRUPTED_BLOCK_DB;
+                    }
+                }
+                return verified;
+            },
+            [&](VerifiedBlock verified) {
+                pindex = blocks[next_block++].pindex;
+                report_progress(std::max(1, std::min(99, (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100)))));
+                if (verified.result != VerifyDBResult::SUCCESS) throw VerifyDBStop{verified.result};
+
+                // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
+                size_t curr_coins_usage = coins.DynamicMemoryUsage() + chainstate.CoinsTip().DynamicMemoryUsage();
+
+                if (nCheckLevel >= 3) {
+                    if (curr_coins_usage <= chainstate.m_coinstip_cache_size_bytes) {
+                        assert(coins.GetBestBlock() == pindex->GetBlockHash());
+                        DisconnectResult res = verified.undo ? chainstate.DisconnectBlock(verified.block, std::move(*verified.undo), pindex, coins) :
+                                                               chainstate.DisconnectBlock(verified.block, pindex, coins);
+                        if (res == DISCONNECT_FAILED) {
+                            LogPrintf("Verification error: irrecoverable inconsistency in block data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
+                            throw VerifyDBStop{VerifyDBResult::CORRUPTED_BLOCK_DB};
+                        }
+                        if (res == DISCONNECT_UNCLEAN) {
+                            nGoodTransactions = 0;
+                            pindexFailure = pindex;
+                        } else {
+                            nGoodTransactions += verified.block.vtx.size();
+                        }
+                    } else {
+                        skipped_l3_checks = true;
+                    }
+                }
+                if (chainstate.m_chainman.m_interrupt) throw VerifyDBStop{VerifyDBResult::INTERRUPTED};
+            });
+    } catch (const VerifyDBStop& stop) {
+        return stop.result;
     }
+    pindex = pindex_stop;
     if (pindexFailure) {
         LogPrintf("Verification error: coin database inconsistencies found (last %i blocks, %i good transactions before that)\n", chainstate.m_chain.Height() - pindexFailure->nHeight + 1, nGoodTransactions);
         return VerifyDBResult::CORRUPTED_BLOCK_DB;
@@ -4423,27 +4659,34 @@ VerifyDBResult CVerifyDB::VerifyDB(
     // store block count as we move pindex at check level >= 4
     int block_count = chainstate.m_chain.Height() - pindex->nHeight;
 
-    // check level 4: try reconnecting blocks
+    // check level 4: try reconnecting blocks, which are read ahead on several threads
     if (nCheckLevel >= 4 && !skipped_l3_checks) {
-        while (pindex != chainstate.m_chain.Tip()) {
-            const int percentageDone = std::max(1, std::min(99, 100 - (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * 50)));
-            if (reportDone < percentageDone / 10) {
-                // report every 10% step
-                LogPrintf("Verification progress: %d%%\n", percentageDone);
-                reportDone = percentageDone / 10;
-            }
-            m_notifications.progress(_("Verifying blocks…"), percentageDone, false);
-            pindex = chainstate.m_chain.Next(pindex);
-            CBlock block;
-            if (!chainstate.m_blockman.ReadBlockFromDisk(block, *pindex)) {
-                LogPrintf("Verification error: ReadBlockFromDisk failed at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-                return VerifyDBResult::CORRUPTED_BLOCK_DB;
-            }
-            if (!chainstate.ConnectBlock(block, state, pindex, coins)) {
-                LogPrintf("Verification error: found unconnectable block at %d, hash=%s (%s)\n", pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
-                return VerifyDBResult::CORRUPTED_BLOCK_DB;
-            }
-            if (chainstate.m_chainman.m_interrupt) return VerifyDBResult::INTERRUPTED;
+        std::vector<BlockToVerify> reconnect;
+        for (CBlockIndex* pindex_connect{chainstate.m_chain.Next(pindex)}; pindex_connect; pindex_connect = chainstate.m_chain.Next(pindex_connect)) {
+            reconnect.push_back({pindex_connect, pindex_connect->GetBlockPos(), {}});
+        }
+        size_t next_reconnect{0};
+        try {
+            util::ParallelForOrdered(
+                "verifydb", reconnect.size(), num_threads,
+                [&](size_t i) {
+                    VerifiedBlock verified;
+                    if (!read_block(reconnect[i], verified.block)) verified.result = VerifyDBResult::CORRUPTED_BLOCK_DB;
+                    return verified;
+                },
+                [&](VerifiedBlock verified) {
+                    pindex = reconnect[next_reconnect++].pindex;
+                    report_progress(std::max(1, std::min(99, 100 - (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight + 1)) / (double)nCheckDepth * 50))));
+                    if (verified.result != VerifyDBResult::SUCCESS) throw VerifyDBStop{verified.result};
+                    BlockValidationState state;
+                    if (!chainstate.ConnectBlock(verified.block, state, pindex, coins)) {
+                        LogPrintf("Verification error: found unconnectable block at %d, hash=%s (%s)\n", pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
+                        throw VerifyDBStop{VerifyDBResult::CORRUPTED_BLOCK_DB};
+                    }
+                    if (chainstate.m_chainman.m_interrupt) throw VerifyDBStop{VerifyDBResult::INTERRUPTED};
+                });
+        } catch (const VerifyDBStop& stop) {
+            return stop.result;
         }
     }
 
@@ -4501,13 +4744,13 @@ bool Chainstate::ReplayBlocks()
     if (m_blockman.m_block_index.count(hashHeads[0]) == 0) {
         return error("ReplayBlocks(): reorganization to unknown block requested");
     }
-    pindexNew = &(m_blockman.m_block_index[hashHeads[0]]);
+    pindexNew = &m_blockman.m_block_index.find(hashHeads[0])->second;
 
     if (!hashHeads[1].IsNull()) { // The old tip is allowed to be 0, indicating it's the first flush.
         if (m_blockman.m_block_index.count(hashHeads[1]) == 0) {
             return error("ReplayBlocks(): reorganization from unknown block requested");
         }
-        pindexOld = &(m_blockman.m_block_index[hashHeads[1]]);
+        pindexOld = &m_blockman.m_block_index.find(hashHeads[1])->second;
         pindexFork = LastCommonAncestor(pindexOld, pindexNew);
         assert(pindexFork != nullptr);
     }
@@ -4575,6 +4818,7 @@ void Chainstate::ClearBlockIndexCandidates()
 bool ChainstateManager::LoadBlockIndex()
 {
     AssertLockHeld(cs_main);
+    m_blockman.ScanCompressedBlockFiles();
     // Load block index from databases
     bool needs_init = fReindex;
     if (!fReindex) {
@@ -4621,6 +4865,7 @@ bool ChainstateManager::LoadBlockIndex()
 
         LogPrintf("Initializing databases...\n");
     }
+    m_blockman.m_block_index_loaded = true;
     return true;
 }
 
@@ -4662,167 +4907,295 @@ void ChainstateManager::LoadExternalBlockFile(
 
     const auto start{SteadyClock::now()};
     const CChainParams& params{GetParams()};
+    const int num_threads{std::clamp<int>(std::thread::hardware_concurrency(), 1, MAX_BLOCK_IMPORT_THREADS)};
+
+    //! A block record found in the file
+    struct BlockRecord {
+        uint64_t pos;
+        size_t size;
+        CBlockHeader header;
+        uint256 hash;
+        //! Whether the block is expected to be loaded, in which case it is
+        //! read into the batch buffer at offset and checked ahead
+        bool check{false};
+        size_t offset{0};
+    };
+    //! A block deserialized and checked on a worker thread
+    struct CheckedBlock {
+        std::shared_ptr<const CBlock> block;
+        std::string error;
+    };
 
     int nLoaded = 0;
-    try {
-        BufferedFile blkdat{file_in, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8};
-        // nRewind indicates where to resume scanning in case something goes wrong,
-        // such as a block fails to deserialize.
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
-            if (m_interrupt) return;
+    std::vector<unsigned char> batch_data;
+    // Blocks of this file that don't connect to the block index yet, by
+    // position, kept in memory until their parent is loaded so that they
+    // don't need to be read again.
+    std::map<unsigned int, std::vector<unsigned char>> buffered_blocks;
+    size_t buffered_size{0};
+    const char* const func{__func__};
+
+    const auto read_block{[&](Span<const unsigned char> data) {
+        auto pblock{std::make_shared<CBlock>()};
+        SpanReader{file_in.GetVersion(), data} >> *pblock;
+        return pblock;
+    }};
+
+    // Load a block, or store it for later if its parent isn't known yet.
+    // Return whether to go on loading blocks.
+    const auto load_block{[&](const BlockRecord& record, CheckedBlock& checked) {
+        const uint256& hash{record.hash};
+        std::shared_ptr<const CBlock> pblock{}; // needs to remain available after the cs_main lock is released to avoid duplicate reads from disk
 
-            blkdat.SetPos(nRewind);
-            nRewind++; // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
-            try {
-                // locate a header
-                MessageStartChars buf;
-                blkdat.FindByte(std::byte(params.MessageStart()[0]));
-                nRewind = blkdat.GetPos() + 1;
-                blkdat >> buf;
-                if (buf != params.MessageStart()) {
-                    continue;
+        {
+            LOCK(cs_main);
+            // detect out of order blocks, and store them for later
+            if (hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(record.header.hashPrevBlock)) {
+                LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", func, hash.ToString(),
+                         record.header.hashPrevBlock.ToString());
+                if (dbp && blocks_with_unknown_parent) {
+                    blocks_with_unknown_parent->emplace(record.header.hashPrevBlock, *dbp);
                 }
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
-                    continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                // (this happens at the end of every blk.dat file)
-                break;
+                return true;
             }
-            try {
-                // read block header
-                const uint64_t nBlockPos{blkdat.GetPos()};
-                if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                CBlockHeader header;
-                blkdat >> header;
-                const uint256 hash{header.GetHash()};
-                // Skip the rest of this block (this may read from disk into memory); position to the marker before the
-                // next block, but it's still possible to rewind to the start of the current block (without a disk read).
-                nRewind = nBlockPos + nSize;
-                blkdat.SkipTo(nRewind);
-
-                std::shared_ptr<CBlock> pblock{}; // needs to remain available after the cs_main lock is released to avoid duplicate reads from disk
-
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    if (hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(header.hashPrevBlock)) {
-                        LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                                 header.hashPrevBlock.ToString());
-                        if (dbp && blocks_with_unknown_parent) {
-                            blocks_with_unknown_parent->emplace(header.hashPrevBlock, *dbp);
-                        }
-                        continue;
+
+            // process in case the block isn't known yet
+            const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
+            if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+                if (!checked.error.empty()) throw std::ios_base::failure(checked.error);
+                if (checked.block) {
+                    pblock = std::move(checked.block);
+                } else if (const auto buffered{buffered_blocks.find(record.pos)}; buffered != buffered_blocks.end()) {
+                    pblock = read_block(buffered->second);
+                    buffered_size -= buffered->second.size();
+                    buffered_blocks.erase(buffered);
+                } else {
+                    // The block's parent was loaded since the block was read
+                    auto pblock_read{std::make_shared<CBlock>()};
+                    if (!dbp || !m_blockman.ReadBlockFromDisk(*pblock_read, *dbp)) {
+                        throw std::ios_base::failure("block data not available");
                     }
+                    pblock = std::move(pblock_read);
+                }
 
-                    // process in case the block isn't known yet
-                    const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
-                    if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                        // This block can be processed immediately; rewind to its start, read and deserialize it.
-                        blkdat.SetPos(nBlockPos);
-                        pblock = std::make_shared<CBlock>();
-                        blkdat >> *pblock;
-                        nRewind = blkdat.GetPos();
+                BlockValidationState state;
+                if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
+                    nLoaded++;
+                }
+                if (state.IsError()) {
+                    return false;
+                }
+            } else if (hash != params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+                LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+            }
+        }
 
-                        BlockValidationState state;
-                        if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
-                            nLoaded++;
-                        }
-                        if (state.IsError()) {
-                            break;
-                        }
-                    } else if (hash != params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
-                        LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
-                    }
+        // Activate the genesis block so normal node progress can continue
+        if (hash == params.GetConsensus().hashGenesisBlock) {
+            for (auto c : GetAll()) {
+                BlockValidationState state;
+                if (!c->ActivateBestChain(state, nullptr)) {
+                    return false;
                 }
+            }
+        }
 
-                // Activate the genesis block so normal node progress can continue
-                if (hash == params.GetConsensus().hashGenesisBlock) {
-                    bool genesis_activation_failure = false;
-                    for (auto c : GetAll()) {
-                        BlockValidationState state;
-                        if (!c->ActivateBestChain(state, nullptr)) {
-                            genesis_activation_failure = true;
-                            break;
-                        }
-                    }
-                    if (genesis_activation_failure) {
-                        break;
-                    }
+        if (m_blockman.IsPruneMode() && !fReindex && pblock) {
+            // must update the tip for pruning to work while importing with -loadblock.
+            // this is a tradeoff to conserve disk space at the expense of time
+            // spent updating the tip to be able to prune.
+            // otherwise, ActivateBestChain won't be called by the import process
+            // until after all of the block files are loaded. ActivateBestChain can be
+            // called by concurrent network message processing. but, that is not
+            // reliable for the purpose of pruning while importing.
+            for (auto c : GetAll()) {
+                BlockValidationState state;
+                if (!c->ActivateBestChain(state, pblock)) {
+                    LogPrint(BCLog::REINDEX, "failed to activate chain (%s)\n", state.ToString());
+                    return false;
                 }
+            }
+        }
 
-                if (m_blockman.IsPruneMode() && !fReindex && pblock) {
-                    // must update the tip for pruning to work while importing with -loadblock.
-                    // this is a tradeoff to conserve disk space at the expense of time
-                    // spent updating the tip to be able to prune.
-                    // otherwise, ActivateBestChain won't be called by the import process
-                    // until after all of the block files are loaded. ActivateBestChain can be
-                    // called by concurrent network message processing. but, that is not
-                    // reliable for the purpose of pruning while importing.
-                    bool activation_failure = false;
-                    for (auto c : GetAll()) {
-                        BlockValidationState state;
-                        if (!c->ActivateBestChain(state, pblock)) {
-                            LogPrint(BCLog::REINDEX, "failed to activate chain (%s)\n", state.ToString());
-                            activation_failure = true;
-                            break;
-                        }
+        NotifyHeaderTip(*this);
+
+        if (!blocks_with_unknown_parent) return true;
+
+        // Recursively process earlier encountered successors of this block
+        std::deque<uint256> queue;
+        queue.push_back(hash);
+        while (!queue.empty()) {
+            uint256 head = queue.front();
+            queue.pop_front();
+            auto range = blocks_with_unknown_parent->equal_range(head);
+            while (range.first != range.second) {
+                std::multimap<uint256, FlatFilePos>::iterator it = range.first;
+                std::shared_ptr<CBlock> pblockrecursive;
+                const auto buffered{it->second.nFile == dbp->nFile ? buffered_blocks.find(it->second.nPos) : buffered_blocks.end()};
+                if (buffered != buffered_blocks.end()) {
+                    try {
+                        pblockrecursive = read_block(buffered->second);
+                    } catch (const std::exception&) {
                     }
-                    if (activation_failure) {
-                        break;
+                    buffered_size -= buffered->second.size();
+                    buffered_blocks.erase(buffered);
+                } else {
+                    pblockrecursive = std::make_shared<CBlock>();
+                    if (!m_blockman.ReadBlockFromDisk(*pblockrecursive, it->second)) pblockrecursive.reset();
+                }
+                if (pblockrecursive) {
+                    LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", func, pblockrecursive->GetHash().ToString(),
+                            head.ToString());
+                    LOCK(cs_main);
+                    BlockValidationState dummy;
+                    if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
+                        nLoaded++;
+                        queue.push_back(pblockrecursive->GetHash());
                     }
                 }
-
+                range.first++;
+                blocks_with_unknown_parent->erase(it);
                 NotifyHeaderTip(*this);
+            }
+        }
+        return true;
+    }};
 
-                if (!blocks_with_unknown_parent) continue;
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    auto range = blocks_with_unknown_parent->equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (m_blockman.ReadBlockFromDisk(*pblockrecursive, it->second)) {
-                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        blocks_with_unknown_parent->erase(it);
-                        NotifyHeaderTip(*this);
+    try {
+        BufferedFile blkdat{file_in, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8};
+        // nRewind indicates where to resume scanning in case something goes wrong,
+        // such as a block fails to deserialize.
+        uint64_t nRewind = blkdat.GetPos();
+        std::vector<BlockRecord> records;
+        std::unordered_set<uint256, BlockHasher> batch_hashes;
+        bool end_of_file{false};
+        bool stop{false};
+        while (!end_of_file && !stop) {
+            // Read a batch of blocks. The blocks expected to be loaded are
+            // deserialized and checked on several threads, and all blocks are
+            // then loaded in file order.
+            records.clear();
+            batch_hashes.clear();
+            size_t batch_size{0};
+            while (batch_size < BLOCK_IMPORT_BATCH_SIZE) {
+                if (m_interrupt) return;
+                if (blkdat.eof()) {
+                    end_of_file = true;
+                    break;
+                }
+
+                blkdat.SetPos(nRewind);
+                nRewind++; // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try {
+                    // locate a header
+                    MessageStartChars buf;
+                    blkdat.FindByte(std::byte(params.MessageStart()[0]));
+                    nRewind = blkdat.GetPos() + 1;
+                    blkdat >> buf;
+                    if (buf != params.MessageStart()) {
+                        continue;
+                    }
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                        continue;
+                } catch (const std::exception&) {
+                    // no valid block header found; don't complain
+                    // (this happens at the end of every blk.dat file)
+                    end_of_file = true;
+                    break;
+                }
+                try {
+                    // read block header
+                    const uint64_t nBlockPos{blkdat.GetPos()};
+                    blkdat.SetLimit(nBlockPos + nSize);
+                    BlockRecord record;
+                    record.pos = nBlockPos;
+                    record.size = nSize;
+                    blkdat >> record.header;
+                    record.hash = record.header.GetHash();
+                    nRewind = nBlockPos + nSize;
+
+                    // Blocks that are already known or don't connect to the
+                    // block index (or to a block of this batch) aren't read
+                    // and checked ahead.
+                    bool connects;
+                    {
+                        LOCK(cs_main);
+                        connects = record.hash == params.GetConsensus().hashGenesisBlock ||
+                                   m_blockman.LookupBlockIndex(record.header.hashPrevBlock) ||
+                                   batch_hashes.count(record.header.hashPrevBlock);
+                        const CBlockIndex* pindex{m_blockman.LookupBlockIndex(record.hash)};
+                        record.check = connects && (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0);
+                    }
+                    blkdat.SetPos(nBlockPos);
+                    if (record.check) {
+                        record.offset = batch_size;
+                        if (batch_data.size() < batch_size + nSize) batch_data.resize(batch_size + nSize);
+                        blkdat.read(AsWritableBytes(Span{batch_data}.subspan(batch_size, nSize)));
+                        batch_hashes.insert(record.hash);
+                        batch_size += nSize;
+                    } else if (!connects && dbp && buffered_size + nSize <= MAX_BLOCK_IMPORT_BUFFER_SIZE) {
+                        std::vector<unsigned char> data(nSize);
+                        blkdat.read(AsWritableBytes(Span{data}));
+                        buffered_blocks.emplace(nBlockPos, std::move(data));
+                        buffered_size += nSize;
+                    } else {
+                        // Skip the rest of this block (this may read from disk into memory); position to the marker before the
+                        // next block, but it's still possible to rewind to the start of the current block (without a disk read).
+                        blkdat.SkipTo(nRewind);
                     }
+                    records.push_back(std::move(record));
+                } catch (const std::exception& e) {
+                    LogPrint(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
                 }
-            } catch (const std::exception& e) {
-                // historical bugs added extra data to the block files that does not deserialize cleanly.
-                // commonly this data is between readable blocks, but it does not really matter. such data is not fatal to the import process.
-                // the code that reads the block files deals with invalid data by simply ignoring it.
-                // it continues to search for the next {4 byte magic message start bytes + 4 byte length + block} that does deserialize cleanly
-                // and passes all of the other block validation checks dealing with POW and the merkle root, etc...
-                // we merely note with this informational log message when unexpected data is encountered.
-                // we could also be experiencing a storage system read error, or a read of a previous bad write. these are possible, but
-                // less likely scenarios. we don't have enough information to tell a difference here.
-                // the reindex process is not the place to attempt to clean and/or compact the block files. if so desired, a studious node operator
-                // may use knowledge of the fact that the block files are not entirely pristine in order to prepare a set of pristine, and
-                // perhaps ordered, block files for later reindexing.
-                LogPrint(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
             }
+
+            size_t next_record{0};
+            util::ParallelForOrdered(
+                "loadblk", records.size(), num_threads,
+                [&](size_t i) {
+                    CheckedBlock checked;
+                    const BlockRecord& record{records[i]};
+                    if (!record.check) return checked;
+                    try {
+                        auto pblock{read_block(Span{batch_data}.subspan(record.offset, record.size))};
+                        // Sets fChecked, so that AcceptBlock doesn't check the block again
+                        BlockValidationState state;
+                        CheckBlock(*pblock, state, params.GetConsensus());
+                        checked.block = std::move(pblock);
+                    } catch (const std::exception& e) {
+                        checked.error = e.what();
+                    }
+                    return checked;
+                },
+                [&](CheckedBlock checked) {
+                    const BlockRecord& record{records[next_record++]};
+                    if (stop || m_interrupt) {
+                        stop = true;
+                        return;
+                    }
+                    if (dbp) dbp->nPos = record.pos;
+                    try {
+                        stop = !load_block(record, checked);
+                    } catch (const std::exception& e) {
+                        // historical bugs added extra data to the block files that does not deserialize cleanly.
+                        // commonly this data is between readable blocks, but it does not really matter. such data is not fatal to the import process.
+                        // the code that reads the block files deals with invalid data by simply ignoring it.
+                        // it continues to search for the next {4 byte magic message start bytes + 4 byte length + block} that does deserialize cleanly
+                        // and passes all of the other block validation checks dealing with POW and the merkle root, etc...
+                        // we merely note with this informational log message when unexpected data is encountered.
+                        // we could also be experiencing a storage system read error, or a read of a previous bad write. these are possible, but
+                        // less likely scenarios. we don't have enough information to tell a difference here.
+                        // the reindex process is not the place to attempt to clean and/or compact the block files. if so desired, a studious node operator
+                        // may use knowledge of the fact that the block files are not entirely pristine in order to prepare a set of pristine, and
+                        // perhaps ordered, block files for later reindexing.
+                        LogPrint(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", func, record.pos, e.what());
+                    }
+                });
+            if (m_interrupt) return;
         }
     } catch (const std::runtime_error& e) {
         GetNotifications().fatalError(std::string("System error: ") + e.what());
@@ -5411,62 +5784,74 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     uint64_t coins_left = metadata.m_coins_count;
 
     LogPrintf("[snapshot] loading coins from snapshot %s\n", base_blockhash.ToString());
-    int64_t coins_processed{0};
 
-    while (coins_left > 0) {
-        try {
-            coins_file >> outpoint;
-            coins_file >> coin;
-        } catch (const std::ios_base::failure&) {
-            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-        if (coin.nHeight > base_height ||
-            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
-        ) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-        if (!MoneyRange(coin.out.nValue)) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - bad tx out value\n",
-                      coins_count - coins_left);
+    if (metadata.m_partitioned) {
+        // The partitions are loaded straight into the coins database by
+        // several threads, each sized a share of the coins cache.
+        CCoinsViewDB& coins_db = *WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+        if (!node::LoadSnapshotPartitions(coins_db, coins_file, metadata, base_height,
+                                          snapshot_chainstate.m_coinstip_cache_size_bytes,
+                                          node::SnapshotThreads(), m_interrupt)) {
             return false;
         }
+    } else {
+        int64_t coins_processed{0};
 
-        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
+        while (coins_left > 0) {
+            try {
+                coins_file >> outpoint;
+                coins_file >> coin;
+            } catch (const std::ios_base::failure&) {
+                LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                          coins_count - coins_left);
+                return false;
+            }
+            if (coin.nHeight > base_height ||
+                outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+            ) {
+                LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
+                          coins_count - coins_left);
+                return false;
+            }
+            if (!MoneyRange(coin.out.nValue)) {
+                LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - bad tx out value\n",
+                          coins_count - coins_left);
+                return false;
+            }
 
-        --coins_left;
-        ++coins_processed;
+            coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
 
-        if (coins_processed % 1000000 == 0) {
-            LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
-                coins_processed,
-                static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
-                coins_cache.DynamicMemoryUsage() / (1000 * 1000));
-        }
+            --coins_left;
+            ++coins_processed;
 
-        // Batch write and flush (if we need to) every so often.
-        //
-        // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
-        // means <5MB of memory imprecision.
-        if (coins_processed % 120000 == 0) {
-            if (m_interrupt) {
-                return false;
+            if (coins_processed % 1000000 == 0) {
+                LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
+                    coins_processed,
+                    static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
+                    coins_cache.DynamicMemoryUsage() / (1000 * 1000));
             }
 
-            const auto snapshot_cache_state = WITH_LOCK(::cs_main,
-                return snapshot_chainstate.GetCoinsCacheSizeState());
+            // Batch write and flush (if we need to) every so often.
+            //
+            // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
+            // means <5MB of memory imprecision.
+            if (coins_processed % 120000 == 0) {
+                if (m_interrupt) {
+                    return false;
+                }
+
+                const auto snapshot_cache_state = WITH_LOCK(::cs_main,
+                    return snapshot_chainstate.GetCoinsCacheSizeState());
 
-            if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
-                // This is a hack - we don't know what the actual best block is, but that
-                // doesn't matter for the purposes of flushing the cache here. We'll set this
-                // to its correct value (`base_blockhash`) below after the coins are loaded.
-                coins_cache.SetBestBlock(GetRandHash());
+                if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
+                    // This is a hack - we don't know what the actual best block is, but that
+                    // doesn't matter for the purposes of flushing the cache here. We'll set this
+                    // to its correct value (`base_blockhash`) below after the coins are loaded.
+                    coins_cache.SetBestBlock(GetRandHash());
 
-                // No need to acquire cs_main since this chainstate isn't being used yet.
-                FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
+                    // No need to acquire cs_main since this chainstate isn't being used yet.
+                    FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
+                }
             }
         }
     }
@@ -5509,7 +5894,8 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     try {
         maybe_stats = ComputeUTXOStats(
-            CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, [&interrupt = m_interrupt] { SnapshotUTXOHashBreakpoint(interrupt); });
+            CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, [&interrupt = m_interrupt] { SnapshotUTXOHashBreakpoint(interrupt); },
+            node::SnapshotThreads());
     } catch (StopHashingException const&) {
         return false;
     }
@@ -5766,14 +6152,93 @@ void ChainstateManager::MaybeRebalanceCaches()
             m_snapshot_chainstate->ResizeCoinsCaches(
                 m_total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
         } else {
+            // Once the snapshot chainstate follows the tip, it gets the share
+            // of the caches it needs to connect new blocks in time.
+            const double tip_share{m_background_validation_scheduler.GetTipCacheShare()};
             m_snapshot_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.05, m_total_coinsdb_cache * 0.05);
+                m_total_coinstip_cache * tip_share, m_total_coinsdb_cache * tip_share);
             m_ibd_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
+                m_total_coinstip_cache * (1 - tip_share), m_total_coinsdb_cache * (1 - tip_share));
         }
     }
 }
 
+bool BackgroundValidationScheduler::AddTipLatency(std::chrono::milliseconds latency)
+{
+    m_tip_latency = latency;
+    const double tip_cache_share{m_tip_cache_share};
+    if (latency > m_target) {
+        if (m_duty_cycle > MIN_BACKGROUND_VALIDATION_DUTY) {
+            m_duty_cycle = std::max(m_duty_cycle / 2, MIN_BACKGROUND_VALIDATION_DUTY);
+        } else {
+            m_tip_cache_share = std::min(m_tip_cache_share * 2, MAX_TIP_CACHE_SHARE);
+        }
+    } else if (latency < m_target / 2) {
+        if (m_duty_cycle < 1) {
+            m_duty_cycle = std::min(m_duty_cycle * 2, 1.0);
+        } else {
+            m_tip_cache_share = std::max(m_tip_cache_share / 2, MIN_TIP_CACHE_SHARE);
+        }
+    }
+    return m_tip_cache_share != tip_cache_share;
+}
+
+std::chrono::microseconds BackgroundValidationScheduler::GetPause(std::chrono::microseconds elapsed) const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed * ((1 - m_duty_cycle) / m_duty_cycle));
+}
+
+void ChainstateManager::StartBackgroundValidation()
+{
+    assert(!m_thread_background_validation.joinable());
+    WITH_LOCK(m_background_validation_mutex, m_stop_background_validation = false);
+    m_thread_background_validation = std::thread(&util::TraceThread, "bgvalidation", [this] { ThreadBackgroundValidation(); });
+}
+
+void ChainstateManager::StopBackgroundValidation()
+{
+    if (!m_thread_background_validation.joinable()) return;
+    WITH_LOCK(m_background_validation_mutex, m_stop_background_validation = true);
+    m_background_validation_cv.notify_all();
+    m_thread_background_validation.join();
+}
+
+void ChainstateManager::ThreadBackgroundValidation()
+{
+    while (true) {
+        {
+            WAIT_LOCK(m_background_validation_mutex, lock);
+            m_background_validation_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_background_validation_mutex) {
+                return m_stop_background_validation || m_background_validation_pending;
+            });
+            if (m_stop_background_validation) return;
+            m_background_validation_pending = false;
+        }
+
+        Chainstate* bg_chain{WITH_LOCK(::cs_main, return BackgroundSyncInProgress() ? m_ibd_chainstate.get() : nullptr)};
+        if (!bg_chain) continue;
+
+        const auto time_start{SteadyClock::now()};
+        BlockValidationState state;
+        if (!bg_chain->ActivateBestChain(state, nullptr, time_start + BACKGROUND_VALIDATION_SLICE)) {
+            LogPrintf("[background validation] ActivateBestChain failed (%s)\n", state.ToString());
+            continue;
+        }
+        const auto elapsed{SteadyClock::now() - time_start};
+        // Background validation caught up with the blocks that are available.
+        if (elapsed < BACKGROUND_VALIDATION_SLICE) continue;
+
+        // There may be more blocks to connect, after a pause that leaves the
+        // scheduled share of the time to the active chainstate.
+        const auto pause{WITH_LOCK(::cs_main, return m_background_validation_scheduler.GetPause(std::chrono::duration_cast<std::chrono::microseconds>(elapsed)))};
+        WAIT_LOCK(m_background_validation_mutex, lock);
+        m_background_validation_pending = true;
+        m_background_validation_cv.wait_for(lock, pause, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_background_validation_mutex) {
+            return m_stop_background_validation;
+        });
+    }
+}
+
 void ChainstateManager::ResetChainstates()
 {
     m_ibd_chainstate.reset();
@@ -5796,14 +6261,22 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 }
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
-    : m_interrupt{interrupt},
+    : m_background_validation_scheduler{options.background_validation_latency},
+      m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)} {}
 
 ChainstateManager::~ChainstateManager()
 {
+    StopBackgroundValidation();
+
     LOCK(::cs_main);
 
+    // Block prefetch threads read from m_blockman, which is destroyed first
+    for (Chainstate* chainstate : {m_ibd_chainstate.get(), m_snapshot_chainstate.get()}) {
+        if (chainstate) chainstate->m_block_prefetcher.Stop();
+    }
+
     m_versionbitscache.Clear();
 }
 
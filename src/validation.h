@@ -19,6 +19,7 @@
 #include <kernel/chainparams.h>
 #include <kernel/chainstatemanager_opts.h>
 #include <kernel/cs_main.h> // IWYU pragma: export
+#include <node/blockprefetch.h>
 #include <node/blockstorage.h>
 #include <policy/feerate.h>
 #include <policy/packages.h>
@@ -32,10 +33,13 @@
 #include <util/fs.h>
 #include <util/hasher.h>
 #include <util/result.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <versionbits.h>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
 #include <memory>
 #include <optional>
@@ -538,6 +542,9 @@ public:
     //! chainstate within deeply nested method calls.
     ChainstateManager& m_chainman;
 
+    //! Reads the blocks to connect next ahead of ConnectTip.
+    node::BlockPrefetcher m_block_prefetcher;
+
     explicit Chainstate(
         CTxMemPool* mempool,
         node::BlockManager& blockman,
@@ -688,22 +695,31 @@ public:
      * background UTXO set to verify the assumeutxo value the snapshot was activated
      * with. `cs_main` will be held during this time.
      *
+     * If a deadline is given, return once it has passed, even if the best
+     * block has not been made active yet.
+     *
      * @returns true unless a system error occurred
      */
     bool ActivateBestChain(
         BlockValidationState& state,
-        std::shared_ptr<const CBlock> pblock = nullptr)
+        std::shared_ptr<const CBlock> pblock = nullptr,
+        std::optional<SteadyClock::time_point> deadline = std::nullopt)
         EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex)
         LOCKS_EXCLUDED(::cs_main);
 
     // Block (dis)connection on a given view:
     DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    //! Disconnect a block whose undo data was already read
+    DisconnectResult DisconnectBlock(const CBlock& block, CBlockUndo blockUndo, const CBlockIndex* pindex, CCoinsViewCache& view)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
                       CCoinsViewCache& view, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Apply the effects of a block disconnection on the UTXO set.
     bool DisconnectTip(BlockValidationState& state, DisconnectedBlockTransactions* disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    //! Disconnect blocks down to pindex_fork, reading them ahead on several threads
+    bool DisconnectTips(BlockValidationState& state, const CBlockIndex* pindex_fork, DisconnectedBlockTransactions* disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
 
     // Manual block validity manipulation:
     /** Mark a block as precious and reorganize.
@@ -853,6 +869,65 @@ enum class SnapshotCompletionResult {
  *    IBD process is happening in the background while use of the
  *    active (snapshot) chainstate allows the rest of the system to function.
  */
+class ChainstateManager;
+
+/** Time background validation runs for before it is paused, if it's throttled. */
+static constexpr auto BACKGROUND_VALIDATION_SLICE{500ms};
+/** Lowest share of the time given to background validation. */
+static constexpr double MIN_BACKGROUND_VALIDATION_DUTY{1.0 / 16};
+/** Bounds of the share of the coins caches given to the snapshot chainstate
+ *  while it follows the tip and background validation is in progress. */
+static constexpr double MIN_TIP_CACHE_SHARE{0.05};
+static constexpr double MAX_TIP_CACHE_SHARE{0.5};
+
+/**
+ * Divides time and the coins caches between the snapshot chainstate following
+ * the tip and the background chainstate validating the chain up to the
+ * snapshot, so that new blocks are connected within a target latency.
+ *
+ * Background validation runs for a share of the time, its duty cycle, which is
+ * halved whenever a new block takes longer than the target to connect, and
+ * doubled whenever one takes less than half of it. Once the duty cycle is at its
+ * minimum, a missed target doubles the share of the coins caches of the
+ * snapshot chainstate instead, which is halved again when the target is met
+ * with background validation running full time.
+ *
+ * Blocks of both chainstates are connected one at a time under cs_main, so the
+ * script verification threads are divided between them by the duty cycle.
+ */
+class BackgroundValidationScheduler
+{
+public:
+    explicit BackgroundValidationScheduler(std::chrono::milliseconds target) : m_target{target} {}
+
+    //! Account for the time a new block took to connect to the active chainstate.
+    //! @returns whether the share of the coins caches of the active chainstate changed.
+    bool AddTipLatency(std::chrono::milliseconds latency);
+
+    //! How long to pause background validation for after it ran for `elapsed`.
+    std::chrono::microseconds GetPause(std::chrono::microseconds elapsed) const;
+
+    double GetDutyCycle() const { return m_duty_cycle; }
+    double GetTipCacheShare() const { return m_tip_cache_share; }
+    std::chrono::milliseconds GetTipLatency() const { return m_tip_latency; }
+
+private:
+    const std::chrono::milliseconds m_target;
+    double m_duty_cycle{1.0};
+    double m_tip_cache_share{MIN_TIP_CACHE_SHARE};
+    //! Time the last new block took to connect.
+    std::chrono::milliseconds m_tip_latency{0};
+};
+
+/** Progress of the background validation of the chain up to a snapshot. */
+struct BackgroundValidationStats {
+    //! Blocks and transaction inputs connected by the background chainstate.
+    uint64_t blocks{0};
+    uint64_t inputs{0};
+    //! When the background chainstate connected its first block.
+    std::optional<SteadyClock::time_point> start;
+};
+
 class ChainstateManager
 {
 private:
@@ -926,6 +1001,20 @@ private:
         return cs && !cs->m_disabled;
     }
 
+    BackgroundValidationScheduler m_background_validation_scheduler GUARDED_BY(::cs_main);
+    BackgroundValidationStats m_background_validation_stats GUARDED_BY(::cs_main);
+
+    //! Thread connecting the blocks of the background chainstate, see
+    //! StartBackgroundValidation().
+    std::thread m_thread_background_validation;
+    Mutex m_background_validation_mutex;
+    std::condition_variable m_background_validation_cv;
+    //! Whether the background chainstate may have blocks to connect.
+    bool m_background_validation_pending GUARDED_BY(m_background_validation_mutex){true};
+    bool m_stop_background_validation GUARDED_BY(m_background_validation_mutex){false};
+
+    void ThreadBackgroundValidation() EXCLUSIVE_LOCKS_REQUIRED(!m_background_validation_mutex);
+
 public:
     using Options = kernel::ChainstateManagerOpts;
 
@@ -1129,6 +1218,10 @@ public:
      * This function can also be used to read blocks from user-specified block files using the
      * -loadblock= option. There's no unknown-parent tracking, so the last two arguments are omitted.
      *
+     * Blocks are read in batches. Those expected to be loaded are deserialized and checked
+     * (CheckBlock) on several threads, and all are then loaded in file order. During reindexing,
+     * out of order blocks are kept in memory, up to a limit, until their parent is loaded.
+     *
      *
      * @param[in]     file_in                       File containing blocks to read
      * @param[in]     dbp                           (optional) Disk block position (only for reindex)
@@ -1165,7 +1258,8 @@ public:
      * @param[out]  new_block A boolean which is set to indicate if the block was first received via this call
      * @returns     If the block was processed, independently of block validity
      */
-    bool ProcessNewBlock(const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked, bool* new_block) LOCKS_EXCLUDED(cs_main);
+    bool ProcessNewBlock(const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked, bool* new_block) LOCKS_EXCLUDED(cs_main)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_background_validation_mutex);
 
     /**
      * Process incoming block headers.
@@ -1219,6 +1313,21 @@ public:
     //! ResizeCoinsCaches() as needed.
     void MaybeRebalanceCaches() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    //! Connect the blocks of the background chainstate on a dedicated thread,
+    //! throttled by the BackgroundValidationScheduler, instead of in
+    //! ProcessNewBlock() after the blocks of the active chainstate.
+    void StartBackgroundValidation() EXCLUSIVE_LOCKS_REQUIRED(!m_background_validation_mutex);
+    void StopBackgroundValidation() EXCLUSIVE_LOCKS_REQUIRED(!m_background_validation_mutex);
+
+    const BackgroundValidationScheduler& GetBackgroundValidationScheduler() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        return m_background_validation_scheduler;
+    }
+    const BackgroundValidationStats& GetBackgroundValidationStats() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        return m_background_validation_stats;
+    }
+
     /** Update uncommitted block structures (currently: only the witness reserved value). This is safe for submitted blocks. */
     void UpdateUncommittedBlockStructures(CBlock& block, const CBlockIndex* pindexPrev) const;
 
@@ -1276,7 +1385,7 @@ public:
     //! nullopt.
     std::optional<int> GetSnapshotBaseHeight() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
-    ~ChainstateManager();
+    ~ChainstateManager() EXCLUSIVE_LOCKS_REQUIRED(!m_background_validation_mutex);
 };
 
 /** Deployment* info via ChainstateManager */
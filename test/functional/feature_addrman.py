@@ -165,6 +165,40 @@ class AddrmanTest(BitcoinTestFramework):
             self.start_node(0)
         assert_equal(self.nodes[0].getnodeaddresses(), [])
 
+        self.log.info("Check that changes are appended to peers.journal with -peersjournal")
+        peers_journal = os.path.join(self.nodes[0].chain_path, "peers.journal")
+        self.restart_node(0, extra_args=["-peersjournal"])
+        self.nodes[0].addpeeraddress(address="1.2.3.4", port=8333)
+        # The first flush rewrites peers.dat and starts a journal on top of it
+        self.restart_node(0, extra_args=["-peersjournal"])
+        assert os.path.exists(peers_journal)
+        peers_dat_mtime = os.path.getmtime(peers_dat)
+        self.nodes[0].addpeeraddress(address="1.2.3.5", port=8333, tried=True)
+        self.stop_node(0)
+        # The change is appended to the journal, peers.dat is left untouched
+        assert_equal(os.path.getmtime(peers_dat), peers_dat_mtime)
+        with self.nodes[0].assert_debug_log(["Loaded 2 addresses from peers.dat and 1 records from peers.journal"]):
+            self.start_node(0, extra_args=["-peersjournal", "-checkaddrman=1"])
+        assert_equal(len(self.nodes[0].getnodeaddresses(count=0)), 2)
+
+        self.log.info("Check that a torn record at the end of peers.journal is ignored")
+        self.nodes[0].addpeeraddress(address="1.2.3.6", port=8333)
+        self.stop_node(0)
+        with open(peers_journal, "ab") as f:
+            f.write(b"\x20torn")
+        with self.nodes[0].assert_debug_log(["Ignoring incomplete record at the end of"]):
+            self.start_node(0, extra_args=["-peersjournal", "-checkaddrman=1"])
+        assert_equal(len(self.nodes[0].getnodeaddresses(count=0)), 3)
+
+        self.log.info("Check that peers.journal is removed without -peersjournal")
+        # The journal is still replayed, and removed on the next flush
+        self.restart_node(0)
+        assert_equal(len(self.nodes[0].getnodeaddresses(count=0)), 3)
+        self.stop_node(0)
+        assert not os.path.exists(peers_journal)
+        self.start_node(0)
+        assert_equal(len(self.nodes[0].getnodeaddresses(count=0)), 3)
+
 
 if __name__ == "__main__":
     AddrmanTest().main()
@@ -46,6 +46,13 @@ SNAPSHOT_BASE_HEIGHT = 299
 FINAL_HEIGHT = 399
 COMPLETE_IDX = {'synced': True, 'best_block_height': FINAL_HEIGHT}
 
+# Layout of a partitioned snapshot: magic bytes and version, base block hash,
+# coins count, then partitions, each a header followed by its coins.
+BLOCK_HASH_OFFSET = 5 + 2
+COINS_COUNT_OFFSET = BLOCK_HASH_OFFSET + 32
+COINS_OFFSET = COINS_COUNT_OFFSET + 8
+PARTITION_HEADER_SIZE = 4 + 4
+
 
 class AssumeutxoTest(BitcoinTestFramework):
 
@@ -80,18 +87,18 @@ class AssumeutxoTest(BitcoinTestFramework):
         bogus_block_hash = "0" * 64  # Represents any unknown block hash
         for bad_block_hash in [bogus_block_hash, prev_block_hash]:
             with open(bad_snapshot_path, 'wb') as f:
-                # block hash of the snapshot base is stored right at the start (first 32 bytes)
-                f.write(bytes.fromhex(bad_block_hash)[::-1] + valid_snapshot_contents[32:])
+                # block hash of the snapshot base is stored right after the magic bytes and version
+                f.write(valid_snapshot_contents[:BLOCK_HASH_OFFSET] + bytes.fromhex(bad_block_hash)[::-1] + valid_snapshot_contents[COINS_COUNT_OFFSET:])
             error_details = f", assumeutxo block hash in snapshot metadata not recognized ({bad_block_hash})"
             expected_error(rpc_details=error_details)
 
         self.log.info("  - snapshot file with wrong number of coins")
-        valid_num_coins = int.from_bytes(valid_snapshot_contents[32:32 + 8], "little")
+        valid_num_coins = int.from_bytes(valid_snapshot_contents[COINS_COUNT_OFFSET:COINS_OFFSET], "little")
         for off in [-1, +1]:
             with open(bad_snapshot_path, 'wb') as f:
-                f.write(valid_snapshot_contents[:32])
+                f.write(valid_snapshot_contents[:COINS_COUNT_OFFSET])
                 f.write((valid_num_coins + off).to_bytes(8, "little"))
-                f.write(valid_snapshot_contents[32 + 8:])
+                f.write(valid_snapshot_contents[COINS_OFFSET:])
             expected_error(log_msg=f"bad snapshot - coins left over after deserializing 298 coins" if off == -1 else f"bad snapshot format or truncated snapshot after deserializing 299 coins")
 
         self.log.info("  - snapshot file with alternated UTXO data")
@@ -102,11 +109,13 @@ class AssumeutxoTest(BitcoinTestFramework):
             [b"\x83", 36, "e4577da84590fb288c0f7967e89575e1b0aa46624669640f6f5dfef028d39930"], # another wrong coin code
         ]
 
+        # The first coin follows the header of the first partition
+        first_coin_offset = COINS_OFFSET + PARTITION_HEADER_SIZE
         for content, offset, wrong_hash in cases:
             with open(bad_snapshot_path, "wb") as f:
-                f.write(valid_snapshot_contents[:(32 + 8 + offset)])
+                f.write(valid_snapshot_contents[:(first_coin_offset + offset)])
                 f.write(content)
-                f.write(valid_snapshot_contents[(32 + 8 + offset + len(content)):])
+                f.write(valid_snapshot_contents[(first_coin_offset + offset + len(content)):])
             expected_error(log_msg=f"[snapshot] bad snapshot content hash: expected 61d9c2b29a2571a5fe285fe2d8554f91f93309666fc9b8223ee96338de25ff53, got {wrong_hash}")
 
     def test_invalid_chainstate_scenarios(self):
@@ -199,6 +208,14 @@ class AssumeutxoTest(BitcoinTestFramework):
         assert_equal(snapshot['snapshot_blockhash'], dump_output['base_hash'])
         assert_equal(snapshot['validated'], False)
 
+        self.log.info("Check the background validation progress")
+        assert 'background_validation' not in snapshot
+        background = normal['background_validation']
+        assert_equal(set(background), {'blocks_per_second', 'inputs_per_second', 'cache_hit_rate', 'duty_cycle', 'tip_latency'})
+        assert_equal(background['blocks_per_second'], 0)
+        assert_equal(background['duty_cycle'], 1)
+        assert 0 <= background['cache_hit_rate'] <= 1
+
         assert_equal(n1.getblockchaininfo()["blocks"], SNAPSHOT_BASE_HEIGHT)
 
         PAUSE_HEIGHT = FINAL_HEIGHT - 40
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test compression of finalized block files with -blockcompression."""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class FeatureBlockCompressionTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [["-fastprune", "-blockcompression"]]
+
+    def check_blocks(self, node, hashes):
+        for height, block_hash in enumerate(hashes):
+            block = node.getblock(block_hash, 0)
+            assert_equal(node.getblock(block_hash)["height"], height)
+            assert_equal(len(block) // 2, node.getblock(block_hash)["size"])
+
+    def run_test(self):
+        node = self.nodes[0]
+        blk0 = node.blocks_path / "blk00000.dat"
+        blz0 = node.blocks_path / "blz00000.dat"
+
+        self.log.info("Fill more than one block file")
+        self.generate(node, 250)
+        self.generate(node, 250)
+        hashes = [node.getblockhash(height) for height in range(node.getblockcount() + 1)]
+
+        self.log.info("The finalized block file is replaced by a compressed file")
+        self.wait_until(lambda: os.path.exists(blz0) and not os.path.exists(blk0))
+        # The block file being written to is not compressed
+        assert any(path.name.startswith("blk") for path in node.blocks_path.iterdir())
+        assert os.path.getsize(blz0) < 0x10000
+        self.check_blocks(node, hashes)
+
+        self.log.info("Compressed files are used after a restart, even without -blockcompression")
+        self.restart_node(0, extra_args=["-fastprune"])
+        assert os.path.exists(blz0)
+        self.check_blocks(node, hashes)
+
+        self.log.info("Reindexing restores the block files")
+        self.restart_node(0, extra_args=["-fastprune", "-reindex"])
+        self.wait_until(lambda: node.getblockcount() == len(hashes) - 1)
+        assert os.path.exists(blk0)
+        assert not os.path.exists(blz0)
+        self.check_blocks(node, hashes)
+
+
+if __name__ == '__main__':
+    FeatureBlockCompressionTest().main()
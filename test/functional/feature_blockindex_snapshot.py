@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the block index snapshot written on shutdown and loaded on startup."""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class FeatureBlockIndexSnapshotTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+
+    def run_test(self):
+        node = self.nodes[0]
+        snapshot = node.blocks_path / "blockindex.dat"
+        self.generate(node, 10)
+        best_hash = node.getbestblockhash()
+        block_count = node.getblockcount()
+
+        self.log.info("The block index is loaded from the snapshot written on shutdown")
+        self.stop_node(0)
+        assert os.path.exists(snapshot)
+        with node.assert_debug_log([f"Loaded {block_count + 1} block index entries from snapshot"]):
+            self.start_node(0)
+        assert not os.path.exists(snapshot)
+        assert_equal(node.getbestblockhash(), best_hash)
+        self.generate(node, 1)
+        best_hash = node.getbestblockhash()
+
+        self.log.info("A snapshot that doesn't match the database is ignored")
+        self.stop_node(0)
+        with open(snapshot, "rb") as f:
+            stale_snapshot = f.read()
+        self.start_node(0)
+        self.generate(node, 1)
+        best_hash = node.getbestblockhash()
+        self.stop_node(0)
+        with open(snapshot, "wb") as f:
+            f.write(stale_snapshot)
+        with node.assert_debug_log(["Ignoring block index snapshot"]):
+            self.start_node(0)
+        assert_equal(node.getbestblockhash(), best_hash)
+
+        self.log.info("A corrupted snapshot is ignored")
+        self.stop_node(0)
+        with open(snapshot, "r+b") as f:
+            f.seek(100)
+            byte = f.read(1)
+            f.seek(100)
+            f.write(bytes([byte[0] ^ 1]))
+        with node.assert_debug_log(["Ignoring block index snapshot: checksum mismatch"]):
+            self.start_node(0)
+        assert_equal(node.getbestblockhash(), best_hash)
+
+
+if __name__ == '__main__':
+    FeatureBlockIndexSnapshotTest().main()
@@ -140,6 +140,9 @@ class InitStressTest(BitcoinTestFramework):
                     # in blk*.dat is affected.
                     tf.seek(randint (150, 15000))
                     tf.write(b'1' * randint(20, 2000))
+            # The block index snapshot written on shutdown would be loaded
+            # instead of the perturbed block index database.
+            (node.chain_path / "blocks" / "blockindex.dat").unlink(missing_ok=True)
 
             start_expecting_error(err_fragment)
 
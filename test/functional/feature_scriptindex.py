@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the script index and the getscripthistory RPC and /rest/scripthistory/ endpoint.
+
+Check that the outputs and spends of a scriptPubKey are returned in chain
+order, that pagination through the returned cursor gives the same history
+over RPC and REST, and that reorganized blocks are removed from the history.
+"""
+
+import http.client
+import json
+import urllib.parse
+from decimal import Decimal
+
+from test_framework.messages import COIN
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+from test_framework.wallet import (
+    MiniWallet,
+    MiniWalletMode,
+)
+
+NUM_OUTPUTS = 25
+
+
+class ScriptIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [["-scriptindex", "-rest"], []]
+
+    def rest_history(self, script_hex, status=200, **query):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        uri = f"/rest/scripthistory/{script_hex}.json"
+        if query:
+            uri += f"?{urllib.parse.urlencode(query)}"
+        conn.request("GET", uri)
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        body = resp.read().decode("utf-8")
+        return json.loads(body, parse_float=Decimal) if status == 200 else body
+
+    def rpc_pages(self, script_hex, count):
+        outputs = []
+        result = self.nodes[0].getscripthistory(script_hex, count)
+        while True:
+            assert len(result["outputs"]) <= count
+            outputs += result["outputs"]
+            if "next_cursor" not in result:
+                return outputs
+            result = self.nodes[0].getscripthistory(script_hex, count, result["next_cursor"])
+
+    def rest_pages(self, script_hex, count):
+        outputs = []
+        result = self.rest_history(script_hex, count=count)
+        while True:
+            outputs += result["outputs"]
+            if "next_cursor" not in result:
+                return outputs
+            result = self.rest_history(script_hex, count=count, cursor=result["next_cursor"])
+
+    def run_test(self):
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+        target = MiniWallet(node, mode=MiniWalletMode.RAW_P2PK)
+
+        self.log.info("Check that the index is not available without -scriptindex")
+        assert_raises_rpc_error(-1, "Requires -scriptindex", self.nodes[1].getscripthistory, "51")
+
+        self.log.info("Fund a scriptPubKey across several blocks")
+        script = target.get_scriptPubKey()
+        script_hex = script.hex()
+        funding = []
+        for i in range(NUM_OUTPUTS):
+            funding.append(wallet.send_to(from_node=node, scriptPubKey=script, amount=(i + 1) * 100000))
+            if i % 5 == 4:
+                self.generate(node, 1)
+
+        self.log.info("Check the history in chain order")
+        self.wait_until(lambda: node.getindexinfo("scriptindex")["scriptindex"]["synced"])
+        history = self.rpc_pages(script_hex, NUM_OUTPUTS)
+        assert_equal(len(history), NUM_OUTPUTS)
+        assert_equal(sorted(output["txid"] for output in history), sorted(sent["txid"] for sent in funding))
+        for output in history:
+            sent = next(sent for sent in funding if sent["txid"] == output["txid"])
+            assert_equal(output["vout"], sent["sent_vout"])
+            assert_equal(output["amount"], Decimal(sent["tx"].vout[sent["sent_vout"]].nValue) / COIN)
+            assert "spent" not in output
+        positions = [(output["height"], node.getblock(node.getblockhash(output["height"]))["tx"].index(output["txid"])) for output in history]
+        assert_equal(positions, sorted(positions))
+
+        self.log.info("Check pagination over RPC and REST")
+        for count in [1, 7, NUM_OUTPUTS, 1000]:
+            assert_equal(self.rpc_pages(script_hex, count), history)
+            assert_equal(self.rest_pages(script_hex, count), history)
+        cursor = node.getscripthistory(script_hex, 7)["next_cursor"]
+        assert_equal(node.getscripthistory(script_hex, 7, cursor)["outputs"], history[7:14])
+
+        self.log.info("Check that spends are reported")
+        target.rescan_utxos()
+        spent = history[3]
+        spend = target.send_self_transfer(from_node=node, utxo_to_spend=target.get_utxo(txid=spent["txid"], vout=spent["vout"]))
+        self.generate(node, 1)
+        history = self.rpc_pages(script_hex, 10)
+        assert_equal(len(history), NUM_OUTPUTS + 1)
+        assert_equal(history[3]["spent"], {"txid": spend["txid"], "vin": 0, "height": node.getblockcount()})
+        assert_equal(history[-1]["txid"], spend["txid"])
+        assert_equal(self.rest_pages(script_hex, 4), history)
+
+        self.log.info("Check invalid parameters")
+        assert_raises_rpc_error(-8, "count must be between 1 and 1000", node.getscripthistory, script_hex, 0)
+        assert_raises_rpc_error(-8, "count must be between 1 and 1000", node.getscripthistory, script_hex, 1001)
+        assert_raises_rpc_error(-8, "Invalid cursor", node.getscripthistory, script_hex, 10, "1-2")
+        assert_raises_rpc_error(-8, "Invalid cursor", node.getscripthistory, script_hex, 10, "a-b-c")
+        assert_raises_rpc_error(-8, "scriptpubkey must be hexadecimal string", node.getscripthistory, "zz")
+        assert_equal(self.rest_history(script_hex, status=400, count=0),
+                     "Output count is invalid or out of acceptable range (1-1000): 0\r\n")
+        assert_equal(self.rest_history(script_hex, status=400, cursor="1-2"), "Invalid cursor: 1-2\r\n")
+        assert_equal(self.rest_history("zz", status=400), "Invalid script: zz\r\n")
+
+        self.log.info("Check that the outputs and spends of a reorganized block are removed from the history")
+        node.invalidateblock(node.getbestblockhash())
+        self.generateblock(node, output=wallet.get_address(), transactions=[], sync_fun=self.no_op)
+        self.wait_until(lambda: node.getindexinfo("scriptindex")["scriptindex"]["best_block_height"] == node.getblockcount())
+        unspent_history = [{k: v for k, v in output.items() if k != "spent"} for output in history[:NUM_OUTPUTS]]
+        assert_equal(self.rpc_pages(script_hex, 10), unspent_history)
+        self.generate(node, 1, sync_fun=self.no_op)
+        history[3]["spent"]["height"] = history[-1]["height"] = node.getblockcount()
+        assert_equal(self.rpc_pages(script_hex, 10), history)
+
+        self.log.info("Check that -scriptindex is incompatible with pruning")
+        self.stop_node(1)
+        self.nodes[1].assert_start_raises_init_error(["-scriptindex", "-prune=550"],
+                                                     "Error: Prune mode is incompatible with -scriptindex.")
+
+
+if __name__ == '__main__':
+    ScriptIndexTest().main()
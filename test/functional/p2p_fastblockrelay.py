@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test block announcements to low-bandwidth peers with -fastblockrelay.
+
+A -fastblockrelay node announces a new block to its low-bandwidth peers as
+soon as the block's proof of work has been checked. Make sure that every peer
+is announced the block exactly once, using its preferred announcement
+method, and that the fast-announced compact block can be requested.
+"""
+
+from test_framework.messages import (
+    MSG_CMPCT_BLOCK,
+    CBlock,
+    CBlockHeader,
+    CInv,
+    from_hex,
+    msg_block,
+    msg_getdata,
+    msg_headers,
+    msg_sendcmpct,
+    msg_sendheaders,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class P2PFastBlockRelayTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [["-fastblockrelay"], []]
+
+    def setup_network(self):
+        self.setup_nodes()
+        # Keep the nodes disconnected, blocks built on node1 are passed to
+        # node0 through a p2p connection.
+
+    def build_block_on_tip(self):
+        blockhash = self.generate(self.nodes[1], 1, sync_fun=self.no_op)[0]
+        block = from_hex(CBlock(), self.nodes[1].getblock(blockhash=blockhash, verbosity=0))
+        block.rehash()
+        return block
+
+    def connect_announcee(self, prefers_headers):
+        node = self.nodes[0]
+        peer = node.add_p2p_connection(P2PInterface())
+        peer.send_and_ping(msg_sendcmpct(announce=False, version=2))
+        if prefers_headers:
+            peer.send_and_ping(msg_sendheaders())
+        # Let the node know that the peer has the current tip.
+        tip = from_hex(CBlockHeader(), node.getblockheader(node.getbestblockhash(), False))
+        peer.send_and_ping(msg_headers([tip]))
+        return peer
+
+    def run_test(self):
+        node = self.nodes[0]
+        # The node only announces blocks once it's out of IBD
+        sender = node.add_p2p_connection(P2PInterface())
+        sender.send_and_ping(msg_block(self.build_block_on_tip()))
+        assert not node.getblockchaininfo()['initialblockdownload']
+
+        headers_peer = self.connect_announcee(prefers_headers=True)
+        inv_peer = self.connect_announcee(prefers_headers=False)
+
+        self.log.info("Check that low-bandwidth peers are announced the block exactly once")
+        headers_before = headers_peer.message_count["headers"]
+        inv_before = inv_peer.message_count["inv"]
+        block = self.build_block_on_tip()
+        sender.send_and_ping(msg_block(block))
+        assert_equal(int(node.getbestblockhash(), 16), block.sha256)
+
+        headers_peer.wait_until(lambda: "headers" in headers_peer.last_message and
+                                headers_peer.last_message["headers"].headers[-1].rehash() == block.sha256)
+        inv_peer.wait_until(lambda: "inv" in inv_peer.last_message and
+                            inv_peer.last_message["inv"].inv[-1].hash == block.sha256)
+        for peer in [headers_peer, inv_peer]:
+            peer.sync_with_ping()
+        assert_equal(headers_peer.message_count["headers"], headers_before + 1)
+        assert_equal(headers_peer.message_count["inv"], 0)
+        assert_equal(inv_peer.message_count["inv"], inv_before + 1)
+
+        self.log.info("Check that the fast-announced compact block is served")
+        headers_peer.send_and_ping(msg_getdata([CInv(MSG_CMPCT_BLOCK, block.sha256)]))
+        headers_peer.wait_until(lambda: "cmpctblock" in headers_peer.last_message)
+        cmpct_header = headers_peer.last_message["cmpctblock"].header_and_shortids.header
+        cmpct_header.calc_sha256()
+        assert_equal(cmpct_header.sha256, block.sha256)
+
+
+if __name__ == '__main__':
+    P2PFastBlockRelayTest().main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test fetching headers from several peers during a low-work headers sync.
+
+With -headerssyncpeers, once the presync with the sync peer has shown that its
+chain has enough work, segments of the chain ahead of the one being
+redownloaded from the sync peer are fetched from other outbound peers, and
+validated in order.
+"""
+
+from test_framework.messages import (
+    CBlockHeader,
+    msg_headers,
+)
+from test_framework.p2p import (
+    P2PInterface,
+    p2p_lock,
+)
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+NUM_HEADERS = 9000
+SEGMENT_SIZE = 2000
+REGTEST_NBITS = 0x207fffff
+
+
+class HeadersServer(P2PInterface):
+    """Serves headers from a fixed chain, optionally holding back getheaders
+    requests until they're released by the test."""
+    def __init__(self, genesis_hash, headers):
+        super().__init__()
+        self.genesis_hash = genesis_hash
+        self.headers = headers
+        self.hold = False
+        self.hold_after_last_headers = False
+        self.held_requests = []
+        self.received_locators = []
+
+    def on_getheaders(self, message):
+        self.received_locators.append(message.locator.vHave[0])
+        if self.hold:
+            self.held_requests.append(message)
+        else:
+            self.serve(message)
+
+    def serve(self, message):
+        start = 0
+        if message.locator.vHave[0] != self.genesis_hash:
+            start = next(i + 1 for i, h in enumerate(self.headers) if h.sha256 == message.locator.vHave[0])
+        self.send_message(msg_headers(self.headers[start:start + SEGMENT_SIZE]))
+        if start + SEGMENT_SIZE >= len(self.headers) and self.hold_after_last_headers:
+            self.hold = True
+
+    def release(self):
+        with p2p_lock:
+            requests, self.held_requests = self.held_requests, []
+            self.hold = False
+        for request in requests:
+            self.serve(request)
+
+
+class HeadersSyncParallelTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        # Require the work of the whole chain, so that it's presynced first
+        self.extra_args = [[f"-minimumchainwork={hex(2 * (NUM_HEADERS + 1))}", "-headerssyncpeers=2", "-checkblockindex=0"]]
+
+    def build_chain(self, genesis):
+        headers = []
+        prev_hash = int(genesis["hash"], 16)
+        target = (REGTEST_NBITS & 0xffffff) << (8 * ((REGTEST_NBITS >> 24) - 3))
+        for i in range(NUM_HEADERS):
+            header = CBlockHeader()
+            header.nVersion = 4
+            header.hashPrevBlock = prev_hash
+            header.hashMerkleRoot = 0
+            header.nTime = genesis["time"] + i + 1
+            header.nBits = REGTEST_NBITS
+            header.nNonce = 0
+            header.rehash()
+            while header.sha256 > target:
+                header.nNonce += 1
+                header.rehash()
+            headers.append(header)
+            prev_hash = header.sha256
+        return headers
+
+    def run_test(self):
+        node = self.nodes[0]
+        genesis = node.getblockheader(node.getbestblockhash())
+        genesis_hash = int(genesis["hash"], 16)
+        headers = self.build_chain(genesis)
+
+        self.log.info("Connect the sync peer and let it presync the whole chain")
+        sync_peer = HeadersServer(genesis_hash, headers)
+        sync_peer.hold = True
+        node.add_outbound_p2p_connection(sync_peer, p2p_idx=0)
+        sync_peer.wait_until(lambda: len(sync_peer.held_requests) == 1)
+        helpers = [node.add_outbound_p2p_connection(HeadersServer(genesis_hash, headers), p2p_idx=i) for i in (1, 2)]
+
+        # Hold back the first redownload request from the sync peer, until
+        # the other peers have served their segments.
+        with node.assert_debug_log(["Received headers segment 1 of headers sync with peer=0",
+                                    "Received headers segment 2 of headers sync with peer=0"]):
+            sync_peer.hold_after_last_headers = True
+            sync_peer.release()
+            sync_peer.wait_until(lambda: len(sync_peer.held_requests) == 1)
+            assert_equal(sync_peer.held_requests[0].locator.vHave[0], genesis_hash)
+            for helper in helpers:
+                helper.wait_until(lambda: len(helper.received_locators) >= 1)
+                helper.sync_with_ping()
+        assert_equal(sorted(helper.received_locators[0] for helper in helpers),
+                     sorted([headers[SEGMENT_SIZE - 1].sha256, headers[2 * SEGMENT_SIZE - 1].sha256]))
+
+        self.log.info("Check that the fetched segments are validated with the sync peer's headers")
+        num_presync_requests = len(sync_peer.received_locators)
+        sync_peer.hold_after_last_headers = False
+        with node.assert_debug_log([f"used prefetched headers up to height={3 * SEGMENT_SIZE}"]):
+            sync_peer.release()
+            self.wait_until(lambda: node.getblockchaininfo()["headers"] == NUM_HEADERS)
+        # The sync peer was asked to continue after the prefetched segments
+        # instead of redownloading them.
+        assert_equal(sync_peer.received_locators[num_presync_requests:num_presync_requests + 2],
+                     [headers[3 * SEGMENT_SIZE - 1].sha256, headers[4 * SEGMENT_SIZE - 1].sha256])
+        assert_equal(node.getbestblockhash(), genesis["hash"])
+        assert_equal(node.getblockheader(headers[-1].hash)["height"], NUM_HEADERS)
+
+
+if __name__ == '__main__':
+    HeadersSyncParallelTest().main()
@@ -146,6 +146,7 @@ BASE_SCRIPTS = [
     'rpc_bind.py --ipv6',
     'rpc_bind.py --nonloopback',
     'p2p_headers_sync_with_minchainwork.py',
+    'p2p_headers_sync_parallel.py',
     'p2p_feefilter.py',
     'feature_csv_activation.py',
     'p2p_sendheaders.py',
@@ -172,6 +173,7 @@ BASE_SCRIPTS = [
     'wallet_labels.py --descriptors',
     'p2p_compactblocks.py',
     'p2p_compactblocks_blocksonly.py',
+    'p2p_fastblockrelay.py',
     'wallet_hd.py --legacy-wallet',
     'wallet_hd.py --descriptors',
     'wallet_blank.py --legacy-wallet',
@@ -299,6 +301,7 @@ BASE_SCRIPTS = [
     'wallet_crosschain.py',
     'mining_basic.py',
     'feature_signet.py',
+    'feature_scriptindex.py',
     'wallet_implicitsegwit.py --legacy-wallet',
     'rpc_named_arguments.py',
     'feature_startupnotify.py',
@@ -369,6 +372,8 @@ BASE_SCRIPTS = [
     'wallet_timelock.py',
     'p2p_node_network_limited.py',
     'p2p_permissions.py',
+    'feature_blockcompression.py',
+    'feature_blockindex_snapshot.py',
     'feature_blocksdir.py',
     'wallet_startup.py',
     'feature_remove_pruned_files_on_startup.py',